@@ -0,0 +1,38 @@
+#version 430
+
+/* compute shader: folds each cell's material and the runtime material offset into its update coefficients. Dispatched over every cell whenever the material glides - Worked as computeUpdateCoefficients() in domain.cpp works them, in double with true divisions, so the coefficients are bit identical */
+
+layout(local_size_x = 256) in;
+
+//Storage Buffers//
+layout(std430, binding = 4) writeonly buffer Coefficients { vec4 coefficients[]; };	//Update coefficients [centre, previous, neighbour, unused] read by fdtd_cs.glsl.
+layout(std430, binding = 5) readonly buffer Material { vec4 material[]; };			//[propagation, damping, summed reflection of wall neighbours, walls the gain offset applies to] - w is -1 for cells never updated.
+
+//Uniforms//
+uniform int numCells;
+uniform vec3 materialOffset;	//Change of [propagation, damping, boundaryGain] since the domain was built.
+
+void main()
+{
+	int i = int(gl_GlobalInvocationID.x);
+	if (i >= numCells)
+		return;
+
+	vec4 m = material[i];
+	if (m.w < 0.0)
+	{
+		coefficients[i] = vec4(0.0);
+		return;
+	}
+
+	//Double, and precise so nothing is fused - Only the final coefficients round//
+	precise double prop = clamp(double(m.x) + double(materialOffset.x), 0.0LF, 0.5LF);
+	precise double damp = max(double(m.y) + double(materialOffset.y), 0.0LF);
+	precise double reflection = double(m.z) + double(m.w) * double(materialOffset.z);
+
+	//Pre-divided by 1 + damping, as the solver expects//
+	precise double centre = (2.0LF - 4.0LF*prop + prop*reflection) / (1.0LF + damp);
+	precise double previous = (damp - 1.0LF) / (1.0LF + damp);
+	precise double neighbour = prop / (1.0LF + damp);
+	coefficients[i] = vec4(float(centre), float(previous), float(neighbour), 0.0);
+}
@@ -0,0 +1,30 @@
+#version 410
+
+/* fragment shader: folds each cell's material and the runtime material offset into its update coefficients. Drawn over the domain sized coefficient texture whenever the material glides - Worked as computeUpdateCoefficients() in domain.cpp works them, in double with true divisions, so the coefficients are bit identical */
+
+out vec4 coefficients;
+
+//Uniforms//
+uniform sampler2D material;		//[propagation, damping, summed reflection of wall neighbours, walls the gain offset applies to] - w is -1 for cells never updated.
+uniform vec3 materialOffset;	//Change of [propagation, damping, boundaryGain] since the domain was built.
+
+void main()
+{
+	vec4 m = texelFetch(material, ivec2(gl_FragCoord.xy), 0);
+	if (m.w < 0.0)
+	{
+		coefficients = vec4(0.0);
+		return;
+	}
+
+	//Double, and precise so nothing is fused - Only the final coefficients round//
+	precise double prop = clamp(double(m.x) + double(materialOffset.x), 0.0LF, 0.5LF);
+	precise double damp = max(double(m.y) + double(materialOffset.y), 0.0LF);
+	precise double reflection = double(m.z) + double(m.w) * double(materialOffset.z);
+
+	//Pre-divided by 1 + damping, as the solver expects//
+	precise double centre = (2.0LF - 4.0LF*prop + prop*reflection) / (1.0LF + damp);
+	precise double previous = (damp - 1.0LF) / (1.0LF + damp);
+	precise double neighbour = prop / (1.0LF + damp);
+	coefficients = vec4(float(centre), float(previous), float(neighbour), 0.0);
+}
@@ -0,0 +1,9 @@
+#version 410
+
+/* vertex shader: single triangle covering the whole viewport, built from the vertex index so no vertex buffer is read */
+
+void main()
+{
+	vec2 pos = vec2((gl_VertexID & 1) * 4 - 1, (gl_VertexID & 2) * 2 - 1);
+	gl_Position = vec4(pos, 0.0, 1.0);
+}
@@ -0,0 +1,66 @@
+#version 430
+
+/* compute shader: field energy metric of the current timestep, reduced in shared memory to one partial sum per work group. Must match computeFieldEnergy() in domain.cpp */
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+//Storage Buffers//
+layout(std430, binding = 0) readonly buffer Pressure { float pressure[]; };			//Two planes - Alternately hold timestep n & n-1.
+layout(std430, binding = 1) readonly buffer CellTypes { uint cellTypes[]; };			//Cell type bits, 4 cells packed per uint.
+layout(std430, binding = 6) writeonly buffer PartialEnergy { float partialEnergy[]; };	//Sum of each work group's cells.
+
+//Cell type bits - Must match domain.h//
+const uint CELL_WALL      = 1u;
+
+//Uniforms//
+uniform ivec2 domainSize;
+uniform int currentPlane;		//Plane holding timestep n.
+
+shared float partial[256];
+
+//Regular interior cell - Walls and the outer ring hold no energy//
+bool isRegular(ivec2 cell)
+{
+	if (cell.x < 1 || cell.y < 1 || cell.x >= domainSize.x - 1 || cell.y >= domainSize.y - 1)
+		return false;
+	int i = cell.y * domainSize.x + cell.x;
+	return ((cellTypes[i >> 2] >> ((i & 3) * 8)) & CELL_WALL) == 0u;
+}
+
+void main()
+{
+	ivec2 cell = ivec2(gl_GlobalInvocationID.xy);
+	int width = domainSize.x;
+	int planeSize = domainSize.x * domainSize.y;
+	int current = currentPlane * planeSize;
+	int previous = (1 - currentPlane) * planeSize;
+
+	float energy = 0.0;
+	if (isRegular(cell))
+	{
+		int i = cell.y * width + cell.x;
+		float p = pressure[current + i];
+		float velocity = p - pressure[previous + i];
+		energy = velocity * velocity;
+
+		//Each pair of regular neighbours counted once - Right and up//
+		if (isRegular(cell + ivec2(1, 0)))
+			energy += (pressure[current + i + 1] - p) * (pressure[current + i + 1] - p);
+		if (isRegular(cell + ivec2(0, 1)))
+			energy += (pressure[current + i + width] - p) * (pressure[current + i + width] - p);
+	}
+
+	//Tree reduction over the work group//
+	uint local = gl_LocalInvocationIndex;
+	partial[local] = energy;
+	barrier();
+	for (uint stride = 128u; stride > 0u; stride >>= 1)
+	{
+		if (local < stride)
+			partial[local] += partial[local + stride];
+		barrier();
+	}
+
+	if (local == 0u)
+		partialEnergy[gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x] = partial[0];
+}
@@ -0,0 +1,129 @@
+#version 410
+
+/* fragment shader: FDTD solver running on all the fragments of the texture [grid points]. Also saves audio, rendered into a texel of the audio row via its own FBO. Result is rendered to the taxture, via FBO. Used below OpenGL 4.2, where fbo_fs.glsl's image store is unavailable */
+
+//Texture coodinates of current and neighbouring fragments//
+in vec2 tex_c;
+in vec2 tex_l;
+in vec2 tex_u;
+in vec2 tex_r;
+in vec2 tex_d;
+
+out vec4 frag_color;
+
+//States that define which quads to update//
+const int state0 = 0; // draw right quad 
+const int state1 = 1; // read audio from left quad [cos right might not be ready yet]
+const int state2 = 2; // draw left quad 
+const int state3 = 3; // read audio from right quad [cos left might not be ready yet]
+
+//Cell type bits - Must match domain.h//
+const uint CELL_WALL      = 1u;
+
+//Uniforms//
+uniform sampler2D inOutTexture;		//Pressure [r] and previous pressure [g] of both quads.
+uniform usampler2D cellTypes;		//Cell type bits of the domain - Shared by both quads.
+uniform sampler2D coefficients;		//Update coefficients [centre, previous, neighbour] of the domain - Material and wall reflections folded in.
+uniform ivec2 listenerCell;
+uniform int state;
+uniform vec2 excitationPosition;
+uniform float excitationMagnitude;
+uniform vec2 listenerFragCoord[4];	//Position of listener point in both model quads.
+uniform vec2 deltaCoord;			//Width + height of each fragment.
+
+
+//Transmission of a cell - 1 regular, 0 wall. Clamped to the domain, as edge cells have neighbours outside it//
+float getTransmission(ivec2 cell)
+{
+	uint cellType = texelFetch(cellTypes, clamp(cell, ivec2(0), textureSize(cellTypes, 0) - 1), 0).r;
+	return (cellType & CELL_WALL) != 0u ? 0.0 : 1.0;
+}
+
+//Calculates new value of air pressure for current fragment//
+vec4 computeFDTD()
+{
+	vec4 frag_color  = texture(inOutTexture, tex_c);
+	float p      = frag_color.r; 	//Current pressure point.
+	float p_prev = frag_color.g; 	//Previous pressure point
+	
+	//Cell of this fragment - Both quads map onto the same domain//
+	ivec2 cell = ivec2(gl_FragCoord.xy);
+	cell.x = cell.x % textureSize(cellTypes, 0).x;
+	
+	//Neighbours [pl_n, pu_n, pr_n, pd_n] need current pressure and if boundary.
+	vec4 p_neigh;
+	vec4 b_neigh;	//Checks all points if boundary. If they are, times by 0 and therefore preasure value not taken into account - Their reflection is in the centre coefficient.
+	
+	//Left fragment//
+	p_neigh.r = texture(inOutTexture, tex_l).r;
+	b_neigh.r = getTransmission(cell + ivec2(-1, 0));
+	
+	//Up fragment//
+	p_neigh.g = texture(inOutTexture, tex_u).r;
+	b_neigh.g = getTransmission(cell + ivec2(0, 1));
+	
+	//Right fragment//
+	p_neigh.b = texture(inOutTexture, tex_r).r;
+	b_neigh.b = getTransmission(cell + ivec2(1, 0));
+
+	//Down fragment//
+	p_neigh.a = texture(inOutTexture, tex_d).r;
+	b_neigh.a = getTransmission(cell + ivec2(0, -1));
+	
+	//Parallel computation of pLRUD//
+	vec4 pLRUD = p_neigh*b_neigh;
+	
+	// assemble equation - Coefficients are pre-divided by 1 + damping
+	vec3 c = texelFetch(coefficients, cell, 0).rgb;
+	precise float p_next = c.r*p + c.g*p_prev;	//Precise, so no multiply and add is fused and the step rounds as the CPU kernels round it.
+	p_next += ((pLRUD.x+pLRUD.z)+(pLRUD.y+pLRUD.w)) * c.b;	//Mirror images paired first, as the CPU kernels sum them.
+	
+	//Old excitation point method//
+	//Add excitation if this is excitation point [piece of cake]
+	//int is_excitation = int(frag_color.a);
+	//p_next += excitationMagnitude * is_excitation;
+	
+	//Low pass filter?//
+	//p_next = (p_next+p_prev)/2.0;
+	
+	//Change excitation point//
+	vec2 posDiff = vec2(tex_c.x - excitationPosition.x, tex_c.y - excitationPosition.y);
+	vec2 absDiff = vec2(abs(posDiff.x), abs(posDiff.y));
+	if(absDiff.x<deltaCoord.x/2 && absDiff.y<deltaCoord.y/2)
+		p_next += excitationMagnitude;
+
+		
+	//          p_n+1    p_n
+	return vec4(p_next,  p, 0, 0);	//New pressure point, use current for previous pressure - Only RG is stored.
+}
+
+
+//Writes audio from listener point - The viewport covers only the step's texel of the audio row//
+vec4 saveAudio()
+{
+	// sample chosen grid point
+	int readState = 1-(state/2); // index of the state we are reading from
+	vec2 audioCoord = listenerFragCoord[readState]; 
+	vec4 audioFrag = texture(inOutTexture, audioCoord); // get the audio info from the listener
+	
+	// silence boundaries, using cell type
+	float audio = audioFrag.r * getTransmission(listenerCell);
+	return vec4(audio, 0, 0, 0);
+}
+
+
+
+
+void main() {
+
+	if( (state == state0) || (state == state2) )
+	{	
+		//Calculate FDTD on fragment//
+		frag_color = computeFDTD();
+	}
+	else
+	{
+		//Save audio sample to buffer//
+		frag_color = saveAudio();
+	}
+};
@@ -6,7 +6,7 @@ This code is distributed under the 2-Clause BSD License
 Copyright 2017 Victor Zappi
 */
 
-/* simple vertex shader to build the 2 flat quadrants where to place the FDTD texture and the third one that will contain the audio */
+/* simple vertex shader to build the 2 flat quadrants where to place the FDTD texture */
 
 in vec4 pos_and_texc;
 in vec4 texl_and_texu;
@@ -0,0 +1,126 @@
+#version 430
+
+/* compute shader: FDTD solver running on every grid point held in storage buffers. The listener point writes its own sample straight into the audio buffer, so no separate audio pass is needed */
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+//Storage Buffers//
+layout(std430, binding = 0) buffer Pressure { float pressure[]; };						//Two planes - Alternately hold timestep n & n-1.
+layout(std430, binding = 1) readonly buffer CellTypes { uint cellTypes[]; };			//Cell type bits, 4 cells packed per uint.
+layout(std430, binding = 2) readonly buffer Excitation { float excitationMagnitude[]; };	//Excitation of every step in the block.
+layout(std430, binding = 3) writeonly buffer Audio { float audio[]; };					//Listener sample of every step in the block.
+layout(std430, binding = 4) readonly buffer Coefficients { vec4 coefficients[]; };		//Update coefficients [centre, previous, neighbour, unused] - Material and wall reflections folded in.
+layout(std430, binding = 7) buffer TileFlags { uint tileFlags[]; };					//TILE_ bits of each tile, replaced by this step's - Active tiles only.
+layout(std430, binding = 8) readonly buffer TileList { uint tileList[]; };				//Tiles scheduled by tiles_cs.glsl, one per work group - Active tiles only.
+
+//Cell type bits - Must match domain.h//
+const uint CELL_WALL      = 1u;
+
+//Tile flags - Must match tiles_cs.glsl//
+const uint TILE_LIVE       = 1u;		//Some cell is above the rest level - Stepped again next step.
+const uint TILE_LEFT_EDGE  = 2u;		//Pressure above rest on the edge facing that neighbour - Wakes it next step.
+const uint TILE_UP_EDGE    = 4u;
+const uint TILE_RIGHT_EDGE = 8u;
+const uint TILE_DOWN_EDGE  = 16u;
+const uint TILE_RETIRING   = 32u;		//Went quiet last step with its newest plane zeroed - Stepped once more to zero the other.
+const float REST_LEVEL     = 1e-12;		//Must match ACTIVE_TILE_REST_LEVEL.
+
+//Uniforms//
+uniform ivec2 domainSize;
+uniform int currentPlane;		//Plane holding timestep n - The other is overwritten with n+1.
+uniform int step;				//Index of this step within the block.
+uniform ivec2 excitationCell;
+uniform ivec2 listenerCell;
+uniform bool isTiled;			//Work groups step the tiles in tileList instead of covering the grid.
+uniform int numTilesX;
+
+shared uint groupFlags;
+shared uint lastFlags;
+
+//Transmission of a cell - 1 regular, 0 wall//
+float getTransmission(int i)
+{
+	uint cellType = (cellTypes[i >> 2] >> ((i & 3) * 8)) & 0xFFu;
+	return (cellType & CELL_WALL) != 0u ? 0.0 : 1.0;
+}
+
+void main()
+{
+	uint tile = isTiled ? tileList[gl_WorkGroupID.x] : gl_WorkGroupID.y * uint(numTilesX) + gl_WorkGroupID.x;
+	ivec2 tileOrigin = ivec2(tile % uint(numTilesX), tile / uint(numTilesX)) * ivec2(gl_WorkGroupSize.xy);
+	ivec2 local = ivec2(gl_LocalInvocationID.xy);
+	ivec2 cell = tileOrigin + local;
+
+	if (gl_LocalInvocationIndex == 0u)
+	{
+		groupFlags = 0u;
+		lastFlags = isTiled ? tileFlags[tile] : 0u;
+	}
+	barrier();
+
+	//Only interior points are updated - The outer ring is always boundary. No return, as every invocation meets the barriers//
+	bool isInterior = cell.x >= 1 && cell.y >= 1 && cell.x < domainSize.x - 1 && cell.y < domainSize.y - 1;
+
+	int width = domainSize.x;
+	int planeSize = domainSize.x * domainSize.y;
+	int i = cell.y * width + cell.x;
+	int current = currentPlane * planeSize + i;
+	int previous = (1 - currentPlane) * planeSize + i;
+
+	precise float p_next = 0.0;	//Precise, so no multiply and add is fused and the step rounds as the CPU kernels round it.
+	if (isInterior)
+	{
+		float p      = pressure[current];	//Current pressure point.
+		float p_prev = pressure[previous];	//Previous pressure point.
+
+		//Neighbours [left, up, right, down]//
+		vec4 p_neigh = vec4(pressure[current - 1], pressure[current + width], pressure[current + 1], pressure[current - width]);
+		vec4 b_neigh = vec4(getTransmission(i - 1), getTransmission(i + width), getTransmission(i + 1), getTransmission(i - width));
+
+		//Wall neighbours pass on nothing - Their reflection is in the centre coefficient//
+		vec4 pLRUD = p_neigh*b_neigh;
+
+		// assemble equation - Coefficients are pre-divided by 1 + damping
+		vec4 c = coefficients[i];
+		p_next = c.x*p + c.y*p_prev;
+		p_next += ((pLRUD.x+pLRUD.z)+(pLRUD.y+pLRUD.w)) * c.z;	//Mirror images paired first, as the CPU kernels sum them.
+
+		if (cell == excitationCell)
+			p_next += excitationMagnitude[step];
+
+		//Tile bookkeeping - A tile holding anything above rest in either timestep stays live, edges above rest wake neighbours//
+		uint flags = 0u;
+		if (abs(p_next) >= REST_LEVEL || abs(p) >= REST_LEVEL)
+			flags |= TILE_LIVE;
+		if (abs(p_next) >= REST_LEVEL)
+		{
+			if (local.x == 0)
+				flags |= TILE_LEFT_EDGE;
+			if (local.y == int(gl_WorkGroupSize.y) - 1)
+				flags |= TILE_UP_EDGE;
+			if (local.x == int(gl_WorkGroupSize.x) - 1)
+				flags |= TILE_RIGHT_EDGE;
+			if (local.y == 0)
+				flags |= TILE_DOWN_EDGE;
+		}
+		if (flags != 0u)
+			atomicOr(groupFlags, flags);
+	}
+	barrier();
+
+	//A quiet tile is zeroed over two steps, one plane each, then skipped until a neighbour wakes it//
+	bool isQuiet = isTiled && (groupFlags & TILE_LIVE) == 0u;
+	if (gl_LocalInvocationIndex == 0u && isTiled)
+		tileFlags[tile] = !isQuiet ? groupFlags : ((lastFlags & TILE_LIVE) != 0u ? TILE_RETIRING : 0u);
+
+	if (!isInterior)
+		return;
+	if (isQuiet)
+		p_next = 0.0;
+
+	pressure[previous] = p_next;	//Previous timestep is no longer needed - Overwritten with the next.
+
+	//Save audio sample - Silence boundaries, using b//
+	if (cell == listenerCell)
+		audio[step] = p_next * getTransmission(i);
+}
@@ -0,0 +1,57 @@
+#version 430
+
+/* fragment shader: FDTD solver updating in place with image load/store. Pressure is a single pair of planes - Neighbours are read from the current plane and the next pressure overwrites the previous one, which only its own cell ever reads. The listener point writes its own sample into the audio image, so no audio pass is needed */
+
+//Cell type bits - Must match domain.h//
+const uint CELL_WALL      = 1u;
+
+//Images//
+layout(r32f, binding = 0) readonly uniform image2D current;		//Pressure of timestep n.
+layout(r32f, binding = 1) uniform image2D previous;				//Pressure of timestep n-1, overwritten with n+1.
+layout(r32f, binding = 2) writeonly uniform image2D audio;		//Listener sample of every step in the chunk.
+
+//Uniforms//
+uniform usampler2D cellTypes;		//Cell type bits of every point.
+uniform sampler2D coefficients;		//Update coefficients [centre, previous, neighbour] - Material and wall reflections folded in.
+uniform ivec2 excitationCell;
+uniform float excitationMagnitude;
+uniform ivec2 listenerCell;
+uniform int audioIndex;				//Step of the chunk, so texel of audio written by the listener.
+
+//Transmission of a cell - 1 regular, 0 wall or outside the domain//
+float getTransmission(ivec2 cell)
+{
+	if (any(lessThan(cell, ivec2(0))) || any(greaterThanEqual(cell, textureSize(cellTypes, 0))))
+		return 0.0;
+	uint cellType = texelFetch(cellTypes, cell, 0).r;
+	return (cellType & CELL_WALL) != 0u ? 0.0 : 1.0;
+}
+
+void main()
+{
+	ivec2 cell = ivec2(gl_FragCoord.xy);
+
+	float p      = imageLoad(current, cell).r;		//Current pressure point.
+	float p_prev = imageLoad(previous, cell).r;		//Previous pressure point.
+
+	//Neighbours [left, up, right, down] - Images read 0 outside the domain//
+	const ivec2 offsets[4] = ivec2[4](ivec2(-1, 0), ivec2(0, 1), ivec2(1, 0), ivec2(0, -1));
+	vec4 p_neigh;
+	for (int k = 0; k != 4; ++k)
+		p_neigh[k] = imageLoad(current, cell + offsets[k]).r * getTransmission(cell + offsets[k]);
+	float pLRUD = (p_neigh.x+p_neigh.z)+(p_neigh.y+p_neigh.w);	//Mirror images paired first, as the CPU kernels sum them.
+
+	// assemble equation - Coefficients are pre-divided by 1 + damping
+	vec3 c = texelFetch(coefficients, cell, 0).rgb;
+	precise float p_next = c.r*p + c.g*p_prev;	//Precise, so no multiply and add is fused and the step rounds as the CPU kernels round it.
+	p_next += pLRUD * c.b;
+
+	if (cell == excitationCell)
+		p_next += excitationMagnitude;
+
+	imageStore(previous, cell, vec4(p_next));	//Previous timestep is no longer needed - Overwritten with the next.
+
+	//Silence boundaries, as the fbo shader does//
+	if (cell == listenerCell)
+		imageStore(audio, ivec2(audioIndex, 0), vec4(p_next * getTransmission(cell)));
+}
@@ -51,9 +51,9 @@ vec4 get_color_from_pressure(float p) {
 void main () {
 	frag_color = texture(inputTexture, tex_c); // read current RGBA values
 	
-	// decode type
+	// decode type - b holds transmission, a the cell type bits [CELL_EXCITATION is 4]
 	float boundary = 1-frag_color.b;
-	float excitation = frag_color.a;
+	float excitation = (uint(frag_color.a) & 4u) != 0u ? 1 : 0;
 	
 	// color cells according to type
 	
@@ -0,0 +1,53 @@
+#version 410
+
+/* fragment shader: FDTD solver over one tile of the domain. Each tile is its own texture with a one cell halo holding its neighbours' edges, refreshed by copies between steps. Drawn over the tile's interior only, so the halo is never written */
+
+out vec4 frag_color;
+
+//Cell type bits - Must match domain.h//
+const uint CELL_WALL      = 1u;
+
+//Uniforms//
+uniform sampler2D pressure;			//Pressure [r] and previous pressure [g] of the tile, halo included.
+uniform usampler2D cellTypes;		//Cell type bits of the tile, halo included - Outside the domain is wall.
+uniform sampler2D coefficients;		//Update coefficients [centre, previous, neighbour] of the tile - Material and wall reflections folded in.
+uniform ivec2 excitationTexel;		//Texel of the excitation point in this tile - Outside it when another tile holds the point.
+uniform float excitationMagnitude;
+
+//Transmission of a texel - 1 regular, 0 wall//
+float getTransmission(ivec2 texel)
+{
+	uint cellType = texelFetch(cellTypes, texel, 0).r;
+	return (cellType & CELL_WALL) != 0u ? 0.0 : 1.0;
+}
+
+void main()
+{
+	ivec2 texel = ivec2(gl_FragCoord.xy);	//The viewport starts past the halo, so fragments land on interior texels.
+
+	vec2 centre = texelFetch(pressure, texel, 0).rg;
+	float p      = centre.r;	//Current pressure point.
+	float p_prev = centre.g;	//Previous pressure point.
+
+	//Neighbours [left, up, right, down] - Edge cells read the halo//
+	const ivec2 offsets[4] = ivec2[4](ivec2(-1, 0), ivec2(0, 1), ivec2(1, 0), ivec2(0, -1));
+	vec4 p_neigh;
+	vec4 b_neigh;	//Wall neighbours pass on nothing - Their reflection is in the centre coefficient.
+	for (int k = 0; k != 4; ++k)
+	{
+		p_neigh[k] = texelFetch(pressure, texel + offsets[k], 0).r;
+		b_neigh[k] = getTransmission(texel + offsets[k]);
+	}
+	vec4 pLRUD = p_neigh*b_neigh;
+
+	// assemble equation - Coefficients are pre-divided by 1 + damping
+	vec3 c = texelFetch(coefficients, texel, 0).rgb;
+	precise float p_next = c.r*p + c.g*p_prev;	//Precise, so no multiply and add is fused and the step rounds as the CPU kernels round it.
+	p_next += ((pLRUD.x+pLRUD.z)+(pLRUD.y+pLRUD.w)) * c.b;	//Mirror images paired first, as the CPU kernels sum them.
+
+	if (texel == excitationTexel)
+		p_next += excitationMagnitude;
+
+	//          p_n+1    p_n
+	frag_color = vec4(p_next,  p, 0, 0);	//New pressure point, use current for previous pressure - Only RG is stored.
+}
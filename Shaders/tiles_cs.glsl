@@ -0,0 +1,45 @@
+#version 430
+
+/* compute shader: schedules the tiles fdtd_cs.glsl steps next. Live and retiring tiles, plus quiet tiles a neighbour's edge above rest or the excitation reaches, are appended to the tile list, counting the work groups of the indirect dispatch */
+
+layout(local_size_x = 64) in;
+
+//Storage Buffers//
+layout(std430, binding = 2) readonly buffer Excitation { float excitationMagnitude[]; };	//Excitation of every step in the block.
+layout(std430, binding = 7) readonly buffer TileFlags { uint tileFlags[]; };			//TILE_ bits each tile was left with by the last step.
+layout(std430, binding = 8) writeonly buffer TileList { uint tileList[]; };				//Tiles to step, one per work group.
+layout(std430, binding = 9) buffer Dispatch { uint numGroups[3]; };						//glDispatchComputeIndirect() arguments - x is cleared before each schedule.
+
+//Tile flags - Must match fdtd_cs.glsl//
+const uint TILE_LIVE       = 1u;
+const uint TILE_LEFT_EDGE  = 2u;
+const uint TILE_UP_EDGE    = 4u;
+const uint TILE_RIGHT_EDGE = 8u;
+const uint TILE_DOWN_EDGE  = 16u;
+const uint TILE_RETIRING   = 32u;
+
+//Uniforms//
+uniform ivec2 numTiles;
+uniform int step;				//Index of the step being scheduled within the block.
+uniform int excitationTile;
+
+void main()
+{
+	int tile = int(gl_GlobalInvocationID.x);
+	if (tile >= numTiles.x * numTiles.y)
+		return;
+
+	int tileX = tile % numTiles.x;
+	int tileY = tile / numTiles.x;
+
+	//Neighbours' edges facing this tile - [left, up, right, down]//
+	bool isScheduled = (tileFlags[tile] & (TILE_LIVE | TILE_RETIRING)) != 0u;
+	isScheduled = isScheduled || (tileX > 0 && (tileFlags[tile - 1] & TILE_RIGHT_EDGE) != 0u);
+	isScheduled = isScheduled || (tileY + 1 < numTiles.y && (tileFlags[tile + numTiles.x] & TILE_DOWN_EDGE) != 0u);
+	isScheduled = isScheduled || (tileX + 1 < numTiles.x && (tileFlags[tile + 1] & TILE_LEFT_EDGE) != 0u);
+	isScheduled = isScheduled || (tileY > 0 && (tileFlags[tile - numTiles.x] & TILE_UP_EDGE) != 0u);
+	isScheduled = isScheduled || (tile == excitationTile && excitationMagnitude[step] != 0.0);
+
+	if (isScheduled)
+		tileList[atomicAdd(numGroups[0], 1u)] = uint(tile);
+}
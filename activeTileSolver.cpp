@@ -0,0 +1,190 @@
+#include "activeTileSolver.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "profiler.h"
+#include "tracer.h"
+
+ActiveTileSolver::ActiveTileSolver(const SolverSettings& aSettings) : SIMDSolver(aSettings)
+{
+	numTilesX = (width + ACTIVE_TILE_SIZE - 1) / ACTIVE_TILE_SIZE;
+	numTilesY = (height + ACTIVE_TILE_SIZE - 1) / ACTIVE_TILE_SIZE;
+
+	//The model starts at rest//
+	isActive.assign(numTilesX * numTilesY, 0);
+	isScheduled.assign(numTilesX * numTilesY, 0);
+}
+
+const char* ActiveTileSolver::getName() const
+{
+	return "CPU active tiles";
+}
+
+void ActiveTileSolver::getTileBounds(int tile, int& xBegin, int& xEnd, int& yBegin, int& yEnd) const
+{
+	xBegin = (tile % numTilesX) * ACTIVE_TILE_SIZE;
+	yBegin = (tile / numTilesX) * ACTIVE_TILE_SIZE;
+	xEnd = std::min(xBegin + ACTIVE_TILE_SIZE, width);
+	yEnd = std::min(yBegin + ACTIVE_TILE_SIZE, height);
+}
+
+bool ActiveTileSolver::isColumnAboveRest(const float* plane, int x, int yBegin, int yEnd) const
+{
+	for (int y = yBegin; y != yEnd; ++y)
+	{
+		if (std::fabs(plane[y * width + x]) >= ACTIVE_TILE_REST_LEVEL)
+			return true;
+	}
+	return false;
+}
+
+bool ActiveTileSolver::isRowAboveRest(const float* plane, int y, int xBegin, int xEnd) const
+{
+	for (int x = xBegin; x != xEnd; ++x)
+	{
+		if (std::fabs(plane[y * width + x]) >= ACTIVE_TILE_REST_LEVEL)
+			return true;
+	}
+	return false;
+}
+
+void ActiveTileSolver::scheduleTiles(const float* current)
+{
+	for (int tile = 0; tile != numTilesX * numTilesY; ++tile)
+	{
+		bool isReached = isActive[tile] != 0;
+		if (!isReached)
+		{
+			//Only cells facing an active neighbour can be reached this step - The rest of the tile stays zero//
+			int tileX = tile % numTilesX;
+			int tileY = tile / numTilesX;
+			int xBegin, xEnd, yBegin, yEnd;
+			getTileBounds(tile, xBegin, xEnd, yBegin, yEnd);
+			if (tileX > 0 && isActive[tile - 1])
+				isReached = isColumnAboveRest(current, xBegin - 1, yBegin, yEnd);
+			if (!isReached && tileX + 1 < numTilesX && isActive[tile + 1])
+				isReached = isColumnAboveRest(current, xEnd, yBegin, yEnd);
+			if (!isReached && tileY > 0 && isActive[tile - numTilesX])
+				isReached = isRowAboveRest(current, yBegin - 1, xBegin, xEnd);
+			if (!isReached && tileY + 1 < numTilesY && isActive[tile + numTilesX])
+				isReached = isRowAboveRest(current, yEnd, xBegin, xEnd);
+		}
+		isScheduled[tile] = isReached;
+	}
+}
+
+void ActiveTileSolver::computeTiles(const float* current, float* previous)
+{
+	for (int tileY = 0; tileY != numTilesY; ++tileY)
+	{
+		int yBegin = std::max(tileY * ACTIVE_TILE_SIZE, 1);
+		int yEnd = std::min((tileY + 1) * ACTIVE_TILE_SIZE, height - 1);
+		if (yBegin >= yEnd)
+			continue;
+
+		const uint8_t* rowScheduled = &isScheduled[tileY * numTilesX];
+		int tileX = 0;
+		while (tileX != numTilesX)
+		{
+			if (!rowScheduled[tileX])
+			{
+				++tileX;
+				continue;
+			}
+
+			//Run of scheduled tiles//
+			int runBegin = tileX;
+			while (tileX != numTilesX && rowScheduled[tileX])
+				isActive[tileY * numTilesX + tileX++] = 1;
+
+			int xBegin = std::max(runBegin * ACTIVE_TILE_SIZE, 1);
+			int xEnd = std::min(tileX * ACTIVE_TILE_SIZE, width - 1);
+			if (xBegin < xEnd)
+				computeRect(current, previous, yBegin, yEnd, xBegin, xEnd);
+		}
+	}
+}
+
+void ActiveTileSolver::retireTiles()
+{
+	TRACE_SCOPE("retire tiles");
+
+	for (int tile = 0; tile != numTilesX * numTilesY; ++tile)
+	{
+		if (!isActive[tile])
+			continue;
+
+		int xBegin, xEnd, yBegin, yEnd;
+		getTileBounds(tile, xBegin, xEnd, yBegin, yEnd);
+		bool isQuiet = true;
+		for (int plane = 0; plane != 2 && isQuiet; ++plane)
+		{
+			for (int y = yBegin; y != yEnd && isQuiet; ++y)
+			{
+				for (int x = xBegin; x != xEnd && isQuiet; ++x)
+					isQuiet = std::fabs(pressure[plane][y * width + x]) < ACTIVE_TILE_REST_LEVEL;
+			}
+		}
+		if (!isQuiet)
+			continue;
+
+		for (int plane = 0; plane != 2; ++plane)
+		{
+			for (int y = yBegin; y != yEnd; ++y)
+				std::fill(&pressure[plane][y * width + xBegin], &pressure[plane][y * width + xBegin] + (xEnd - xBegin), 0.0f);
+		}
+		isActive[tile] = 0;
+	}
+}
+
+void ActiveTileSolver::process(const float* excitation, float* output, int numSamples)
+{
+	StageTimer simulateStageTimer;
+	TRACE_SCOPE("simulate");
+
+	int n = 0;
+	while (n != numSamples)
+	{
+		int segmentEnd = n + rampMaterial(numSamples - n);
+		for (; n != segmentEnd; ++n)
+		{
+			float* current = &pressure[currentPlane][0];
+			float* next = &pressure[1 - currentPlane][0];
+
+			scheduleTiles(current);
+			computeTiles(current, next);
+
+			finishStep(next, n, excitation[n], output[n]);
+			if (excitation[n] != 0.0f)
+			{
+				//A probe between cells may straddle tiles//
+				CellProbe probe = getExcitationProbe(n);
+				for (int k = 0; k != 4; ++k)
+				{
+					if (probe.weight[k] != 0.0f)
+						isActive[((probe.index[k] / width) / ACTIVE_TILE_SIZE) * numTilesX + (probe.index[k] % width) / ACTIVE_TILE_SIZE] = 1;
+				}
+			}
+
+			currentPlane = 1 - currentPlane;
+
+			if (--stepsUntilRetire == 0)
+			{
+				retireTiles();
+				stepsUntilRetire = ACTIVE_TILE_RETIRE_INTERVAL;
+			}
+		}
+	}
+	endPaths(numSamples);
+
+	profiler.recordCPU(STAGE_SIMULATE, simulateStageTimer.elapsed());
+}
+
+void ActiveTileSolver::setField(const float* field)
+{
+	CPUSolver::setField(field);
+
+	//Anything may be nonzero now - Quiet tiles retire at the next scan//
+	std::fill(isActive.begin(), isActive.end(), 1);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+
+#include "simdSolver.h"
+
+///////////
+//DEFINES//
+///////////
+
+#define ACTIVE_TILE_SIZE				16		//Cells per side of a tile - The same as COMPUTE_LOCAL_SIZE, whose work groups are gl-compute's tiles.
+#define ACTIVE_TILE_REST_LEVEL			1e-12f	//Pressure a neighbour's edge must reach to wake a tile, and every cell must stay under to retire it - Must match fdtd_cs.glsl.
+#define ACTIVE_TILE_RETIRE_INTERVAL		64		//Steps between scans retiring quiet tiles.
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//ActiveTileSolver - SIMDSolver stepping only the tiles a disturbance has reached. A strike  //
+//spreads at most one cell per step, so an inactive tile is woken once a neighbouring tile's //
+//facing edge rises above ACTIVE_TILE_REST_LEVEL. The scheme smears a vanishing tail ahead   //
+//of the wavefront at that speed, which waking on any nonzero value would chase across the  //
+//whole grid. Tiles that decay under the rest level are zeroed and retired again. Scheduled //
+//tiles next to each other in a row of tiles are stepped as one span, so a fully active grid//
+//costs about what SIMDSolver does.                                                          //
+///////////////////////////////////////////////////////////////////////////////////////////////
+class ActiveTileSolver : public SIMDSolver {
+private:
+	int numTilesX;
+	int numTilesY;
+	std::vector<uint8_t> isActive;		//Tile may hold nonzero pressure - Inactive tiles are exactly zero in both planes.
+	std::vector<uint8_t> isScheduled;	//Tile is computed this step.
+	int stepsUntilRetire = ACTIVE_TILE_RETIRE_INTERVAL;
+
+	//Cells [xBegin, xEnd) and rows [yBegin, yEnd) of a tile, clipped to the grid//
+	void getTileBounds(int tile, int& xBegin, int& xEnd, int& yBegin, int& yEnd) const;
+
+	bool isColumnAboveRest(const float* plane, int x, int yBegin, int yEnd) const;
+	bool isRowAboveRest(const float* plane, int y, int xBegin, int xEnd) const;
+
+	//Schedule active tiles and the inactive tiles a neighbour's edge spills into this step//
+	void scheduleTiles(const float* current);
+
+	//Compute scheduled tiles, a run of neighbouring tiles in a row at a time//
+	void computeTiles(const float* current, float* previous);
+
+	//Zero and deactivate tiles whose cells are all under ACTIVE_TILE_REST_LEVEL in both planes//
+	void retireTiles();
+
+public:
+	ActiveTileSolver(const SolverSettings& aSettings);
+
+	const char* getName() const;
+	void process(const float* excitation, float* output, int numSamples);
+	void setField(const float* field);
+};
@@ -0,0 +1,39 @@
+#include "audioStream.h"
+
+#include "tracer.h"
+
+AudioStream::AudioStream(RingBuffer<sf::Int16>& aRingBuffer, unsigned int aSampleRate) : ringBuffer(aRingBuffer), chunk(AUDIO_CHUNK_SIZE), underrunCount(0)
+{
+	initialize(1, aSampleRate);		//Mono stream.
+}
+
+bool AudioStream::onGetData(Chunk& data)
+{
+	TRACE_THREAD_NAME("Audio");
+	TRACE_SCOPE("audio-delivery");
+
+	int popped = ringBuffer.pop(&chunk[0], AUDIO_CHUNK_SIZE);
+
+	//Pad with silence if the simulation has not kept up//
+	if (popped != AUDIO_CHUNK_SIZE)
+	{
+		for (int i = popped; i != AUDIO_CHUNK_SIZE; ++i)
+			chunk[i] = 0;
+		++underrunCount;
+	}
+
+	data.samples = &chunk[0];
+	data.sampleCount = AUDIO_CHUNK_SIZE;
+	return true;	//Keep streaming - Stopped explicitly once the simulation finishes.
+}
+
+void AudioStream::onSeek(sf::Time timeOffset)
+{
+	//Live stream - Nothing to seek//
+	(void)timeOffset;
+}
+
+int AudioStream::getUnderrunCount() const
+{
+	return underrunCount;
+}
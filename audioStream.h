@@ -0,0 +1,30 @@
+#pragma once
+
+#include <SFML/Audio.hpp>
+#include <atomic>
+#include <vector>
+
+#include "ringBuffer.h"
+
+#define AUDIO_CHUNK_SIZE	1024	//Samples handed to SFML per request - Large enough that its streaming thread never starves.
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//AudioStream - The audio thread. SFML calls onGetData from its own streaming thread,   //
+//which drains the blocks the simulation thread pushed into the ring buffer. If the     //
+//simulation falls behind the gap is filled with silence rather than stalling playback. //
+//////////////////////////////////////////////////////////////////////////////////////////
+class AudioStream : public sf::SoundStream {
+private:
+	RingBuffer<sf::Int16>& ringBuffer;
+	std::vector<sf::Int16> chunk;
+	std::atomic<int> underrunCount;		//Number of chunks padded with silence.
+
+protected:
+	bool onGetData(Chunk& data);
+	void onSeek(sf::Time timeOffset);
+
+public:
+	AudioStream(RingBuffer<sf::Int16>& aRingBuffer, unsigned int aSampleRate);
+
+	int getUnderrunCount() const;
+};
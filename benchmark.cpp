@@ -0,0 +1,500 @@
+/* benchmark: sweeps every available solver backend over grid sizes and audio buffer sizes, reporting throughput as a table and machine readable CSV. Optionally compares against a stored baseline CSV and flags regressions */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+#include <glad\glad.h>
+#include <GLFW\glfw3.h>
+
+#include "solverFactory.h"
+#include "profiler.h"
+#include "stringBankSolver.h"
+#include "oversampledSolver.h"
+
+///////////
+//DEFINES//
+///////////
+
+#define SAMPLE_RATE				44100	//Output rate the real-time factor is measured against.
+#define PROBE_SAMPLES			32		//Steps timed to estimate whether a configuration is worth running.
+#define MAX_BLOCK_SECONDS		2.0		//Configurations whose single buffer would take longer are skipped.
+#define EXCITATION_PERIOD		1000	//Steps between strikes - Keeps the field from decaying towards denormals.
+
+//Measured throughput of one backend, grid and buffer size//
+struct BenchmarkResult {
+	std::string backend;
+	std::string precision;
+	int domainSize;
+	int bufferSize;
+	long long samples;
+	double seconds;
+	double cellsPerSecond;
+	int bytesPerCellStep;		//Model state each step streams through memory per cell.
+	double bandwidth;			//Bytes per second implied by cellsPerSecond.
+	double samplesPerSecond;
+	double realTimeFactor;		//Seconds of audio produced per second of processing.
+	int maxVoices;				//Solvers of this configuration that could run concurrently in real-time.
+	double haloFraction;		//Share of GPU step time spent exchanging tile halos, from p50s - -1 unless gl-tiled timed both.
+};
+
+//Sweep configuration - Overridable from command line//
+std::vector<int> domainSizes = { 40, 64, 128, 256, 512, 1024, 2048 };
+std::vector<int> volumeSizes = { 16, 32, 64, 128, 256 };		//Cube edges swept instead with --volume, unless --sizes is given.
+std::vector<int> bufferSizes = { 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+std::vector<SolverBackend> backends;
+std::vector<StoragePrecision> precisions;
+double minRunSeconds = 0.25;
+double regressionTolerance = 0.1;		//Fractional drop in samples per second flagged as a regression.
+std::string outputPath = "benchmark_results.csv";
+std::string baselinePath;
+std::string domainShape;				//Drum shape of every run, see domainBuilder.h - Empty for the rectangle.
+bool isTrackingActiveTiles = false;		//Step only tiles the strikes reached - Backends without support are skipped, results are tagged "+tiles".
+bool isUpdatingInPlace = false;			//Overwrite previous pressure in place - Backends without support are skipped, results are tagged "+inplace".
+bool isVolume = false;					//Sizes are cubes stepped as volumes - Cells are voxels, results are tagged "+3d".
+int numStrings = 0;						//Sizes are the longest of a bank of this many strings - Cells are string cells, results are tagged "+strings".
+bool isCentred = false;					//Strike the centre of the grid, so odd sizes are mirror symmetric - Results are tagged "+centred".
+bool isFoldingSymmetry = true;			//Cleared to step symmetric drums whole on cpu-simd and cpu-threaded - Results are tagged "+unfolded".
+bool isMovingProbes = false;			//Slide the excitation and listener between cells every step - Backends without support are skipped, results are tagged "+moving".
+float plateStiffness = 0.0f;			//Above 0 steps stiff plates of this stiffness, results are tagged "+plate" - Propagation is lowered to keep them stable.
+int textureTileSize = 0;				//Interior cells per side of gl-tiled textures - 0 for the largest the GPU holds.
+
+////////////////////
+//HELPER FUNCTIONS//
+////////////////////
+
+//Parse comma separated integers//
+std::vector<int> parseIntList(const std::string& list);
+
+//Run a single configuration - Returns false if it was skipped//
+bool runBenchmark(SolverBackend backend, StoragePrecision precision, int domainSize, int bufferSize, BenchmarkResult& result);
+
+//Bytes read and written per cell each step - Current, previous and next pressure plus cell type for planes updated in place, a whole texel read and written for the fbo texture//
+//The sparse list also reads its neighbour indices and wall code, and k-space counts modes as cells//
+int getBytesPerCellStep(SolverBackend backend, StoragePrecision precision);
+
+bool writeResults(const std::string& path, const std::vector<BenchmarkResult>& results);
+bool readResults(const std::string& path, std::vector<BenchmarkResult>& results);
+
+//Print every configuration slower than baseline by more than the tolerance - Returns number of regressions//
+int compareWithBaseline(const std::vector<BenchmarkResult>& results, const std::vector<BenchmarkResult>& baseline);
+
+int main(int argc, char* argv[])
+{
+	for (int i = 0; i != NUM_OF_BACKENDS; ++i)
+		backends.push_back((SolverBackend)i);
+	precisions.push_back(PRECISION_FP32);
+
+	//Options//
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		std::string option = argv[i];
+		std::string value = argv[i + 1];
+		if (option == "--sizes")
+			domainSizes = volumeSizes = parseIntList(value);
+		else if (option == "--buffers")
+			bufferSizes = parseIntList(value);
+		else if (option == "--backends")
+		{
+			backends.clear();
+			std::stringstream stream(value);
+			std::string name;
+			while (std::getline(stream, name, ','))
+			{
+				SolverBackend backend = findBackend(name.c_str());
+				if (backend == NUM_OF_BACKENDS)
+				{
+					std::cout << "Unknown backend " << name << std::endl;
+					return -1;
+				}
+				backends.push_back(backend);
+			}
+		}
+		else if (option == "--precisions")
+		{
+			precisions.clear();
+			std::stringstream stream(value);
+			std::string name;
+			while (std::getline(stream, name, ','))
+			{
+				StoragePrecision precision = findPrecision(name.c_str());
+				if (precision == NUM_OF_PRECISIONS)
+				{
+					std::cout << "Unknown precision " << name << std::endl;
+					return -1;
+				}
+				precisions.push_back(precision);
+			}
+		}
+		else if (option == "--min-time")
+			minRunSeconds = std::stod(value);
+		else if (option == "--output")
+			outputPath = value;
+		else if (option == "--baseline")
+			baselinePath = value;
+		else if (option == "--tolerance")
+			regressionTolerance = std::stod(value);
+		else if (option == "--shape")
+			domainShape = value;
+		else if (option == "--active-tiles")
+			isTrackingActiveTiles = value == "1";
+		else if (option == "--in-place")
+			isUpdatingInPlace = value == "1";
+		else if (option == "--strings")
+			numStrings = std::stoi(value);
+		else if (option == "--volume")
+			isVolume = value == "1";
+		else if (option == "--centred")
+			isCentred = value == "1";
+		else if (option == "--fold")
+			isFoldingSymmetry = value == "1";
+		else if (option == "--moving-probes")
+			isMovingProbes = value == "1";
+		else if (option == "--plate")
+		{
+			plateStiffness = std::stof(value);
+			if (plateStiffness < 0.0f || 8.0f * plateStiffness > CFL_LIMIT)
+			{
+				std::cout << "Plate stiffness must be in [0, " << CFL_LIMIT / 8.0f << "]" << std::endl;
+				return -1;
+			}
+		}
+		else if (option == "--tile-size")
+			textureTileSize = std::stoi(value);
+		else
+		{
+			std::cout << "Usage: benchmark [--sizes 40,128] [--buffers 32,128] [--backends gl-fbo,cpu-simd] [--precisions fp32,fp16,bf16,q15] [--min-time seconds] [--output results.csv] [--baseline baseline.csv] [--tolerance 0.1] [--shape \"circle(0.5, 0.5, 0.45)\"] [--active-tiles 1] [--in-place 1] [--volume 1] [--strings 256] [--plate 0.02] [--centred 1] [--fold 0] [--moving-probes 1] [--tile-size 2048]" << std::endl;
+			return -1;
+		}
+	}
+
+	//Hidden window only provides an OpenGL context - GL backends are skipped without one//
+	bool hasGLContext = false;
+	GLFWwindow* window = NULL;
+	if (glfwInit())
+	{
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		window = glfwCreateWindow(1, 1, "Benchmark", NULL, NULL);
+		if (window != NULL)
+		{
+			glfwMakeContextCurrent(window);
+			hasGLContext = gladLoadGLLoader((GLADloadproc)glfwGetProcAddress) != 0;
+		}
+	}
+	if (!hasGLContext)
+		std::cout << "No OpenGL context - GL backends skipped." << std::endl;
+	if (isVolume)
+		domainSizes = volumeSizes;
+
+	/////////////
+	//Run Sweep//
+	/////////////
+	std::vector<BenchmarkResult> results;
+	std::cout << "backend      precision   size  buffer   Mcells/s      GB/s   samples/s   realtime  voices   halo" << std::endl;
+	for (size_t b = 0; b != backends.size(); ++b)
+	{
+		if (isGLBackend(backends[b]) && !hasGLContext)
+			continue;
+		if (isTrackingActiveTiles && !isActiveTilingSupported(backends[b]))
+			continue;
+
+		for (size_t p = 0; p != precisions.size(); ++p)
+		{
+			if (!isPrecisionSupported(backends[b], precisions[p]))
+				continue;
+			if (isUpdatingInPlace && !isInPlaceSupported(backends[b], precisions[p]))
+				continue;
+			if (isVolume && !isVolumeSupported(backends[b]))
+				continue;
+			if (numStrings > 0 && !isStringBankSupported(backends[b]))
+				continue;
+			if (plateStiffness > 0.0f && !isPlateSupported(backends[b]))
+				continue;
+			if (isMovingProbes && !isProbePathSupported(backends[b]))
+				continue;
+
+			for (size_t s = 0; s != domainSizes.size(); ++s)
+			{
+				for (size_t f = 0; f != bufferSizes.size(); ++f)
+				{
+					BenchmarkResult result;
+					if (!runBenchmark(backends[b], precisions[p], domainSizes[s], bufferSizes[f], result))
+						continue;
+
+					results.push_back(result);
+					printf("%-12s %-9s %6d %7d %10.2f %9.2f %11.0f %10.2f %7d", result.backend.c_str(), result.precision.c_str(), result.domainSize, result.bufferSize,
+						result.cellsPerSecond / 1e6, result.bandwidth / 1e9, result.samplesPerSecond, result.realTimeFactor, result.maxVoices);
+					if (result.haloFraction >= 0.0)
+						printf(" %5.1f%%\n", result.haloFraction * 100.0);
+					else
+						printf("      -\n");
+				}
+			}
+		}
+	}
+
+	if (writeResults(outputPath, results))
+		std::cout << "Results written to " << outputPath << std::endl;
+	else
+		std::cout << "Failed to write " << outputPath << std::endl;
+
+	//Regression check//
+	int numRegressions = 0;
+	if (!baselinePath.empty())
+	{
+		std::vector<BenchmarkResult> baseline;
+		if (!readResults(baselinePath, baseline))
+		{
+			std::cout << "Failed to read baseline " << baselinePath << std::endl;
+			numRegressions = -1;
+		}
+		else
+			numRegressions = compareWithBaseline(results, baseline);
+	}
+
+	if (window != NULL)
+		glfwDestroyWindow(window);
+	glfwTerminate();
+
+	return numRegressions == 0 ? 0 : 1;
+}
+
+std::vector<int> parseIntList(const std::string& list)
+{
+	std::vector<int> values;
+	std::stringstream stream(list);
+	std::string value;
+	while (std::getline(stream, value, ','))
+		values.push_back(std::stoi(value));
+	return values;
+}
+
+bool runBenchmark(SolverBackend backend, StoragePrecision precision, int domainSize, int bufferSize, BenchmarkResult& result)
+{
+	SolverSettings settings;
+	settings.domainSize[0] = domainSize;
+	settings.domainSize[1] = domainSize;
+	settings.listenerPosition[0] = domainSize / 8;
+	settings.listenerPosition[1] = domainSize / 8;
+	if (isCentred)
+	{
+		settings.excitationPosition[0] = 0.5f;
+		settings.excitationPosition[1] = 0.5f;
+	}
+	settings.isFoldingSymmetry = isFoldingSymmetry;
+	settings.propagationFactor = 0.5f;
+	settings.dampingFactor = 0.0005f;
+	settings.boundaryGain = 1.0f;
+	settings.storagePrecision = precision;
+	settings.domainShape = domainShape;
+	settings.isTrackingActiveTiles = isTrackingActiveTiles;
+	settings.textureTileSize = textureTileSize;
+	settings.isUpdatingInPlace = isUpdatingInPlace;
+	settings.numStrings = numStrings;
+	settings.plateStiffness = plateStiffness;
+	settings.propagationFactor -= 8.0f * plateStiffness;
+	if (isVolume)
+	{
+		settings.domainDepth = domainSize;
+		settings.listenerLayer = domainSize / 8;
+	}
+
+	Solver* solver = createSolver(backend, settings);
+	if (solver == NULL)
+		return false;
+
+	//Impulse train excitation - Same for every block//
+	std::vector<float> excitation(bufferSize, 0.0f);
+	std::vector<float> output(bufferSize);
+	for (int n = 0; n < bufferSize; n += EXCITATION_PERIOD)
+		excitation[n] = 1.0f;
+
+	//Moving probes - The excitation sweeps a diagonal and the listener circles a quarter of the grid across each block, both between cells//
+	std::vector<float> excitationPath(bufferSize * 2);
+	std::vector<float> listenerPath(bufferSize * 2);
+	for (int n = 0; n != bufferSize; ++n)
+	{
+		float t = (float)n / (float)bufferSize;
+		excitationPath[n * 2 + 0] = (domainSize - 1) * (0.2f + 0.6f * t);
+		excitationPath[n * 2 + 1] = (domainSize - 1) * (0.3f + 0.4f * t);
+		listenerPath[n * 2 + 0] = (domainSize - 1) * (0.5f + 0.25f * std::cos(6.2831853f * t));
+		listenerPath[n * 2 + 1] = (domainSize - 1) * (0.5f + 0.25f * std::sin(6.2831853f * t));
+	}
+	if (isMovingProbes && !solver->isProbePathFollowed())
+	{
+		delete solver;
+		return false;
+	}
+
+	//Probe - Skip configurations where a single buffer would take too long//
+	StageTimer probeTimer;
+	if (isMovingProbes)
+		solver->setProbePaths(&excitationPath[0], &listenerPath[0]);
+	solver->process(&excitation[0], &output[0], std::min(PROBE_SAMPLES, bufferSize));
+	double secondsPerSample = probeTimer.elapsed() / 1e9 / std::min(PROBE_SAMPLES, bufferSize);
+	if (secondsPerSample * bufferSize > MAX_BLOCK_SECONDS)
+	{
+		printf("%-12s %-9s %6d %7d   skipped - %.1f s per buffer\n", getBackendName(backend), getPrecisionName(precision), domainSize, bufferSize, secondsPerSample * bufferSize);
+		delete solver;
+		return false;
+	}
+
+	//Warm up a block, then run whole blocks until the minimum time has passed - Stage records start afresh for the halo fraction//
+	if (isMovingProbes)
+		solver->setProbePaths(&excitationPath[0], &listenerPath[0]);
+	solver->process(&excitation[0], &output[0], bufferSize);
+	profiler.reset();
+
+	long long samples = 0;
+	StageTimer runTimer;
+	do
+	{
+		if (isMovingProbes)
+			solver->setProbePaths(&excitationPath[0], &listenerPath[0]);
+		solver->process(&excitation[0], &output[0], bufferSize);
+		samples += bufferSize;
+	} while (runTimer.elapsed() < minRunSeconds * 1e9);
+	double seconds = runTimer.elapsed() / 1e9;
+
+	delete solver;
+
+	result.backend = std::string(getBackendName(backend)) + (isTrackingActiveTiles ? "+tiles" : "") + (isUpdatingInPlace ? "+inplace" : "") + (isVolume ? "+3d" : "") + (numStrings > 0 ? "+strings" : "") + (plateStiffness > 0.0f ? "+plate" : "") + (isCentred ? "+centred" : "") + (isFoldingSymmetry ? "" : "+unfolded") + (isMovingProbes ? "+moving" : "");
+	result.precision = getPrecisionName(precision);
+	result.domainSize = domainSize;
+	result.bufferSize = bufferSize;
+	result.samples = samples;
+	result.seconds = seconds;
+	result.samplesPerSecond = samples / seconds;
+	result.cellsPerSecond = result.samplesPerSecond * domainSize * domainSize * (isVolume ? domainSize : 1);
+	if (numStrings > 0)
+	{
+		std::vector<StringSettings> strings = buildStringBank(settings);
+		long long stringCells = 0;
+		for (size_t s = 0; s != strings.size(); ++s)
+			stringCells += strings[s].length;
+		result.cellsPerSecond = result.samplesPerSecond * stringCells;
+	}
+	result.bytesPerCellStep = getBytesPerCellStep(backend, precision) + (plateStiffness > 0.0f ? (int)sizeof(float) : 0);	//Plates also read a stiffness per cell.
+	result.bandwidth = result.cellsPerSecond * result.bytesPerCellStep;
+	result.realTimeFactor = result.samplesPerSecond / SAMPLE_RATE;
+	result.maxVoices = (int)std::floor(result.realTimeFactor);
+
+	//Solvers time their GPU stages every few blocks, so a short run may have no records//
+	const StageHistogram& haloHistogram = profiler.getGPUHistogram(STAGE_HALO);
+	const StageHistogram& simulateHistogram = profiler.getGPUHistogram(STAGE_SIMULATE);
+	result.haloFraction = -1.0;
+	if (backend == BACKEND_GL_TILED && haloHistogram.getCount() != 0 && simulateHistogram.getCount() != 0)
+	{
+		double haloTime = (double)haloHistogram.getPercentile(0.5);
+		result.haloFraction = haloTime / (haloTime + simulateHistogram.getPercentile(0.5));
+	}
+	return true;
+}
+
+int getBytesPerCellStep(SolverBackend backend, StoragePrecision precision)
+{
+	int pressureBytes = getPrecisionBytes(precision);
+	if ((backend == BACKEND_GL_FBO && !isUpdatingInPlace) || backend == BACKEND_GL_TILED)
+		return 2 * 2 * pressureBytes + 1;	//RG texel read and written, cell type read.
+	if (backend == BACKEND_CPU_SPARSE)
+		return 3 * pressureBytes + 4 * sizeof(int32_t) + 1;
+	if (backend == BACKEND_CPU_KSPACE)
+		return 5 * sizeof(float);	//Amplitudes of 2 steps read and the next written, mode coefficient and listener weight read.
+	return 3 * pressureBytes + 1;
+}
+
+bool writeResults(const std::string& path, const std::vector<BenchmarkResult>& results)
+{
+	std::ofstream file(path.c_str());
+	if (!file.is_open())
+		return false;
+
+	file << "backend,precision,domain_size,buffer_size,samples,seconds,cells_per_second,bytes_per_cell_step,bandwidth,samples_per_second,real_time_factor,max_voices,halo_fraction\n";
+	for (size_t i = 0; i != results.size(); ++i)
+	{
+		const BenchmarkResult& result = results[i];
+		file << result.backend << ',' << result.precision << ',' << result.domainSize << ',' << result.bufferSize << ',' << result.samples << ','
+			<< result.seconds << ',' << result.cellsPerSecond << ',' << result.bytesPerCellStep << ',' << result.bandwidth << ','
+			<< result.samplesPerSecond << ',' << result.realTimeFactor << ',' << result.maxVoices << ',' << result.haloFraction << '\n';
+	}
+	return true;
+}
+
+bool readResults(const std::string& path, std::vector<BenchmarkResult>& results)
+{
+	std::ifstream file(path.c_str());
+	if (!file.is_open())
+		return false;
+
+	std::string line;
+	std::getline(file, line);	//Header.
+	while (std::getline(file, line))
+	{
+		std::stringstream stream(line);
+		std::string field;
+		std::vector<std::string> fields;
+		while (std::getline(stream, field, ','))
+			fields.push_back(field);
+		if (fields.size() < 12)
+			continue;	//Baselines from before halo_fraction have 12 fields.
+
+		BenchmarkResult result;
+		result.backend = fields[0];
+		result.precision = fields[1];
+		result.domainSize = std::stoi(fields[2]);
+		result.bufferSize = std::stoi(fields[3]);
+		result.samples = std::stoll(fields[4]);
+		result.seconds = std::stod(fields[5]);
+		result.cellsPerSecond = std::stod(fields[6]);
+		result.bytesPerCellStep = std::stoi(fields[7]);
+		result.bandwidth = std::stod(fields[8]);
+		result.samplesPerSecond = std::stod(fields[9]);
+		result.realTimeFactor = std::stod(fields[10]);
+		result.maxVoices = std::stoi(fields[11]);
+		result.haloFraction = fields.size() > 12 ? std::stod(fields[12]) : -1.0;
+		results.push_back(result);
+	}
+	return true;
+}
+
+int compareWithBaseline(const std::vector<BenchmarkResult>& results, const std::vector<BenchmarkResult>& baseline)
+{
+	std::map<std::string, const BenchmarkResult*> baselineByKey;
+	for (size_t i = 0; i != baseline.size(); ++i)
+	{
+		std::stringstream key;
+		key << baseline[i].backend << '/' << baseline[i].precision << '/' << baseline[i].domainSize << '/' << baseline[i].bufferSize;
+		baselineByKey[key.str()] = &baseline[i];
+	}
+
+	int numRegressions = 0;
+	for (size_t i = 0; i != results.size(); ++i)
+	{
+		std::stringstream key;
+		key << results[i].backend << '/' << results[i].precision << '/' << results[i].domainSize << '/' << results[i].bufferSize;
+		std::map<std::string, const BenchmarkResult*>::const_iterator match = baselineByKey.find(key.str());
+		if (match == baselineByKey.end())
+			continue;
+
+		double ratio = results[i].samplesPerSecond / match->second->samplesPerSecond;
+		if (ratio < 1.0 - regressionTolerance)
+		{
+			printf("REGRESSION %s: %.0f samples/s against baseline %.0f (%.1f%%)\n", key.str().c_str(),
+				results[i].samplesPerSecond, match->second->samplesPerSecond, (ratio - 1.0) * 100.0);
+			++numRegressions;
+		}
+	}
+
+	std::cout << numRegressions << " regressions against " << baselinePath << std::endl;
+	return numRegressions;
+}
@@ -0,0 +1,148 @@
+#include "checkpoint.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(CheckpointHeader) == 64, "Checkpoint header layout changed - Bump CHECKPOINT_VERSION");
+
+CheckpointHeader makeCheckpointHeader(const SolverSettings& settings)
+{
+	CheckpointHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = CHECKPOINT_MAGIC;
+	header.version = CHECKPOINT_VERSION;
+	header.domainSize[0] = settings.domainSize[0];
+	header.domainSize[1] = settings.domainSize[1];
+	header.listenerPosition[0] = settings.listenerPosition[0];
+	header.listenerPosition[1] = settings.listenerPosition[1];
+	header.excitationPosition[0] = settings.excitationPosition[0];
+	header.excitationPosition[1] = settings.excitationPosition[1];
+	header.propagationFactor = settings.propagationFactor;
+	header.dampingFactor = settings.dampingFactor;
+	header.boundaryGain = settings.boundaryGain;
+	return header;
+}
+
+SolverSettings getCheckpointSettings(const CheckpointHeader& header)
+{
+	SolverSettings settings;
+	settings.domainSize[0] = header.domainSize[0];
+	settings.domainSize[1] = header.domainSize[1];
+	settings.listenerPosition[0] = header.listenerPosition[0];
+	settings.listenerPosition[1] = header.listenerPosition[1];
+	settings.excitationPosition[0] = header.excitationPosition[0];
+	settings.excitationPosition[1] = header.excitationPosition[1];
+	settings.propagationFactor = header.propagationFactor;
+	settings.dampingFactor = header.dampingFactor;
+	settings.boundaryGain = header.boundaryGain;
+	return settings;
+}
+
+bool saveCheckpoint(const char* path, const CheckpointHeader& header, const float* field)
+{
+	FILE* file = fopen(path, "wb");
+	if (file == NULL)
+		return false;
+
+	size_t numFloats = (size_t)header.domainSize[0] * header.domainSize[1] * 4;
+	bool isWritten = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(field, sizeof(float), numFloats, file) == numFloats;
+	return fclose(file) == 0 && isWritten;
+}
+
+MappedCheckpoint::~MappedCheckpoint()
+{
+	close();
+}
+
+bool MappedCheckpoint::open(const char* path)
+{
+	close();
+
+#ifdef _WIN32
+	fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+	{
+		fileHandle = NULL;
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(fileHandle, &fileSize);
+	size = (size_t)fileSize.QuadPart;
+	mappingHandle = size >= sizeof(CheckpointHeader) ? CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+	if (mappingHandle != NULL)
+		mapping = (const uint8_t*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+#else
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) == 0 && (size_t)fileStat.st_size >= sizeof(CheckpointHeader))
+	{
+		size = (size_t)fileStat.st_size;
+		void* view = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (view != MAP_FAILED)
+			mapping = (const uint8_t*)view;
+	}
+	::close(fd);	//The mapping stays valid without the descriptor.
+#endif
+
+	if (mapping == NULL)
+	{
+		close();
+		return false;
+	}
+
+	//Refuse foreign files, other versions and truncated fields//
+	const CheckpointHeader& header = getHeader();
+	size_t fieldSize = (size_t)header.domainSize[0] * header.domainSize[1] * 4 * sizeof(float);
+	if (header.magic != CHECKPOINT_MAGIC || header.version != CHECKPOINT_VERSION || header.domainSize[0] <= 0 || header.domainSize[1] <= 0
+		|| size < sizeof(CheckpointHeader) + fieldSize)
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedCheckpoint::close()
+{
+#ifdef _WIN32
+	if (mapping != NULL)
+		UnmapViewOfFile(mapping);
+	if (mappingHandle != NULL)
+		CloseHandle(mappingHandle);
+	if (fileHandle != NULL)
+		CloseHandle(fileHandle);
+	mappingHandle = NULL;
+	fileHandle = NULL;
+#else
+	if (mapping != NULL)
+		munmap((void*)mapping, size);
+#endif
+	mapping = NULL;
+	size = 0;
+}
+
+bool MappedCheckpoint::isOpen() const
+{
+	return mapping != NULL;
+}
+
+const CheckpointHeader& MappedCheckpoint::getHeader() const
+{
+	return *(const CheckpointHeader*)mapping;
+}
+
+const float* MappedCheckpoint::getField() const
+{
+	return (const float*)(mapping + sizeof(CheckpointHeader));
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "solver.h"
+
+///////////
+//DEFINES//
+///////////
+
+#define CHECKPOINT_MAGIC	0x54504B43	//"CKPT" - Identifies checkpoint files.
+#define CHECKPOINT_VERSION	2			//Bump whenever the header or field layout changes - Older files are then refused.
+
+//Fixed size header at the start of a checkpoint file - The field follows immediately, domainSize[0] * domainSize[1] cells of 4 floats in getField() layout//
+struct CheckpointHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t sampleCount;				//Steps the model had been advanced when saved.
+	int32_t domainSize[2];
+	int32_t listenerPosition[2];
+	float excitationPosition[2];
+	float propagationFactor;
+	float dampingFactor;
+	float boundaryGain;
+	int32_t excitorIndex[2];			//Playback position of the square and sine wave excitors.
+	uint32_t reserved;					//Pads the header to 64 bytes, keeping the field aligned.
+};
+
+//Header identifying the current version, holding the model settings - Counters are left zero for the caller//
+CheckpointHeader makeCheckpointHeader(const SolverSettings& settings);
+
+//Model settings the checkpoint was saved with//
+SolverSettings getCheckpointSettings(const CheckpointHeader& header);
+
+//Write header followed by field to path - Returns false on failure//
+bool saveCheckpoint(const char* path, const CheckpointHeader& header, const float* field);
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//MappedCheckpoint - Read only memory mapping of a checkpoint file. The field is handed to //
+//Solver::setField() straight from the mapping, so restoring never copies the file into an //
+//intermediate buffer. The mapping is released on close() or destruction.                  //
+//////////////////////////////////////////////////////////////////////////////////////////////
+class MappedCheckpoint {
+private:
+	const uint8_t* mapping = NULL;
+	size_t size = 0;
+#ifdef _WIN32
+	void* fileHandle = NULL;
+	void* mappingHandle = NULL;
+#endif
+
+	MappedCheckpoint(const MappedCheckpoint&);
+	MappedCheckpoint& operator=(const MappedCheckpoint&);
+
+public:
+	MappedCheckpoint() {}
+	~MappedCheckpoint();
+
+	//Map a file - Fails if it isn't a checkpoint of the current version or is truncated//
+	bool open(const char* path);
+	void close();
+
+	bool isOpen() const;
+	const CheckpointHeader& getHeader() const;
+	const float* getField() const;
+};
@@ -0,0 +1,377 @@
+#include "computeSolver.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "shaderProgram.h"
+#include "domainBuilder.h"
+#include "tracer.h"
+
+ComputeSolver::ComputeSolver(const SolverSettings& aSettings) : settings(aSettings), materialRamp(aSettings), simulateTimer(STAGE_SIMULATE)
+{
+	width = settings.domainSize[0];
+	height = settings.domainSize[1];
+	isTiled = settings.isTrackingActiveTiles;
+
+	if (!loadComputeProgram("Shaders/fdtd_cs.glsl", computeShaderProgram))
+	{
+		std::cout << "Failed to create compute shader." << std::endl;
+		glDeleteProgram(computeShaderProgram);
+		computeShaderProgram = 0;
+		return;
+	}
+
+	//Material glides are dispatched into the coefficient buffer on the GPU, never recompiling or reading back//
+	if (!loadComputeProgram("Shaders/coefficients_cs.glsl", coefficientShaderProgram))
+	{
+		std::cout << "Failed to create coefficient shader." << std::endl;
+		glDeleteProgram(coefficientShaderProgram);
+		glDeleteProgram(computeShaderProgram);
+		coefficientShaderProgram = 0;
+		computeShaderProgram = 0;
+		return;
+	}
+	glUseProgram(coefficientShaderProgram);
+	glUniform1i(glGetUniformLocation(coefficientShaderProgram, "numCells"), width * height);
+	materialOffsetLocation = glGetUniformLocation(coefficientShaderProgram, "materialOffset");
+
+	//Energy is reduced on the GPU, so checking for silence reads back a partial sum per work group rather than the field//
+	if (!loadComputeProgram("Shaders/energy_cs.glsl", energyShaderProgram))
+	{
+		std::cout << "Failed to create energy shader." << std::endl;
+		glDeleteProgram(energyShaderProgram);
+		glDeleteProgram(coefficientShaderProgram);
+		glDeleteProgram(computeShaderProgram);
+		energyShaderProgram = 0;
+		coefficientShaderProgram = 0;
+		computeShaderProgram = 0;
+		return;
+	}
+	glUseProgram(energyShaderProgram);
+	glUniform2i(glGetUniformLocation(energyShaderProgram, "domainSize"), width, height);
+	energyCurrentPlaneLocation = glGetUniformLocation(energyShaderProgram, "currentPlane");
+
+	//Tiles a disturbance reached are scheduled on the GPU each step, so the step count never waits on a readback//
+	if (isTiled && !loadComputeProgram("Shaders/tiles_cs.glsl", tileShaderProgram))
+	{
+		std::cout << "Failed to create tile shader." << std::endl;
+		glDeleteProgram(tileShaderProgram);
+		glDeleteProgram(energyShaderProgram);
+		glDeleteProgram(coefficientShaderProgram);
+		glDeleteProgram(computeShaderProgram);
+		tileShaderProgram = 0;
+		energyShaderProgram = 0;
+		coefficientShaderProgram = 0;
+		computeShaderProgram = 0;
+		return;
+	}
+
+	//Pressure planes start at rest, cell types from the shared domain//
+	domain = buildDomain(settings);
+	domain.cellTypes[settings.listenerPosition[1] * width + settings.listenerPosition[0]] |= CELL_LISTENER;
+	std::vector<float> zeros(width * height * 2, 0.0f);
+
+	glGenBuffers(1, &pressureBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, pressureBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(float) * zeros.size(), &zeros[0], GL_DYNAMIC_COPY);
+
+	glGenBuffers(1, &cellTypeBuffer);
+	glGenBuffers(1, &coefficientBuffer);
+	glGenBuffers(1, &materialBuffer);
+	uploadDomain();
+
+	glGenBuffers(1, &energyBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, energyBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(float) * getNumGroups(), NULL, GL_STREAM_READ);
+
+	glGenBuffers(1, &excitationBuffer);
+	glGenBuffers(1, &audioBuffer);
+	reserveBlock(512);
+
+	//The model starts at rest, so no tile is live//
+	if (isTiled)
+	{
+		std::vector<GLuint> tileFlags(getNumGroups(), 0);
+		const GLuint dispatch[3] = { 0, 1, 1 };
+		glGenBuffers(1, &tileFlagBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, tileFlagBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * tileFlags.size(), &tileFlags[0], GL_DYNAMIC_COPY);
+		glGenBuffers(1, &tileListBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, tileListBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * tileFlags.size(), NULL, GL_DYNAMIC_COPY);
+		glGenBuffers(1, &dispatchBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, dispatchBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(dispatch), dispatch, GL_DYNAMIC_COPY);
+
+		glUseProgram(tileShaderProgram);
+		glUniform2i(glGetUniformLocation(tileShaderProgram, "numTiles"), (width + COMPUTE_LOCAL_SIZE - 1) / COMPUTE_LOCAL_SIZE, (height + COMPUTE_LOCAL_SIZE - 1) / COMPUTE_LOCAL_SIZE);
+		tileStepLocation = glGetUniformLocation(tileShaderProgram, "step");
+		tileExcitationLocation = glGetUniformLocation(tileShaderProgram, "excitationTile");
+	}
+
+	//Static Uniforms//
+	glUseProgram(computeShaderProgram);
+	glUniform2i(glGetUniformLocation(computeShaderProgram, "domainSize"), width, height);
+	glUniform2i(glGetUniformLocation(computeShaderProgram, "listenerCell"), settings.listenerPosition[0], settings.listenerPosition[1]);
+	glUniform1i(glGetUniformLocation(computeShaderProgram, "isTiled"), isTiled);
+	glUniform1i(glGetUniformLocation(computeShaderProgram, "numTilesX"), (width + COMPUTE_LOCAL_SIZE - 1) / COMPUTE_LOCAL_SIZE);
+
+	//Dynamic Uniforms//
+	currentPlaneLocation = glGetUniformLocation(computeShaderProgram, "currentPlane");
+	stepLocation = glGetUniformLocation(computeShaderProgram, "step");
+	excitationCellLocation = glGetUniformLocation(computeShaderProgram, "excitationCell");
+	glUseProgram(0);
+
+	setExcitationPosition(settings.excitationPosition[0], settings.excitationPosition[1]);
+}
+
+ComputeSolver::~ComputeSolver()
+{
+	glDeleteBuffers(1, &dispatchBuffer);
+	glDeleteBuffers(1, &tileListBuffer);
+	glDeleteBuffers(1, &tileFlagBuffer);
+	glDeleteBuffers(1, &audioBuffer);
+	glDeleteBuffers(1, &excitationBuffer);
+	glDeleteBuffers(1, &energyBuffer);
+	glDeleteBuffers(1, &materialBuffer);
+	glDeleteBuffers(1, &coefficientBuffer);
+	glDeleteBuffers(1, &cellTypeBuffer);
+	glDeleteBuffers(1, &pressureBuffer);
+	glDeleteProgram(tileShaderProgram);
+	glDeleteProgram(energyShaderProgram);
+	glDeleteProgram(coefficientShaderProgram);
+	glDeleteProgram(computeShaderProgram);
+}
+
+bool ComputeSolver::isValid() const
+{
+	return computeShaderProgram != 0;
+}
+
+const char* ComputeSolver::getName() const
+{
+	return isTiled ? "GL compute active tiles" : "GL compute";
+}
+
+void ComputeSolver::uploadDomain()
+{
+	//Whole uints only - Padding bytes past the last cell are never read//
+	std::vector<uint8_t> packed(domain.cellTypes);
+	packed.resize((packed.size() + 3) & ~(size_t)3, 0);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, cellTypeBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, packed.size(), &packed[0], GL_STATIC_DRAW);
+
+	//Coefficients are vec4 too - std430 pads vec3 arrays to vec4 anyway, so their fourth lane is left unused//
+	std::vector<float> texels = computeMaterialTexels(domain);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, materialBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(float) * texels.size(), &texels[0], GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, coefficientBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(float) * texels.size(), NULL, GL_DYNAMIC_COPY);
+	updateCoefficients();
+}
+
+void ComputeSolver::updateCoefficients()
+{
+	MaterialOffset offset = materialRamp.getOffset();
+	glUseProgram(coefficientShaderProgram);
+	glUniform3f(materialOffsetLocation, offset.propagation, offset.damping, offset.boundaryGain);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, coefficientBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, materialBuffer);
+	glDispatchCompute((width * height + COEFFICIENT_LOCAL_SIZE - 1) / COEFFICIENT_LOCAL_SIZE, 1, 1);
+
+	//Steps after this read the new coefficients//
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void ComputeSolver::reserveBlock(int numSamples)
+{
+	if (numSamples <= blockCapacity)
+		return;
+
+	blockCapacity = numSamples;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, excitationBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(float) * blockCapacity, NULL, GL_STREAM_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, audioBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(float) * blockCapacity, NULL, GL_STREAM_READ);
+}
+
+void ComputeSolver::process(const float* excitation, float* output, int numSamples)
+{
+	reserveBlock(numSamples);
+
+	bool isTimingGPU = (processCount++ % GPU_TIMING_INTERVAL) == 0;
+	if (isTimingGPU)
+		simulateTimer.collect();
+
+	//Excitation of the whole block uploaded once//
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, excitationBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(float) * numSamples, excitation);
+
+	glUseProgram(computeShaderProgram);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, pressureBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, cellTypeBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, excitationBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, audioBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, coefficientBuffer);
+	glUniform2i(excitationCellLocation, excitationCell[0], excitationCell[1]);
+	if (isTiled)
+	{
+		//Tiles that aren't stepped leave the listener at zero//
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, audioBuffer);
+		glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32F, 0, sizeof(float) * numSamples, GL_RED, GL_FLOAT, NULL);
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, tileFlagBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, tileListBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 9, dispatchBuffer);
+		glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, dispatchBuffer);
+		glUseProgram(tileShaderProgram);
+		glUniform1i(tileExcitationLocation, (excitationCell[1] / COMPUTE_LOCAL_SIZE) * ((width + COMPUTE_LOCAL_SIZE - 1) / COMPUTE_LOCAL_SIZE) + excitationCell[0] / COMPUTE_LOCAL_SIZE);
+		glUseProgram(computeShaderProgram);
+	}
+
+	GLuint groupsX = (width + COMPUTE_LOCAL_SIZE - 1) / COMPUTE_LOCAL_SIZE;
+	GLuint groupsY = (height + COMPUTE_LOCAL_SIZE - 1) / COMPUTE_LOCAL_SIZE;
+
+	StageTimer simulateStageTimer;
+	TRACE_SPAN_BEGIN(simulateSpan, "simulate");
+	if (isTimingGPU)
+		simulateTimer.begin();
+	int segmentEnd = 0;
+	for (int n = 0; n != numSamples; ++n)
+	{
+		//A material glide dispatches new coefficients at the start of each of its segments//
+		if (n == segmentEnd)
+		{
+			bool isChanged;
+			segmentEnd += materialRamp.advance(numSamples - n, isChanged);
+			if (isChanged)
+			{
+				updateCoefficients();
+				glUseProgram(computeShaderProgram);
+			}
+		}
+
+		if (isTiled)
+		{
+			//Schedule from the flags the last step left, then dispatch a work group per scheduled tile//
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, dispatchBuffer);
+			glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, 0, sizeof(GLuint), GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+			glUseProgram(tileShaderProgram);
+			glUniform1i(tileStepLocation, n);
+			glDispatchCompute((getNumGroups() + TILE_LOCAL_SIZE - 1) / TILE_LOCAL_SIZE, 1, 1);
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+			glUseProgram(computeShaderProgram);
+			glUniform1i(currentPlaneLocation, currentPlane);
+			glUniform1i(stepLocation, n);
+			glDispatchComputeIndirect(0);
+		}
+		else
+		{
+			glUniform1i(currentPlaneLocation, currentPlane);
+			glUniform1i(stepLocation, n);
+			glDispatchCompute(groupsX, groupsY, 1);
+		}
+
+		//Next step reads what this one wrote//
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		currentPlane = 1 - currentPlane;
+	}
+	if (isTimingGPU)
+		simulateTimer.end();
+	TRACE_SPAN_END(simulateSpan);
+	profiler.recordCPU(STAGE_SIMULATE, simulateStageTimer.elapsed());
+
+	//Retrieve the block's audio in one read//
+	StageTimer readbackStageTimer;
+	TRACE_SPAN_BEGIN(readbackSpan, "readback");
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, audioBuffer);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(float) * numSamples, output);
+	TRACE_SPAN_END(readbackSpan);
+	profiler.recordCPU(STAGE_READBACK, readbackStageTimer.elapsed());
+}
+
+void ComputeSolver::setExcitationPosition(float x, float y)
+{
+	excitationCell[0] = std::min(std::max((int)(x * width), 0), width - 1);
+	excitationCell[1] = std::min(std::max((int)(y * height), 0), height - 1);
+}
+
+void ComputeSolver::setMaterial(float propagation, float damping, float boundaryGain)
+{
+	materialRamp.setTarget(propagation, damping, boundaryGain);
+}
+
+int ComputeSolver::getNumGroups() const
+{
+	return ((width + COMPUTE_LOCAL_SIZE - 1) / COMPUTE_LOCAL_SIZE) * ((height + COMPUTE_LOCAL_SIZE - 1) / COMPUTE_LOCAL_SIZE);
+}
+
+double ComputeSolver::getEnergy()
+{
+	TRACE_SCOPE("energy");
+
+	glUseProgram(energyShaderProgram);
+	glUniform1i(energyCurrentPlaneLocation, currentPlane);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, pressureBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, cellTypeBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, energyBuffer);
+	glDispatchCompute((width + COMPUTE_LOCAL_SIZE - 1) / COMPUTE_LOCAL_SIZE, (height + COMPUTE_LOCAL_SIZE - 1) / COMPUTE_LOCAL_SIZE, 1);
+
+	//Partial sums finished in double//
+	std::vector<float> partialEnergy(getNumGroups());
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, energyBuffer);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(float) * partialEnergy.size(), &partialEnergy[0]);
+
+	double energy = 0.0;
+	for (size_t g = 0; g != partialEnergy.size(); ++g)
+		energy += partialEnergy[g];
+	return energy;
+}
+
+void ComputeSolver::getField(float* field)
+{
+	TRACE_SCOPE("snapshot");
+
+	std::vector<float> planes(width * height * 2);
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, pressureBuffer);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(float) * planes.size(), &planes[0]);
+
+	int planeSize = width * height;
+	for (int i = 0; i != planeSize; ++i)
+	{
+		field[i * 4 + 0] = planes[currentPlane * planeSize + i];
+		field[i * 4 + 1] = planes[(1 - currentPlane) * planeSize + i];
+		field[i * 4 + 2] = getTransmission(domain.cellTypes[i]);
+		field[i * 4 + 3] = domain.cellTypes[i];
+	}
+}
+
+void ComputeSolver::setField(const float* field)
+{
+	//Storage buffers hold planes rather than interleaved cells//
+	int planeSize = width * height;
+	std::vector<float> planes(planeSize * 2);
+	for (int i = 0; i != planeSize; ++i)
+	{
+		planes[currentPlane * planeSize + i] = field[i * 4 + 0];
+		planes[(1 - currentPlane) * planeSize + i] = field[i * 4 + 1];
+		domain.cellTypes[i] = (uint8_t)field[i * 4 + 3];
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, pressureBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(float) * planes.size(), &planes[0]);
+	uploadDomain();
+
+	//Anything may be nonzero now - Every tile is stepped until it goes quiet//
+	if (isTiled)
+	{
+		std::vector<GLuint> tileFlags(getNumGroups(), TILE_LIVE);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, tileFlagBuffer);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint) * tileFlags.size(), &tileFlags[0]);
+	}
+}
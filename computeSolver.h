@@ -0,0 +1,87 @@
+#pragma once
+
+#include <glad\glad.h>
+
+#include "solver.h"
+#include "domain.h"
+#include "materialRamp.h"
+#include "gpuTimer.h"
+
+#define COMPUTE_LOCAL_SIZE	16		//Work group width and height - Must match local_size in fdtd_cs.glsl.
+#define COEFFICIENT_LOCAL_SIZE	256	//Work group size - Must match local_size in coefficients_cs.glsl.
+#define TILE_LOCAL_SIZE		64		//Work group size - Must match local_size in tiles_cs.glsl.
+#define TILE_LIVE			1		//Tile flag of a tile stepped next step - Must match fdtd_cs.glsl.
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+//ComputeSolver - FDTD model in shader storage buffers advanced by a compute shader, one      //
+//dispatch per step. The listener is written to an audio buffer by the dispatch itself, so a //
+//block needs no audio draws and a single readback. With settings.isTrackingActiveTiles, a //
+//work group per tile is dispatched indirectly, stepping only tiles tiles_cs.glsl schedules.//
+//Needs an OpenGL 4.3 context.                                                              //
+////////////////////////////////////////////////////////////////////////////////////////////////
+class ComputeSolver : public Solver {
+private:
+	SolverSettings settings;
+	Domain domain;					//Cell types and material as uploaded to cellTypeBuffer and materialBuffer.
+	MaterialRamp materialRamp;
+	int width;
+	int height;
+	int blockCapacity = 0;			//Steps the excitation and audio buffers currently hold.
+
+	GLuint computeShaderProgram = 0;
+	GLuint coefficientShaderProgram = 0;	//Folds material and its runtime offset into coefficientBuffer.
+	GLuint energyShaderProgram = 0;			//Reduces field energy into energyBuffer.
+	GLuint tileShaderProgram = 0;			//Schedules active tiles into tileListBuffer - Active tiles only.
+	GLuint pressureBuffer = 0;
+	GLuint cellTypeBuffer = 0;		//Cell type bytes, 4 packed per uint.
+	GLuint coefficientBuffer = 0;	//Update coefficients, a vec4 per cell.
+	GLuint materialBuffer = 0;		//computeMaterialTexels(), a vec4 per cell.
+	GLuint energyBuffer = 0;		//Field energy partial sum of each work group.
+	GLuint excitationBuffer = 0;
+	GLuint audioBuffer = 0;
+	GLuint tileFlagBuffer = 0;		//Flags each tile was left with by the last step, a uint per work group.
+	GLuint tileListBuffer = 0;		//Tiles the next step dispatches.
+	GLuint dispatchBuffer = 0;		//Indirect dispatch arguments counted by tiles_cs.glsl.
+
+	//Uniform Locations//
+	GLint currentPlaneLocation;
+	GLint stepLocation;
+	GLint excitationCellLocation;
+	GLint materialOffsetLocation;
+	GLint energyCurrentPlaneLocation;
+	GLint tileStepLocation;
+	GLint tileExcitationLocation;
+
+	int currentPlane = 0;
+	int excitationCell[2];
+	bool isTiled;					//Steps only scheduled tiles.
+
+	GPUTimer simulateTimer;
+	int processCount = 0;
+
+	//Upload domain's cell types and material into their buffers, then recompute coefficients//
+	void uploadDomain();
+
+	//Dispatch the current material into coefficientBuffer - Leaves the coefficient program bound//
+	void updateCoefficients();
+
+	//Work groups a dispatch over the grid launches//
+	int getNumGroups() const;
+
+	//Grow excitation and audio buffers to hold numSamples steps//
+	void reserveBlock(int numSamples);
+
+public:
+	ComputeSolver(const SolverSettings& aSettings);
+	~ComputeSolver();
+
+	bool isValid() const;
+
+	const char* getName() const;
+	void process(const float* excitation, float* output, int numSamples);
+	void setExcitationPosition(float x, float y);
+	void setMaterial(float propagation, float damping, float boundaryGain);
+	double getEnergy();
+	void getField(float* field);
+	void setField(const float* field);
+};
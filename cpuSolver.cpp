@@ -0,0 +1,219 @@
+#include "cpuSolver.h"
+
+#include <algorithm>
+
+#include "domainBuilder.h"
+#include "profiler.h"
+#include "tracer.h"
+
+CPUSolver::CPUSolver(const SolverSettings& aSettings) : CPUSolver(aSettings, buildDomain(aSettings))
+{
+}
+
+CPUSolver::CPUSolver(const SolverSettings& aSettings, const Domain& aDomain) : settings(aSettings), domain(aDomain), materialRamp(aSettings)
+{
+	width = settings.domainSize[0];
+	height = settings.domainSize[1];
+	domain.cellTypes[settings.listenerPosition[1] * width + settings.listenerPosition[0]] |= CELL_LISTENER;
+	coefficients = computeUpdateCoefficients(domain);
+
+	pressure[0].assign(width * height, 0.0f);
+	pressure[1].assign(width * height, 0.0f);
+
+	listenerPoint[0] = (float)settings.listenerPosition[0];
+	listenerPoint[1] = (float)settings.listenerPosition[1];
+	listenerProbe = computeCellProbe(domain, listenerPoint[0], listenerPoint[1]);
+	setExcitationPosition(settings.excitationPosition[0], settings.excitationPosition[1]);
+}
+
+const char* CPUSolver::getName() const
+{
+	return "CPU scalar";
+}
+
+void CPUSolver::computeRows(const float* current, float* previous, int rowBegin, int rowEnd)
+{
+	for (int y = rowBegin; y != rowEnd; ++y)
+		computeSpan(current, previous, 0, y, 1, width - 1);
+}
+
+void CPUSolver::computeSpan(const float* current, float* previous, int cellOffset, int y, int xBegin, int xEnd)
+{
+	const uint8_t* cellTypes = &domain.cellTypes[cellOffset];
+	const float* centre = &coefficients.centre[cellOffset];
+	const float* previousCoefficient = &coefficients.previous[cellOffset];
+	const float* neighbourCoefficient = &coefficients.neighbour[cellOffset];
+
+	for (int x = xBegin; x < xEnd; ++x)
+	{
+		int i = y * width + x;
+		float p = current[i];			//Current pressure point.
+		float p_prev = previous[i];		//Previous pressure point.
+
+		//Neighbours [left, up, right, down] - Only regular neighbours pass on pressure, reflections off walls are folded into the centre coefficient//
+		//Summed as (left + right) + (up + down), which a mirror image rounds identically, so symmetric drums stay exactly symmetric//
+		const int offsets[4] = { -1, width, 1, -width };
+		float pNeighbour[4];
+		for (int k = 0; k != 4; ++k)
+			pNeighbour[k] = current[i + offsets[k]] * getTransmission(cellTypes[i + offsets[k]]);
+		float pLRUD = (pNeighbour[0] + pNeighbour[2]) + (pNeighbour[1] + pNeighbour[3]);
+
+		//Assemble equation//
+		float p_next = centre[i] * p + previousCoefficient[i] * p_prev;
+		p_next += neighbourCoefficient[i] * pLRUD;
+
+		previous[i] = p_next;	//Previous timestep is no longer needed - Overwritten with the next.
+	}
+}
+
+int CPUSolver::rampMaterial(int numSamples)
+{
+	bool isChanged;
+	int segment = materialRamp.advance(numSamples, isChanged);
+	if (isChanged)
+		computeUpdateCoefficients(domain, materialRamp.getOffset(), coefficients);
+	return segment;
+}
+
+CellProbe CPUSolver::getExcitationProbe(int n) const
+{
+	return excitationPath != NULL ? computeCellProbe(domain, excitationPath[n * 2], excitationPath[n * 2 + 1]) : excitationProbe;
+}
+
+CellProbe CPUSolver::getListenerProbe(int n) const
+{
+	return listenerPath != NULL ? computeCellProbe(domain, listenerPath[n * 2], listenerPath[n * 2 + 1]) : listenerProbe;
+}
+
+void CPUSolver::endPaths(int numSamples)
+{
+	if (excitationPath != NULL && numSamples > 0)
+		setExcitationPoint(excitationPath[numSamples * 2 - 2], excitationPath[numSamples * 2 - 1]);
+	if (listenerPath != NULL && numSamples > 0)
+		setListenerPoint(listenerPath[numSamples * 2 - 2], listenerPath[numSamples * 2 - 1]);
+	excitationPath = NULL;
+	listenerPath = NULL;
+}
+
+void CPUSolver::setExcitationPoint(float x, float y)
+{
+	excitationPoint[0] = x;
+	excitationPoint[1] = y;
+	excitationProbe = computeCellProbe(domain, x, y);
+}
+
+void CPUSolver::setListenerPoint(float x, float y)
+{
+	//Marked on the nearest cell//
+	int previousCell = (int)(listenerPoint[1] + 0.5f) * width + (int)(listenerPoint[0] + 0.5f);
+	domain.cellTypes[previousCell] &= ~CELL_LISTENER;
+	listenerPoint[0] = std::min(std::max(x, 0.0f), (float)(width - 1));
+	listenerPoint[1] = std::min(std::max(y, 0.0f), (float)(height - 1));
+	domain.cellTypes[(int)(listenerPoint[1] + 0.5f) * width + (int)(listenerPoint[0] + 0.5f)] |= CELL_LISTENER;
+	listenerProbe = computeCellProbe(domain, listenerPoint[0], listenerPoint[1]);
+}
+
+void CPUSolver::finishStep(float* next, int n, float excitation, float& output)
+{
+	//Cells of zero weight are skipped, so a probe resting on a whole cell touches only that one//
+	CellProbe probe = getExcitationProbe(n);
+	for (int k = 0; k != 4; ++k)
+	{
+		if (probe.weight[k] != 0.0f)
+			next[probe.index[k]] += excitation * probe.weight[k];
+	}
+
+	//Walls weigh 0, silencing boundaries as the fbo shader does//
+	probe = getListenerProbe(n);
+	output = 0.0f;
+	for (int k = 0; k != 4; ++k)
+	{
+		if (probe.weight[k] != 0.0f)
+			output += next[probe.index[k]] * probe.weight[k];
+	}
+}
+
+void CPUSolver::process(const float* excitation, float* output, int numSamples)
+{
+	StageTimer simulateStageTimer;
+	TRACE_SCOPE("simulate");
+
+	int n = 0;
+	while (n != numSamples)
+	{
+		int segmentEnd = n + rampMaterial(numSamples - n);
+		for (; n != segmentEnd; ++n)
+		{
+			float* current = &pressure[currentPlane][0];
+			float* next = &pressure[1 - currentPlane][0];
+
+			computeRows(current, next, 1, height - 1);
+			finishStep(next, n, excitation[n], output[n]);
+
+			currentPlane = 1 - currentPlane;
+		}
+	}
+	endPaths(numSamples);
+
+	profiler.recordCPU(STAGE_SIMULATE, simulateStageTimer.elapsed());
+}
+
+void CPUSolver::setExcitationPosition(float x, float y)
+{
+	int cellX = std::min(std::max((int)(x * width), 0), width - 1);
+	int cellY = std::min(std::max((int)(y * height), 0), height - 1);
+	setExcitationPoint((float)cellX, (float)cellY);
+}
+
+void CPUSolver::setProbePaths(const float* aExcitationPath, const float* aListenerPath)
+{
+	if (aExcitationPath != NULL)
+		excitationPath = aExcitationPath;
+	if (aListenerPath != NULL)
+		listenerPath = aListenerPath;
+}
+
+bool CPUSolver::isProbePathFollowed() const
+{
+	return true;
+}
+
+void CPUSolver::setMaterial(float propagation, float damping, float boundaryGain)
+{
+	materialRamp.setTarget(propagation, damping, boundaryGain);
+}
+
+double CPUSolver::getEnergy()
+{
+	return computeFieldEnergy(domain, &pressure[currentPlane][0], &pressure[1 - currentPlane][0]);
+}
+
+void CPUSolver::getField(float* field)
+{
+	const std::vector<float>& current = pressure[currentPlane];
+	const std::vector<float>& previous = pressure[1 - currentPlane];
+	for (int i = 0; i != width * height; ++i)
+	{
+		field[i * 4 + 0] = current[i];
+		field[i * 4 + 1] = previous[i];
+		field[i * 4 + 2] = getTransmission(domain.cellTypes[i]);
+		field[i * 4 + 3] = domain.cellTypes[i];
+	}
+}
+
+void CPUSolver::setField(const float* field)
+{
+	std::vector<float>& current = pressure[currentPlane];
+	std::vector<float>& previous = pressure[1 - currentPlane];
+	for (int i = 0; i != width * height; ++i)
+	{
+		current[i] = field[i * 4 + 0];
+		previous[i] = field[i * 4 + 1];
+		domain.cellTypes[i] = (uint8_t)field[i * 4 + 3];
+	}
+	computeUpdateCoefficients(domain, materialRamp.getOffset(), coefficients);
+
+	//Walls may have moved under the probes//
+	setExcitationPoint(excitationPoint[0], excitationPoint[1]);
+	setListenerPoint(listenerPoint[0], listenerPoint[1]);
+}
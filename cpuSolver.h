@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+
+#include "solver.h"
+#include "domain.h"
+#include "materialRamp.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//CPUSolver - Scalar reference implementation of the fbo shader's computeFDTD(). The model  //
+//is held as two pressure planes which alternate between timestep n & n-1, the same way the//
+//two texture quads do. Derived backends only replace how rows of a step are computed.      //
+//////////////////////////////////////////////////////////////////////////////////////////////
+class CPUSolver : public Solver {
+protected:
+	SolverSettings settings;
+	Domain domain;
+	UpdateCoefficients coefficients;	//Per cell update of domain - Recomputed whenever cell types or material change.
+	MaterialRamp materialRamp;
+	int width;
+	int height;
+
+	std::vector<float> pressure[2];		//Pressure planes - Alternately hold timestep n & n-1.
+	int currentPlane = 0;				//Plane holding timestep n.
+	float excitationPoint[2];			//Fractional cell coordinates the excitation rests at between paths - Whole numbers are cell centres.
+	float listenerPoint[2];
+	CellProbe excitationProbe;			//Cells of the resting points.
+	CellProbe listenerProbe;
+	const float* excitationPath = NULL;	//[x, y] of every step of the current process() call, see setProbePaths() - NULL while resting.
+	const float* listenerPath = NULL;
+
+	//Compute next timestep for rows [rowBegin, rowEnd), writing over previous timestep in place - Only interior rows and columns are updated//
+	virtual void computeRows(const float* current, float* previous, int rowBegin, int rowEnd);
+
+	//Scalar update of cells [xBegin, xEnd) of row y - Also used for the tails vectorised kernels can't cover//
+	//Cell types and coefficients of plane index i are read at i + cellOffset, so windows of rows can be passed with an offset//
+	void computeSpan(const float* current, float* previous, int cellOffset, int y, int xBegin, int xEnd);
+
+	//Glide material over the next steps of a block of numSamples, recomputing coefficients if it moved - Returns the steps to run before calling again//
+	virtual int rampMaterial(int numSamples);
+
+	//Probes of step n of the current process() call - Following the path if there is one, otherwise resting//
+	CellProbe getExcitationProbe(int n) const;
+	CellProbe getListenerProbe(int n) const;
+
+	//Rest the probes at the last of numSamples points of their paths, which are dropped//
+	void endPaths(int numSamples);
+
+	//Move the resting excitation or listener, recomputing its probe//
+	void setExcitationPoint(float x, float y);
+	void setListenerPoint(float x, float y);
+
+	//Excitation and listener for step n, after next timestep was computed into plane//
+	void finishStep(float* next, int n, float excitation, float& output);
+
+	//Step a domain built elsewhere rather than settings' own - Its size must match settings' domainSize//
+	CPUSolver(const SolverSettings& aSettings, const Domain& aDomain);
+
+public:
+	CPUSolver(const SolverSettings& aSettings);
+
+	virtual const char* getName() const;
+	virtual void process(const float* excitation, float* output, int numSamples);
+	void setExcitationPosition(float x, float y);
+	void setProbePaths(const float* aExcitationPath, const float* aListenerPath);
+	bool isProbePathFollowed() const;
+	void setMaterial(float propagation, float damping, float boundaryGain);
+	double getEnergy();
+	void getField(float* field);
+	void setField(const float* field);
+};
@@ -0,0 +1,168 @@
+#include "domain.h"
+
+#include <algorithm>
+
+Domain buildRectangleDomain(int width, int height)
+{
+	Domain domain;
+	domain.width = width;
+	domain.height = height;
+	domain.cellTypes.assign(width * height, 0);		//Regular points.
+
+	//Add rows of wall points on bottom and top//
+	for (int x = 0; x != width; ++x)
+	{
+		domain.cellTypes[x] = CELL_WALL;
+		domain.cellTypes[(height - 1) * width + x] = CELL_WALL;
+	}
+
+	//Add columns of wall points on left and right//
+	for (int y = 0; y != height; ++y)
+	{
+		domain.cellTypes[y * width] = CELL_WALL;
+		domain.cellTypes[y * width + width - 1] = CELL_WALL;
+	}
+
+	return domain;
+}
+
+void fillMaterial(Domain& domain, float propagation, float damping, float boundaryGain)
+{
+	domain.propagation.assign(domain.width * domain.height, propagation);
+	domain.damping.assign(domain.width * domain.height, damping);
+	domain.boundaryGain.assign(domain.width * domain.height, boundaryGain);
+}
+
+//Summed reflection gain of a cell's wall neighbours, and how many of them aren't free edges//
+static void sumReflections(const Domain& domain, int i, double& reflection, int& numAdjustable)
+{
+	//Neighbours [left, up, right, down]//
+	const int offsets[4] = { -1, domain.width, 1, -domain.width };
+	double gains[4] = { 0.0, 0.0, 0.0, 0.0 };
+	numAdjustable = 0;
+	for (int k = 0; k != 4; ++k)
+	{
+		uint8_t neighbourType = domain.cellTypes[i + offsets[k]];
+		if (!(neighbourType & CELL_WALL))
+			continue;
+		gains[k] = getReflectionGain(neighbourType, domain.boundaryGain[i + offsets[k]]);
+		if (!(neighbourType & CELL_FREE_EDGE))
+			++numAdjustable;
+	}
+
+	//Paired as the kernels pair neighbours, so mirrored cells get identical coefficients - Rounded to the float computeMaterialTexels() hands the GPU, so every backend folds in the same sum//
+	reflection = (float)((gains[0] + gains[2]) + (gains[1] + gains[3]));
+}
+
+UpdateCoefficients computeUpdateCoefficients(const Domain& domain)
+{
+	UpdateCoefficients coefficients;
+	computeUpdateCoefficients(domain, MaterialOffset(), coefficients);
+	return coefficients;
+}
+
+void computeUpdateCoefficients(const Domain& domain, const MaterialOffset& offset, UpdateCoefficients& coefficients)
+{
+	int width = domain.width;
+	int numCells = domain.width * domain.height;
+	coefficients.centre.assign(numCells, 0.0f);
+	coefficients.previous.assign(numCells, 0.0f);
+	coefficients.neighbour.assign(numCells, 0.0f);
+
+	for (int y = 1; y < domain.height - 1; ++y)
+	{
+		for (int x = 1; x < width - 1; ++x)
+		{
+			int i = y * width + x;
+			if (domain.cellTypes[i] & CELL_WALL)
+				continue;
+
+			//Each wall neighbour reflects this cell's pressure back by its gain//
+			double reflection;
+			int numAdjustable;
+			sumReflections(domain, i, reflection, numAdjustable);
+			reflection += numAdjustable * (double)offset.boundaryGain;
+
+			//Worked in double with true divisions so only the final coefficients round - The coefficient shaders do the same//
+			double prop = std::min(std::max((double)domain.propagation[i] + offset.propagation, 0.0), 0.5);
+			double damp = std::max((double)domain.damping[i] + offset.damping, 0.0);
+			coefficients.centre[i] = (float)((2.0 - 4.0 * prop + prop * reflection) / (1.0 + damp));
+			coefficients.previous[i] = (float)((damp - 1.0) / (1.0 + damp));
+			coefficients.neighbour[i] = (float)(prop / (1.0 + damp));
+		}
+	}
+}
+
+double computeFieldEnergy(const Domain& domain, const float* current, const float* previous)
+{
+	int width = domain.width;
+	double energy = 0.0;
+	for (int y = 1; y < domain.height - 1; ++y)
+	{
+		for (int x = 1; x < width - 1; ++x)
+		{
+			int i = y * width + x;
+			if (domain.cellTypes[i] & CELL_WALL)
+				continue;
+
+			double velocity = current[i] - previous[i];
+			energy += velocity * velocity;
+
+			//Each pair of regular neighbours counted once//
+			if (x + 1 < width - 1 && !(domain.cellTypes[i + 1] & CELL_WALL))
+				energy += (double)(current[i + 1] - current[i]) * (current[i + 1] - current[i]);
+			if (y + 1 < domain.height - 1 && !(domain.cellTypes[i + width] & CELL_WALL))
+				energy += (double)(current[i + width] - current[i]) * (current[i + width] - current[i]);
+		}
+	}
+	return energy;
+}
+
+std::vector<float> computeMaterialTexels(const Domain& domain)
+{
+	int width = domain.width;
+	std::vector<float> texels(domain.width * domain.height * 4, 0.0f);
+	for (size_t i = 0; i != domain.cellTypes.size(); ++i)
+		texels[i * 4 + 3] = -1.0f;
+
+	for (int y = 1; y < domain.height - 1; ++y)
+	{
+		for (int x = 1; x < width - 1; ++x)
+		{
+			int i = y * width + x;
+			if (domain.cellTypes[i] & CELL_WALL)
+				continue;
+
+			double reflection;
+			int numAdjustable;
+			sumReflections(domain, i, reflection, numAdjustable);
+			texels[i * 4 + 0] = domain.propagation[i];
+			texels[i * 4 + 1] = domain.damping[i];
+			texels[i * 4 + 2] = (float)reflection;
+			texels[i * 4 + 3] = (float)numAdjustable;
+		}
+	}
+	return texels;
+}
+
+CellProbe computeCellProbe(const Domain& domain, float x, float y)
+{
+	x = std::min(std::max(x, 0.0f), (float)(domain.width - 1));
+	y = std::min(std::max(y, 0.0f), (float)(domain.height - 1));
+
+	//Lower left cell, kept off the last column and row so its neighbours stay on the grid - Their weight is 0 when the point is whole//
+	int cellX = std::min((int)x, domain.width - 2);
+	int cellY = std::min((int)y, domain.height - 2);
+	float fractionX = x - (float)cellX;
+	float fractionY = y - (float)cellY;
+
+	CellProbe probe;
+	for (int k = 0; k != 4; ++k)
+	{
+		int dx = k & 1;
+		int dy = k >> 1;
+		probe.index[k] = (cellY + dy) * domain.width + cellX + dx;
+		probe.weight[k] = (dx ? fractionX : 1.0f - fractionX) * (dy ? fractionY : 1.0f - fractionY) * getTransmission(domain.cellTypes[probe.index[k]]);
+	}
+	return probe;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+///////////
+//DEFINES//
+///////////
+
+//Cell type bits - A cell with none set is a regular interior point//
+#define CELL_WALL			0x01	//Boundary point - Neighbours reflect their own pressure off it, scaled by boundaryGain.
+#define CELL_FREE_EDGE		0x02	//Wall that always reflects fully, whatever boundaryGain is - Only meaningful with CELL_WALL.
+#define CELL_EXCITATION		0x04	//Fixed excitation point - The moving excitation point is passed to solvers separately.
+#define CELL_LISTENER		0x08	//Audio sampling point - Marked by solvers for visualisation and checkpoints.
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//Domain - Point types and material of the simulation grid shared by every backend. Row  //
+//major from the bottom row, so cell (x, y) is at index y * width + x, matching the      //
+//texture layout. Material planes are empty until filled, then hold a value per cell.    //
+///////////////////////////////////////////////////////////////////////////////////////////
+struct Domain {
+	int width = 0;
+	int height = 0;
+	std::vector<uint8_t> cellTypes;		//CELL_ bits of every cell - One byte per cell, read alongside the pressure planes.
+	std::vector<float> propagation;		//Propagation factor of every cell - Must be <= 0.5.
+	std::vector<float> damping;			//Damping factor of every cell.
+	std::vector<float> boundaryGain;	//Reflection gain of every wall cell - Ignored for regular points and free edges.
+};
+
+//Update coefficients of every cell - p_next = centre * p + previous * p_prev + neighbour * sum of regular neighbours' p.//
+//Material and the reflections off wall neighbours are folded in and pre-divided by 1 + damping, so a step needs no divides//
+//and a heterogeneous material costs no more than a uniform one. Walls are all zero.                                      //
+struct UpdateCoefficients {
+	std::vector<float> centre;
+	std::vector<float> previous;
+	std::vector<float> neighbour;
+};
+
+//Uniform change applied over every cell's material, e.g. while the drum is played - Clamped so propagation stays in [0, 0.5] and damping >= 0//
+struct MaterialOffset {
+	float propagation = 0.0f;
+	float damping = 0.0f;
+	float boundaryGain = 0.0f;		//Added to the gain of every wall but free edges.
+};
+
+//Transmission value of the fbo shader's original float channel - 1 for regular point, 0 for wall//
+inline float getTransmission(uint8_t cellType)
+{
+	return (cellType & CELL_WALL) ? 0.0f : 1.0f;
+}
+
+//Gain a neighbour's pressure is reflected with off this cell, if it is a wall//
+inline float getReflectionGain(uint8_t cellType, float boundaryGain)
+{
+	return (cellType & CELL_FREE_EDGE) ? 1.0f : boundaryGain;
+}
+
+//Bilinear probe - The 4 cells around a point between cell centres, weighted by how close the point is to each. Walls weigh 0, so a//
+//strike beside a wall only reaches into the drum and a listener beside one fades out rather than reading the wall//
+struct CellProbe {
+	int index[4];		//[lower left, lower right, upper left, upper right].
+	float weight[4];
+};
+
+//Rectangle of regular points enclosed by a single cell wide wall - Material planes are left empty//
+Domain buildRectangleDomain(int width, int height);
+
+//Fill the material planes with uniform values//
+void fillMaterial(Domain& domain, float propagation, float damping, float boundaryGain);
+
+//Coefficients for the domain's cell types and material - Recompute whenever either changes//
+UpdateCoefficients computeUpdateCoefficients(const Domain& domain);
+
+//Recompute coefficients in place with offset over the domain's material - Planes are reused, so this is cheap enough to call every few steps//
+void computeUpdateCoefficients(const Domain& domain, const MaterialOffset& offset, UpdateCoefficients& coefficients);
+
+//Field energy metric of a timestep - Sum of every regular cell's squared change since the previous step and squared differences to its regular right and up neighbours.//
+//Zero only for a still, flat field, whatever its level, so a membrane resting off centre counts as silent. Walls and the outer ring are excluded//
+double computeFieldEnergy(const Domain& domain, const float* current, const float* previous);
+
+//Material of every cell as 4 floats [propagation, damping, summed reflection gain of wall neighbours, number of those walls offset applies to]//
+//For GPU backends, which fold it and an offset into coefficients themselves - The same sums computeUpdateCoefficients() forms, [0, 0, 0, -1] for cells never updated//
+std::vector<float> computeMaterialTexels(const Domain& domain);
+
+//Probe at fractional cell coordinates [x, y], whole numbers at cell centres - Clamped to the grid. A whole cell puts its full weight on that cell//
+CellProbe computeCellProbe(const Domain& domain, float x, float y);
@@ -0,0 +1,846 @@
+#include "domainBuilder.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <SFML/Graphics/Image.hpp>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include "tracer.h"
+
+//////////
+//Shapes//
+//////////
+
+//Signed distance field in normalised domain coordinates - Negative inside. Only the sign decides a cell, so distances need not be exact//
+class Shape {
+public:
+	virtual ~Shape() {}
+	virtual float distance(float x, float y) const = 0;
+};
+
+class CircleShape : public Shape {
+private:
+	float centre[2];
+	float radius;
+
+public:
+	CircleShape(float aX, float aY, float aRadius) : centre{ aX, aY }, radius(aRadius) {}
+
+	float distance(float x, float y) const
+	{
+		return std::hypot(x - centre[0], y - centre[1]) - radius;
+	}
+};
+
+class EllipseShape : public Shape {
+private:
+	float centre[2];
+	float radius[2];
+
+public:
+	EllipseShape(float aX, float aY, float aRadiusX, float aRadiusY) : centre{ aX, aY }, radius{ aRadiusX, aRadiusY } {}
+
+	//Distance in the circle the ellipse is scaled from, rescaled by the shorter radius//
+	float distance(float x, float y) const
+	{
+		return (std::hypot((x - centre[0]) / radius[0], (y - centre[1]) / radius[1]) - 1.0f) * std::min(radius[0], radius[1]);
+	}
+};
+
+class RectangleShape : public Shape {
+private:
+	float centre[2];
+	float halfSize[2];
+
+public:
+	RectangleShape(float aX0, float aY0, float aX1, float aY1) : centre{ (aX0 + aX1) * 0.5f, (aY0 + aY1) * 0.5f }, halfSize{ std::fabs(aX1 - aX0) * 0.5f, std::fabs(aY1 - aY0) * 0.5f } {}
+
+	float distance(float x, float y) const
+	{
+		float dx = std::fabs(x - centre[0]) - halfSize[0];
+		float dy = std::fabs(y - centre[1]) - halfSize[1];
+		return std::hypot(std::max(dx, 0.0f), std::max(dy, 0.0f)) + std::min(std::max(dx, dy), 0.0f);
+	}
+};
+
+class PolygonShape : public Shape {
+private:
+	std::vector<float> points;	//x, y pairs of the vertices in order.
+
+public:
+	PolygonShape(const std::vector<float>& aPoints) : points(aPoints) {}
+
+	//Nearest edge distance, negated inside by the crossing number//
+	float distance(float x, float y) const
+	{
+		int numPoints = (int)points.size() / 2;
+		float nearest = INFINITY;
+		bool isInside = false;
+		for (int i = 0, j = numPoints - 1; i != numPoints; j = i++)
+		{
+			float ax = points[j * 2], ay = points[j * 2 + 1];
+			float bx = points[i * 2], by = points[i * 2 + 1];
+			float ex = bx - ax, ey = by - ay;
+			float wx = x - ax, wy = y - ay;
+			float edgeLength = ex * ex + ey * ey;
+			float t = edgeLength > 0.0f ? std::min(std::max((wx * ex + wy * ey) / edgeLength, 0.0f), 1.0f) : 0.0f;
+			nearest = std::min(nearest, std::hypot(wx - ex * t, wy - ey * t));
+
+			if ((ay > y) != (by > y) && x < ax + (y - ay) * ex / ey)
+				isInside = !isInside;
+		}
+		return isInside ? -nearest : nearest;
+	}
+};
+
+class ImageShape : public Shape {
+private:
+	std::vector<float> luminance;	//Row major from the bottom row, matching the domain.
+	int size[2] = { 0, 0 };
+	float threshold;
+
+public:
+	std::string path;
+
+	ImageShape(const std::string& aPath, float aThreshold) : threshold(aThreshold), path(aPath) {}
+
+	//Decode the image into luminance [0-1] - Deferred so cached domains never decode//
+	bool load()
+	{
+		if (!luminance.empty())
+			return true;
+
+		sf::Image image;
+		if (!image.loadFromFile(path) || image.getSize().x == 0 || image.getSize().y == 0)
+			return false;
+
+		size[0] = (int)image.getSize().x;
+		size[1] = (int)image.getSize().y;
+		luminance.resize(size[0] * size[1]);
+		for (int y = 0; y != size[1]; ++y)
+		{
+			for (int x = 0; x != size[0]; ++x)
+			{
+				//Images are stored top row first - Transparent pixels count as black//
+				sf::Color pixel = image.getPixel(x, size[1] - 1 - y);
+				luminance[y * size[0] + x] = (0.2126f * pixel.r + 0.7152f * pixel.g + 0.0722f * pixel.b) * pixel.a / (255.0f * 255.0f);
+			}
+		}
+		return true;
+	}
+
+	//Nearest pixel's luminance//
+	float getLuminance(float x, float y) const
+	{
+		int px = std::min(std::max((int)(x * size[0]), 0), size[0] - 1);
+		int py = std::min(std::max((int)(y * size[1]), 0), size[1] - 1);
+		return luminance[py * size[0] + px];
+	}
+
+	//Inside and outside only, so the distance is a unit step//
+	float distance(float x, float y) const
+	{
+		return getLuminance(x, y) > threshold ? -1.0f : 1.0f;
+	}
+};
+
+enum CombineOperation {
+	COMBINE_UNION,
+	COMBINE_INTERSECT,
+	COMBINE_SUBTRACT
+};
+
+class CombinedShape : public Shape {
+private:
+	CombineOperation operation;
+	std::vector<Shape*> shapes;
+
+public:
+	CombinedShape(CombineOperation aOperation, const std::vector<Shape*>& aShapes) : operation(aOperation), shapes(aShapes) {}
+
+	~CombinedShape()
+	{
+		for (size_t i = 0; i != shapes.size(); ++i)
+			delete shapes[i];
+	}
+
+	float distance(float x, float y) const
+	{
+		float result = shapes[0]->distance(x, y);
+		for (size_t i = 1; i != shapes.size(); ++i)
+		{
+			float d = shapes[i]->distance(x, y);
+			switch (operation)
+			{
+			case COMBINE_UNION:		result = std::min(result, d); break;
+			case COMBINE_INTERSECT:	result = std::max(result, d); break;
+			case COMBINE_SUBTRACT:	result = std::max(result, -d); break;
+			}
+		}
+		return result;
+	}
+};
+
+////////////
+//Material//
+////////////
+
+enum MaterialParameter {
+	MATERIAL_PROPAGATION,
+	MATERIAL_DAMPING,
+	MATERIAL_GAIN,
+	NUM_OF_MATERIAL_PARAMETERS
+};
+
+static const char* materialParameterNames[NUM_OF_MATERIAL_PARAMETERS] = { "propagation", "damping", "gain" };
+
+//Value of one material parameter over a region of the domain - Later layers overwrite earlier ones//
+class MaterialLayer {
+public:
+	MaterialParameter parameter;
+	std::vector<float> values;		//Constant [value], gradient [x0, y0, v0, x1, y1, v1] or map [low, high].
+	ImageShape* map = NULL;			//Luminance scaled between values, if set.
+	Shape* region = NULL;			//Whole domain if NULL.
+
+	~MaterialLayer()
+	{
+		delete map;
+		delete region;
+	}
+
+	bool isInside(float x, float y) const
+	{
+		return region == NULL || region->distance(x, y) < 0.0f;
+	}
+
+	float getValue(float x, float y) const
+	{
+		if (map != NULL)
+			return values[0] + map->getLuminance(x, y) * (values[1] - values[0]);
+		if (values.size() == 1)
+			return values[0];
+
+		//Gradient - Position projected onto the segment, clamped to its ends//
+		float dx = values[3] - values[0];
+		float dy = values[4] - values[1];
+		float length = dx * dx + dy * dy;
+		float t = length > 0.0f ? ((x - values[0]) * dx + (y - values[1]) * dy) / length : 0.0f;
+		t = std::min(std::max(t, 0.0f), 1.0f);
+		return values[2] + t * (values[5] - values[2]);
+	}
+};
+
+//////////
+//Parser//
+//////////
+
+//Recursive descent over a shape description - Returns NULL and sets error on failure. Image shapes are collected so they can be hashed and loaded//
+class ShapeParser {
+private:
+	const std::string& text;
+	size_t position = 0;
+
+	void skipSpaces()
+	{
+		while (position < text.size() && isspace((unsigned char)text[position]))
+			++position;
+	}
+
+	bool expect(char c)
+	{
+		skipSpaces();
+		if (position < text.size() && text[position] == c)
+		{
+			++position;
+			return true;
+		}
+		if (error.empty())
+			error = std::string("Expected '") + c + "' at character " + std::to_string(position);
+		return false;
+	}
+
+	bool peek(char c)
+	{
+		skipSpaces();
+		return position < text.size() && text[position] == c;
+	}
+
+	bool parseNumber(float& value)
+	{
+		skipSpaces();
+		const char* begin = text.c_str() + position;
+		char* end;
+		value = strtof(begin, &end);
+		if (end == begin)
+		{
+			error = "Expected a number at character " + std::to_string(position);
+			return false;
+		}
+		position += end - begin;
+		return true;
+	}
+
+	bool parseNumbers(std::vector<float>& values)
+	{
+		do
+		{
+			float value;
+			if (!parseNumber(value))
+				return false;
+			values.push_back(value);
+		} while (peek(',') && expect(','));
+		return true;
+	}
+
+	Shape* parseCombination(CombineOperation operation)
+	{
+		std::vector<Shape*> shapes;
+		do
+		{
+			Shape* shape = parseShape();
+			if (shape == NULL)
+				break;
+			shapes.push_back(shape);
+		} while (peek(',') && expect(','));
+
+		if (!error.empty() || !expect(')'))
+		{
+			for (size_t i = 0; i != shapes.size(); ++i)
+				delete shapes[i];
+			return NULL;
+		}
+		return new CombinedShape(operation, shapes);
+	}
+
+	std::string parseName()
+	{
+		skipSpaces();
+		size_t nameBegin = position;
+		while (position < text.size() && isalpha((unsigned char)text[position]))
+			++position;
+		return text.substr(nameBegin, position - nameBegin);
+	}
+
+	//Path runs to the next comma or closing bracket//
+	std::string parsePath()
+	{
+		skipSpaces();
+		size_t end = text.find_first_of(",)", position);
+		if (end == std::string::npos)
+			end = text.size();
+		std::string path = text.substr(position, end - position);
+		while (!path.empty() && isspace((unsigned char)path.back()))
+			path.pop_back();
+		position = end;
+		return path;
+	}
+
+	//Source of a material layer - A number, gradient(x0, y0, v0, x1, y1, v1) or map(file.png, low, high)//
+	bool parseMaterialSource(MaterialLayer& layer)
+	{
+		skipSpaces();
+		if (position < text.size() && !isalpha((unsigned char)text[position]))
+		{
+			float value;
+			if (!parseNumber(value))
+				return false;
+			layer.values.push_back(value);
+			return true;
+		}
+
+		std::string name = parseName();
+		if (!expect('('))
+			return false;
+		if (name == "gradient")
+		{
+			if (!parseNumbers(layer.values) || !expect(')'))
+				return false;
+			if (layer.values.size() == 6)
+				return true;
+			error = "Gradient needs x0, y0, v0, x1, y1, v1";
+			return false;
+		}
+		if (name == "map")
+		{
+			std::string path = parsePath();
+			if (!expect(',') || !parseNumbers(layer.values) || !expect(')'))
+				return false;
+			if (path.empty() || layer.values.size() != 2)
+			{
+				error = "Map needs a file, low and high";
+				return false;
+			}
+			layer.map = new ImageShape(path, 0.5f);
+			images.push_back(layer.map);
+			return true;
+		}
+		error = "Unknown material source " + name;
+		return false;
+	}
+
+	Shape* parseImage()
+	{
+		std::string path = parsePath();
+
+		float threshold = 0.5f;
+		if (peek(',') && (!expect(',') || !parseNumber(threshold)))
+			return NULL;
+		if (path.empty())
+		{
+			error = "Image shape needs a file";
+			return NULL;
+		}
+		if (!expect(')'))
+			return NULL;
+
+		ImageShape* image = new ImageShape(path, threshold);
+		images.push_back(image);
+		return image;
+	}
+
+public:
+	std::string error;
+	std::vector<ImageShape*> images;
+
+	ShapeParser(const std::string& aText) : text(aText) {}
+
+	Shape* parseShape()
+	{
+		std::string name = parseName();
+		if (!expect('('))
+			return NULL;
+
+		if (name == "union")
+			return parseCombination(COMBINE_UNION);
+		if (name == "intersect")
+			return parseCombination(COMBINE_INTERSECT);
+		if (name == "subtract")
+			return parseCombination(COMBINE_SUBTRACT);
+		if (name == "image")
+			return parseImage();
+
+		std::vector<float> values;
+		if (!parseNumbers(values) || !expect(')'))
+			return NULL;
+
+		if (name == "circle" && values.size() == 3)
+			return new CircleShape(values[0], values[1], values[2]);
+		if (name == "ellipse" && values.size() == 4)
+			return new EllipseShape(values[0], values[1], values[2], values[3]);
+		if (name == "rect" && values.size() == 4)
+			return new RectangleShape(values[0], values[1], values[2], values[3]);
+		if (name == "polygon" && values.size() >= 6 && values.size() % 2 == 0)
+			return new PolygonShape(values);
+
+		error = "Unknown shape or wrong number of values: " + name + " with " + std::to_string(values.size());
+		return NULL;
+	}
+
+	//Whole description as one shape - Trailing text is an error//
+	Shape* parse()
+	{
+		Shape* shape = parseShape();
+		skipSpaces();
+		if (shape != NULL && position != text.size())
+		{
+			error = "Unexpected text at character " + std::to_string(position);
+			delete shape;
+			return NULL;
+		}
+		return shape;
+	}
+
+	//Whole description as material layers - parameter = source [in shape], separated by ';'. Returns false and sets error on failure, layers parsed so far are kept for the caller to delete//
+	bool parseMaterial(std::vector<MaterialLayer*>& layers)
+	{
+		do
+		{
+			std::string name = parseName();
+			MaterialLayer* layer = new MaterialLayer();
+			layers.push_back(layer);
+			layer->parameter = NUM_OF_MATERIAL_PARAMETERS;
+			for (int i = 0; i != NUM_OF_MATERIAL_PARAMETERS; ++i)
+			{
+				if (name == materialParameterNames[i])
+					layer->parameter = (MaterialParameter)i;
+			}
+			if (layer->parameter == NUM_OF_MATERIAL_PARAMETERS)
+			{
+				error = "Unknown material parameter " + name;
+				return false;
+			}
+			if (!expect('=') || !parseMaterialSource(*layer))
+				return false;
+
+			//Optional region//
+			skipSpaces();
+			if (text.compare(position, 2, "in") == 0)
+			{
+				position += 2;
+				layer->region = parseShape();
+				if (layer->region == NULL)
+					return false;
+			}
+		} while (peek(';') && expect(';'));
+
+		skipSpaces();
+		if (position != text.size())
+		{
+			error = "Unexpected text at character " + std::to_string(position);
+			return false;
+		}
+		return true;
+	}
+};
+
+/////////
+//Cache//
+/////////
+
+//FNV-1a - Only needs to tell shape descriptions apart, the full key is checked on load//
+static uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 0xCBF29CE484222325ULL)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	for (size_t i = 0; i != size; ++i)
+		hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+	return hash;
+}
+
+//Hash of a file's contents, so an edited image invalidates its cached domains - 0 if unreadable//
+static uint64_t hashFile(const std::string& path)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == NULL)
+		return 0;
+
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	char buffer[65536];
+	size_t count;
+	while ((count = fread(buffer, 1, sizeof(buffer), file)) != 0)
+		hash = hashBytes(buffer, count, hash);
+	fclose(file);
+	return hash;
+}
+
+static std::string getCachePath(const std::string& key)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.dom", (unsigned long long)hashBytes(key.data(), key.size()));
+	return std::string(DOMAIN_CACHE_DIRECTORY) + "/" + name;
+}
+
+struct DomainCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	int32_t width;
+	int32_t height;
+	uint32_t keySize;			//Bytes of key following the header, then width * height cell types.
+};
+
+static bool loadCachedDomain(const std::string& key, Domain& domain)
+{
+	FILE* file = fopen(getCachePath(key).c_str(), "rb");
+	if (file == NULL)
+		return false;
+
+	DomainCacheHeader header;
+	bool isValid = fread(&header, sizeof(header), 1, file) == 1 && header.magic == DOMAIN_CACHE_MAGIC && header.version == DOMAIN_CACHE_VERSION
+		&& header.width == domain.width && header.height == domain.height && header.keySize == key.size();
+	if (isValid)
+	{
+		std::string storedKey(key.size(), '\0');
+		domain.cellTypes.resize(domain.width * domain.height);
+		isValid = fread(&storedKey[0], 1, key.size(), file) == key.size() && storedKey == key
+			&& fread(&domain.cellTypes[0], 1, domain.cellTypes.size(), file) == domain.cellTypes.size();
+	}
+	fclose(file);
+	return isValid;
+}
+
+static void saveCachedDomain(const std::string& key, const Domain& domain)
+{
+#ifdef _WIN32
+	_mkdir(DOMAIN_CACHE_DIRECTORY);
+#else
+	mkdir(DOMAIN_CACHE_DIRECTORY, 0755);
+#endif
+
+	FILE* file = fopen(getCachePath(key).c_str(), "wb");
+	if (file == NULL)
+		return;
+
+	DomainCacheHeader header = { DOMAIN_CACHE_MAGIC, DOMAIN_CACHE_VERSION, domain.width, domain.height, (uint32_t)key.size() };
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(key.data(), 1, key.size(), file);
+	fwrite(&domain.cellTypes[0], 1, domain.cellTypes.size(), file);
+	fclose(file);
+}
+
+/////////////////
+//Rasterisation//
+/////////////////
+
+static void rasteriseRows(const Shape& shape, Domain& domain, int rowBegin, int rowEnd)
+{
+	for (int y = rowBegin; y != rowEnd; ++y)
+	{
+		float v = (y + 0.5f) / domain.height;
+		for (int x = 0; x != domain.width; ++x)
+		{
+			float u = (x + 0.5f) / domain.width;
+			domain.cellTypes[y * domain.width + x] = shape.distance(u, v) < 0.0f ? 0 : CELL_WALL;
+		}
+	}
+}
+
+static void applyMaterialRows(const std::vector<MaterialLayer*>& layers, Domain& domain, int rowBegin, int rowEnd)
+{
+	std::vector<float>* planes[NUM_OF_MATERIAL_PARAMETERS] = { &domain.propagation, &domain.damping, &domain.boundaryGain };
+	for (int y = rowBegin; y != rowEnd; ++y)
+	{
+		float v = (y + 0.5f) / domain.height;
+		for (int x = 0; x != domain.width; ++x)
+		{
+			float u = (x + 0.5f) / domain.width;
+			for (size_t l = 0; l != layers.size(); ++l)
+			{
+				if (layers[l]->isInside(u, v))
+					(*planes[layers[l]->parameter])[y * domain.width + x] = layers[l]->getValue(u, v);
+			}
+		}
+	}
+}
+
+//Run rows(rowBegin, rowEnd) over the domain in row bands - Across every hardware thread for large grids, the calling thread taking the first band//
+template <typename RowFunction>
+static void runRowBands(const Domain& domain, RowFunction rows)
+{
+	int numThreads = 1;
+	if (domain.width * domain.height >= DOMAIN_PARALLEL_CELLS)
+		numThreads = std::max(1, std::min((int)std::thread::hardware_concurrency(), domain.height));
+
+	std::vector<std::thread> workers;
+	for (int t = 1; t < numThreads; ++t)
+		workers.push_back(std::thread(rows, domain.height * t / numThreads, domain.height * (t + 1) / numThreads));
+	rows(0, domain.height / numThreads);
+	for (size_t i = 0; i != workers.size(); ++i)
+		workers[i].join();
+}
+
+static void rasterise(const Shape& shape, Domain& domain)
+{
+	runRowBands(domain, [&](int rowBegin, int rowEnd) { rasteriseRows(shape, domain, rowBegin, rowEnd); });
+
+	//Outer ring is never computed, so always wall//
+	for (int x = 0; x != domain.width; ++x)
+	{
+		domain.cellTypes[x] = CELL_WALL;
+		domain.cellTypes[(domain.height - 1) * domain.width + x] = CELL_WALL;
+	}
+	for (int y = 0; y != domain.height; ++y)
+	{
+		domain.cellTypes[y * domain.width] = CELL_WALL;
+		domain.cellTypes[y * domain.width + domain.width - 1] = CELL_WALL;
+	}
+}
+
+bool validateShape(const std::string& shape, std::string& error)
+{
+	ShapeParser parser(shape);
+	Shape* root = parser.parse();
+	error = parser.error;
+	for (size_t i = 0; root != NULL && i != parser.images.size(); ++i)
+	{
+		if (!parser.images[i]->load())
+		{
+			error = "Failed to load image " + parser.images[i]->path;
+			break;
+		}
+	}
+	delete root;
+	return error.empty();
+}
+
+bool validateMaterial(const std::string& material, std::string& error)
+{
+	ShapeParser parser(material);
+	std::vector<MaterialLayer*> layers;
+	parser.parseMaterial(layers);
+	error = parser.error;
+	for (size_t i = 0; error.empty() && i != parser.images.size(); ++i)
+	{
+		if (!parser.images[i]->load())
+			error = "Failed to load image " + parser.images[i]->path;
+	}
+	for (size_t i = 0; i != layers.size(); ++i)
+		delete layers[i];
+	return error.empty();
+}
+
+//Cell types of shape, from the cache if it was rasterised before//
+static Domain buildShapeDomain(const std::string& shape, int width, int height)
+{
+	if (shape.empty())
+		return buildRectangleDomain(width, height);
+
+	TRACE_SCOPE("buildDomain");
+
+	ShapeParser parser(shape);
+	Shape* root = parser.parse();
+	if (root == NULL)
+	{
+		std::cout << "Invalid domain shape - " << parser.error << ". Using rectangle." << std::endl;
+		return buildRectangleDomain(width, height);
+	}
+
+	//Key is everything the result depends on - Images by content, not name//
+	std::string key = std::to_string(width) + "x" + std::to_string(height) + " " + shape;
+	for (size_t i = 0; i != parser.images.size(); ++i)
+	{
+		char imageHash[24];
+		snprintf(imageHash, sizeof(imageHash), " %016llx", (unsigned long long)hashFile(parser.images[i]->path));
+		key += imageHash;
+	}
+
+	Domain domain;
+	domain.width = width;
+	domain.height = height;
+	if (!loadCachedDomain(key, domain))
+	{
+		bool isLoaded = true;
+		for (size_t i = 0; i != parser.images.size(); ++i)
+		{
+			if (!parser.images[i]->load())
+			{
+				std::cout << "Failed to load image " << parser.images[i]->path << ". Using rectangle." << std::endl;
+				isLoaded = false;
+			}
+		}
+		if (!isLoaded)
+		{
+			delete root;
+			return buildRectangleDomain(width, height);
+		}
+
+		domain.cellTypes.assign(width * height, 0);
+		rasterise(*root, domain);
+		saveCachedDomain(key, domain);
+	}
+
+	delete root;
+	return domain;
+}
+
+//Overwrite domain's uniform material with a material map's layers - Invalid maps leave it uniform//
+static void applyMaterialMap(Domain& domain, const std::string& materialMap)
+{
+	TRACE_SCOPE("buildMaterial");
+
+	ShapeParser parser(materialMap);
+	std::vector<MaterialLayer*> layers;
+	bool isValid = parser.parseMaterial(layers);
+	for (size_t i = 0; isValid && i != parser.images.size(); ++i)
+	{
+		if (!parser.images[i]->load())
+		{
+			parser.error = "Failed to load image " + parser.images[i]->path;
+			isValid = false;
+		}
+	}
+
+	if (isValid)
+		runRowBands(domain, [&](int rowBegin, int rowEnd) { applyMaterialRows(layers, domain, rowBegin, rowEnd); });
+	else
+		std::cout << "Invalid material map - " << parser.error << ". Using uniform material." << std::endl;
+
+	for (size_t i = 0; i != layers.size(); ++i)
+		delete layers[i];
+}
+
+//Grade damping up towards the grid's edges over thickness cells - Proportional to each cell's wave speed per step, so the sponge absorbs alike whatever the material or step rate//
+static void applySpongeLayer(Domain& domain, int thickness)
+{
+	for (int y = 1; y < domain.height - 1; ++y)
+	{
+		for (int x = 1; x < domain.width - 1; ++x)
+		{
+			//Cells from the outer ring of walls - 1 for the outermost cell updated//
+			int edgeDistance = std::min(std::min(x, y), std::min(domain.width - 1 - x, domain.height - 1 - y));
+			if (edgeDistance > thickness)
+				continue;
+			int i = y * domain.width + x;
+			double depth = (double)(thickness + 1 - edgeDistance) / (double)thickness;
+			domain.damping[i] += (float)(SPONGE_LAYER_PEAK * std::sqrt((double)domain.propagation[i]) * std::pow(depth, SPONGE_LAYER_ORDER));
+		}
+	}
+}
+
+//First order Engquist-Majda condition on the grid's outer ring - Each side facing it lets waves out along its normal, ghosting p - (p_next - p_prev) / (2 * sqrt(propagation)).//
+//That is a fully reflecting wall plus sqrt(propagation) / 2 of damping per such side, so the ring becomes free edges and the rest is material every kernel already runs//
+static void applyAbsorbingEdges(Domain& domain)
+{
+	int width = domain.width;
+	int height = domain.height;
+	for (int y = 1; y < height - 1; ++y)
+	{
+		for (int x = 1; x < width - 1; ++x)
+		{
+			int i = y * width + x;
+			int numEdges = (x == 1) + (x == width - 2) + (y == 1) + (y == height - 2);
+			if (numEdges == 0 || (domain.cellTypes[i] & CELL_WALL))
+				continue;
+			domain.damping[i] += (float)(0.5 * numEdges * std::sqrt((double)domain.propagation[i]));
+		}
+	}
+
+	for (int x = 0; x != width; ++x)
+	{
+		domain.cellTypes[x] |= CELL_FREE_EDGE;
+		domain.cellTypes[(height - 1) * width + x] |= CELL_FREE_EDGE;
+	}
+	for (int y = 0; y != height; ++y)
+	{
+		domain.cellTypes[y * width] |= CELL_FREE_EDGE;
+		domain.cellTypes[y * width + width - 1] |= CELL_FREE_EDGE;
+	}
+}
+
+Domain buildDomain(const SolverSettings& settings)
+{
+	Domain domain = buildShapeDomain(settings.domainShape, settings.domainSize[0], settings.domainSize[1]);
+	fillMaterial(domain, settings.propagationFactor, settings.dampingFactor, settings.boundaryGain);
+	if (!settings.materialMap.empty())
+		applyMaterialMap(domain, settings.materialMap);
+
+	//Material is given per output sample - Each of several steps per sample propagates and damps proportionally less//
+	if (settings.oversampling > 1)
+	{
+		float propagationScale = 1.0f / (float)(settings.oversampling * settings.oversampling);
+		float dampingScale = 1.0f / (float)settings.oversampling;
+		for (size_t i = 0; i != domain.cellTypes.size(); ++i)
+		{
+			domain.propagation[i] *= propagationScale;
+			domain.damping[i] *= dampingScale;
+		}
+	}
+
+	//After scaling, as both follow the wave speed per step//
+	if (settings.spongeLayer > 0)
+		applySpongeLayer(domain, settings.spongeLayer);
+	if (settings.isAbsorbingEdges)
+		applyAbsorbingEdges(domain);
+	return domain;
+}
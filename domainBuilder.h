@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+
+#include "domain.h"
+#include "solver.h"
+
+///////////
+//DEFINES//
+///////////
+
+#define DOMAIN_CACHE_DIRECTORY	"DomainCache"	//Rasterised shapes are kept here between runs.
+#define DOMAIN_CACHE_MAGIC		0x4D4F4453		//"SDOM" - Identifies domain cache files.
+#define DOMAIN_CACHE_VERSION	1				//Bump whenever rasterisation or the file layout changes - Older files are then rebuilt.
+#define DOMAIN_PARALLEL_CELLS	65536			//Grids at least this large are rasterised across all hardware threads.
+#define SPONGE_LAYER_PEAK		0.3				//Damping of a sponge layer's outermost cell per unit wave speed per step.
+#define SPONGE_LAYER_ORDER		2				//Power the sponge's damping rises with depth into it.
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//Shape descriptions - Cells whose centre lies inside the shape are regular points, the rest//
+//are walls. Coordinates are normalised domain coordinates [0-1] from the bottom left, as  //
+//for the excitation position, so a circle is stretched on a non square grid.              //
+//                                                                                          //
+//  circle(cx, cy, r)                  ellipse(cx, cy, rx, ry)                              //
+//  rect(x0, y0, x1, y1)               polygon(x0, y0, x1, y1, x2, y2, ...)                 //
+//  image(file.png[, threshold])       Pixels brighter than threshold [0-1, default 0.5]    //
+//                                     are inside. The image is stretched over the grid.    //
+//  union(a, b, ...)                   intersect(a, b, ...)                                 //
+//  subtract(a, b, ...)                a with b and any further shapes cut out              //
+//                                                                                          //
+//e.g. subtract(circle(0.5, 0.5, 0.45), circle(0.5, 0.5, 0.1)) is an annular drum head. The //
+//outer ring of cells is always wall, as no backend computes it.                            //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//Material maps - Layers separated by ';', each setting a parameter over the domain or the   //
+//region of a shape. Later layers overwrite earlier ones, starting from SolverSettings' own  //
+//uniform values.                                                                            //
+//                                                                                           //
+//  parameter = source [in shape]      parameter is propagation, damping or gain [of walls]  //
+//  number                             Constant.                                             //
+//  gradient(x0, y0, v0, x1, y1, v1)   Linear from v0 at (x0, y0) to v1 at (x1, y1).         //
+//  map(file.png, low, high)           Image luminance scaled to [low, high].                //
+//                                                                                           //
+//e.g. damping = 0.005 in circle(0.3, 0.3, 0.1); propagation = gradient(0, 0, 0.2, 1, 0, 0.4)//
+//tightens a drum from left to right with a damped patch. Propagation must stay <= 0.5.      //
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+//Check a shape description parses and its images load - error describes the first problem//
+bool validateShape(const std::string& shape, std::string& error);
+
+//Check a material map parses and its images load - error describes the first problem//
+bool validateMaterial(const std::string& material, std::string& error);
+
+//Domain of settings' shape and material - Cell types are rasterised from domainShape, an empty shape being the full rectangle, and the material planes filled from materialMap over the uniform settings, then scaled to the oversampled step rate.//
+//isAbsorbingEdges applies a first order Engquist-Majda condition at the grid's outer ring, and a spongeLayer grades damping up over that many cells inside it, see SPONGE_LAYER_PEAK//
+//Cell types are cached in DOMAIN_CACHE_DIRECTORY keyed by the shape, grid size and image contents, so relaunching a preset reads the cache instead. Invalid descriptions fall back to the rectangle and uniform material//
+Domain buildDomain(const SolverSettings& settings);
@@ -0,0 +1,178 @@
+#include "fft.h"
+
+#include <cmath>
+
+static const double pi = 3.14159265358979323846;
+
+FFT::FFT(int aSize) : size(aSize)
+{
+	paddedSize = 1;
+	while (paddedSize < size)
+		paddedSize *= 2;
+
+	//Bluestein's convolution of the chirp needs room for 2 * size - 1 values without wrapping//
+	if (paddedSize != size)
+	{
+		paddedSize = 1;
+		while (paddedSize < 2 * size - 1)
+			paddedSize *= 2;
+
+		//n^2 taken modulo 2 * size keeps the angle accurate for long transforms//
+		chirp.resize(size);
+		for (int n = 0; n != size; ++n)
+		{
+			long long square = ((long long)n * n) % (2 * (long long)size);
+			chirp[n] = std::polar(1.0, -pi * (double)square / (double)size);
+		}
+	}
+
+	twiddles.resize(paddedSize / 2);
+	for (int k = 0; k != paddedSize / 2; ++k)
+		twiddles[k] = std::polar(1.0, -2.0 * pi * k / paddedSize);
+
+	if (!chirp.empty())
+	{
+		chirpSpectrum.assign(paddedSize, std::complex<double>(0.0, 0.0));
+		chirpSpectrum[0] = std::conj(chirp[0]);
+		for (int n = 1; n != size; ++n)
+		{
+			chirpSpectrum[n] = std::conj(chirp[n]);
+			chirpSpectrum[paddedSize - n] = std::conj(chirp[n]);
+		}
+		transformRadix2(&chirpSpectrum[0], false);
+		work.resize(paddedSize);
+	}
+}
+
+void FFT::transformRadix2(std::complex<double>* data, bool isInverse) const
+{
+	//Bit reversed order//
+	for (int i = 1, j = 0; i < paddedSize; ++i)
+	{
+		int bit = paddedSize >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		if (i < j)
+			std::swap(data[i], data[j]);
+	}
+
+	for (int length = 2; length <= paddedSize; length *= 2)
+	{
+		int half = length / 2;
+		int twiddleStride = paddedSize / length;
+		for (int begin = 0; begin < paddedSize; begin += length)
+		{
+			for (int k = 0; k != half; ++k)
+			{
+				std::complex<double> twiddle = isInverse ? std::conj(twiddles[k * twiddleStride]) : twiddles[k * twiddleStride];
+				std::complex<double> odd = data[begin + k + half] * twiddle;
+				data[begin + k + half] = data[begin + k] - odd;
+				data[begin + k] += odd;
+			}
+		}
+	}
+}
+
+void FFT::transform(std::complex<double>* data, bool isInverse)
+{
+	if (chirp.empty())
+	{
+		transformRadix2(data, isInverse);
+		return;
+	}
+
+	//An inverse is the conjugate of the forward transform of the conjugate//
+	for (int n = 0; n != size; ++n)
+		work[n] = (isInverse ? std::conj(data[n]) : data[n]) * chirp[n];
+	for (int n = size; n != paddedSize; ++n)
+		work[n] = 0.0;
+
+	transformRadix2(&work[0], false);
+	for (int n = 0; n != paddedSize; ++n)
+		work[n] *= chirpSpectrum[n];
+	transformRadix2(&work[0], true);
+
+	double scale = 1.0 / (double)paddedSize;
+	for (int k = 0; k != size; ++k)
+	{
+		std::complex<double> value = work[k] * chirp[k] * scale;
+		data[k] = isInverse ? std::conj(value) : value;
+	}
+}
+
+ModeTransform::ModeTransform(int aNumCells, bool aIsClamped) : numCells(aNumCells), isClamped(aIsClamped), fft(aIsClamped ? 2 * (aNumCells + 1) : 2 * aNumCells)
+{
+	work.resize(fft.getSize());
+}
+
+double ModeTransform::getWavenumber(int mode) const
+{
+	return isClamped ? pi * (mode + 1) / (numCells + 1) : pi * mode / numCells;
+}
+
+double ModeTransform::getBasis(int mode, int cell) const
+{
+	if (isClamped)
+		return std::sqrt(2.0 / (numCells + 1)) * std::sin(pi * (double)(mode + 1) * (cell + 1) / (numCells + 1));
+	double scale = mode == 0 ? std::sqrt(1.0 / numCells) : std::sqrt(2.0 / numCells);
+	return scale * std::cos(pi * mode * (cell + 0.5) / numCells);
+}
+
+void ModeTransform::toModes(const double* cells, double* modes, int stride)
+{
+	if (isClamped)
+	{
+		//Odd extension [0, x, 0, -reversed x] - Its transform is -2i times the sine transform//
+		int length = numCells + 1;
+		work[0] = 0.0;
+		work[length] = 0.0;
+		for (int j = 0; j != numCells; ++j)
+		{
+			work[j + 1] = cells[j * stride];
+			work[2 * length - j - 1] = -cells[j * stride];
+		}
+		fft.transform(&work[0], false);
+
+		double scale = std::sqrt(2.0 / length);
+		for (int m = 0; m != numCells; ++m)
+			modes[m * stride] = -0.5 * work[m + 1].imag() * scale;
+		return;
+	}
+
+	//Even extension [x, reversed x] - Shifted by half a cell, its transform is twice the cosine transform//
+	for (int j = 0; j != numCells; ++j)
+	{
+		work[j] = cells[j * stride];
+		work[2 * numCells - j - 1] = cells[j * stride];
+	}
+	fft.transform(&work[0], false);
+
+	for (int m = 0; m != numCells; ++m)
+	{
+		double scale = m == 0 ? std::sqrt(1.0 / numCells) : std::sqrt(2.0 / numCells);
+		modes[m * stride] = 0.5 * (std::polar(1.0, -pi * m / (2.0 * numCells)) * work[m]).real() * scale;
+	}
+}
+
+void ModeTransform::toCells(const double* modes, double* cells, int stride)
+{
+	//The orthonormal sine transform is its own inverse//
+	if (isClamped)
+	{
+		toModes(modes, cells, stride);
+		return;
+	}
+
+	for (int m = 0; m != numCells; ++m)
+	{
+		double scale = m == 0 ? std::sqrt(1.0 / numCells) : std::sqrt(2.0 / numCells);
+		work[m] = modes[m * stride] * scale * std::polar(1.0, pi * m / (2.0 * numCells));
+	}
+	for (int m = numCells; m != 2 * numCells; ++m)
+		work[m] = 0.0;
+	fft.transform(&work[0], true);
+
+	for (int j = 0; j != numCells; ++j)
+		cells[j * stride] = work[j].real();
+}
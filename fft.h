@@ -0,0 +1,61 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//FFT - Complex discrete Fourier transform of any length. Powers of 2 run an iterative      //
+//radix 2 transform, other lengths Bluestein's algorithm over a padded power of 2, so a    //
+//transform is O(n log n) whatever the grid size. Not thread safe - Transforms share work. //
+//////////////////////////////////////////////////////////////////////////////////////////////
+class FFT {
+private:
+	int size;
+	int paddedSize;							//Power of 2 the radix 2 transform runs at - size itself when it is one.
+	std::vector<std::complex<double>> twiddles;	//e^(-2 pi i k / paddedSize) for k < paddedSize / 2.
+	std::vector<std::complex<double>> chirp;	//e^(-i pi n^2 / size) for n < size - Bluestein only.
+	std::vector<std::complex<double>> chirpSpectrum;	//Radix 2 transform of the conjugate chirp wrapped around paddedSize - Bluestein only.
+	std::vector<std::complex<double>> work;
+
+	//In place radix 2 transform of paddedSize values - Unscaled, with e^(+2 pi i) twiddles if isInverse//
+	void transformRadix2(std::complex<double>* data, bool isInverse) const;
+
+public:
+	FFT(int aSize);
+
+	int getSize() const { return size; }
+
+	//In place transform of getSize() values - Forward uses e^(-2 pi i nk / size), inverse e^(+2 pi i nk / size), neither scaled//
+	void transform(std::complex<double>* data, bool isInverse);
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//ModeTransform - Orthonormal transform between a line of cells between two walls and its  //
+//standing wave modes, matching the FDTD scheme's walls. A boundary gain of 0 holds the    //
+//walls at zero - A sine transform (DST-I). A gain of 1 mirrors the cell beside each wall  //
+//into it - A cosine transform (DCT-II, inverse DCT-III). Both run through an FFT of twice //
+//the line, so they are their own inverse up to the transpose.                              //
+//////////////////////////////////////////////////////////////////////////////////////////////
+class ModeTransform {
+private:
+	int numCells;
+	bool isClamped;						//Walls held at zero - Otherwise mirrored.
+	FFT fft;
+	std::vector<std::complex<double>> work;
+
+public:
+	//numCells between the walls - isClamped for a boundary gain of 0, otherwise 1//
+	ModeTransform(int aNumCells, bool aIsClamped);
+
+	int getNumCells() const { return numCells; }
+
+	//Spatial frequency of a mode in radians per cell - Mode 0 is the lowest//
+	double getWavenumber(int mode) const;
+
+	//Value of a mode's orthonormal basis vector at a cell - Cells count from 0 beside the first wall//
+	double getBasis(int mode, int cell) const;
+
+	//numCells values of cells into their modes, and back - stride steps between successive values of both, so columns of a grid can be passed//
+	void toModes(const double* cells, double* modes, int stride = 1);
+	void toCells(const double* modes, double* cells, int stride = 1);
+};
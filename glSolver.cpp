@@ -0,0 +1,543 @@
+#include "glSolver.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "shaderProgram.h"
+#include "domainBuilder.h"
+#include "tracer.h"
+
+GLSolver::GLSolver(const SolverSettings& aSettings) : settings(aSettings), materialRamp(aSettings), simulateTimer(STAGE_SIMULATE), audioPassTimer(STAGE_AUDIO_PASS)
+#ifdef FDTD_TRACING
+	, gpuTraceTimer("gpu-simulate")
+#endif
+{
+	////////////////////////
+	//Load Shader Programs//
+	////////////////////////
+
+	//Image load/store arrived in OpenGL 4.2 - Older contexts copy the listener into the audio texture with a second draw per step//
+	isAudioImage = GLAD_GL_VERSION_4_2 != 0;
+
+	const char* vertex_fbo_shader_path = { "Shaders/fbo_vs.glsl" };			//Vertex shader of solver program
+	const char* fragment_fbo_shader_path = isAudioImage ? "Shaders/fbo_fs.glsl" : "Shaders/fbo_audio_row_fs.glsl";	//Fragment shader of solver program
+
+	if (!loadShaderProgram(vertex_fbo_shader_path, fragment_fbo_shader_path, fboShaderProgram))
+		std::cout << "Failed to create fbo shader." << std::endl;
+
+	//Material glides are drawn into the coefficient texture on the GPU, never recompiling or reading back//
+	if (!loadShaderProgram("Shaders/coefficients_vs.glsl", "Shaders/coefficients_fs.glsl", coefficientShaderProgram))
+		std::cout << "Failed to create coefficient shader." << std::endl;
+	glUseProgram(coefficientShaderProgram);
+	glUniform1i(glGetUniformLocation(coefficientShaderProgram, "material"), 3);
+	materialOffsetLocation = glGetUniformLocation(coefficientShaderProgram, "materialOffset");
+
+	////////////////////////////////////////////
+	//Structure texture with FDTD audio layout//
+	////////////////////////////////////////////
+
+	const int* domainSize = settings.domainSize;
+
+	//Calculate texture size to fit FDTD structure//
+	textureWidth = domainSize[0] * NUM_OF_TIMESTEPS;	//The texture needs to contain the two timestep quads.
+	textureHeight = domainSize[1] + ceiling;			//The texture needs to contain the quad and then the isolation row.
+
+	//Both quads side by side must fit a single texture - Larger domains are split by gl-tiled//
+	GLint maxTextureSize;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+	if (textureWidth > maxTextureSize || textureHeight > maxTextureSize)
+	{
+		std::cout << "Domain needs a " << textureWidth << "x" << textureHeight << " texture, over the GPU's " << maxTextureSize << " - Use gl-tiled." << std::endl;
+		return;
+	}
+
+	//Calculate delta texture coordinates - The width & height of each fragment//
+	float deltaX = 1.0 / (float)textureWidth;
+	float deltaY = 1.0 / (float)textureHeight;
+
+	//Calculate delta to compute vertex y position leaving space for the isolation row.
+	float deltaV = 2.0 / (float)textureHeight;				//Unsure about this?
+
+	//Specify information for texture//
+	int numOfAttributesPerVertex = 12;						//The number of pieces of information each vertex contains.
+	int numOfVerticesPerQuad = 4;							//Number of vertices that make up each texture quad.
+	float attributes[] = {
+		// quad0 [left quadrant]
+		// 4 vertices
+		// pos N+1/-1				tex C coord N				tex L coord N							tex U coord N							tex R coord N							tex D coord N
+		-1, -1,						0.5, 0,					0.5f - deltaX, 0,						0.5f, 0 + deltaY,						0.5f + deltaX, 0,						0.5f, 0 - deltaY,						// bottom left
+		-1, 1 - ceiling * deltaV,	0.5f, 1 - ceiling * deltaY,	0.5f - deltaX, 1 - ceiling * deltaY,	0.5f, 1 + deltaY - ceiling * deltaY,	0.5f + deltaX, 1 - ceiling * deltaY,	0.5f, 1 - deltaY - ceiling * deltaY,	// top left [leaving space for clng]
+		0, -1,						1.0f, 0,					1 - deltaX,    0,						1,    0 + deltaY,						1 + deltaX,    0,						1, 	  0 - deltaY,						// bottom right
+		0, 1 - ceiling * deltaV,	1.0f, 1 - ceiling * deltaY,	1 - deltaX,    1 - ceiling * deltaY,	1,    1 + deltaY - ceiling * deltaY,	1 + deltaX,    1 - ceiling * deltaY,	1, 	  1 - deltaY - ceiling * deltaY,	// top right [leaving space for clng]
+
+		// quad1 [right quadrant]
+		// 4 vertices
+		// pos N+1/-1				tex C coord N				tex L coord N							tex U coord N							tex R coord N							tex D coord N
+		0, -1,						0, 0,						0 - deltaX,	0,							0, 0 + deltaY,							0 + deltaX,	0,							0, 0 - deltaY,							// bottom left
+		0, 1 - ceiling * deltaV,	0,    1 - ceiling * deltaY,	0 - deltaX, 1 - ceiling * deltaY,		0,    1 + deltaY - ceiling * deltaY,	0 + deltaX,    1 - ceiling * deltaY,	0,    1 - deltaY - ceiling * deltaY,	// top left [leaving space for clng]
+		1, -1,						0.5f, 0,					0.5f - deltaX, 0,						0.5f, 0 + deltaY,						0.5f + deltaX, 0,						0.5f, 0 - deltaY,						// bottom right
+		1, 1 - ceiling * deltaV,	0.5f, 1 - ceiling * deltaY,	0.5f - deltaX, 1 - ceiling * deltaY,	0.5f, 1 + deltaY - ceiling * deltaY,	0.5f + deltaX, 1 - ceiling * deltaY,	0.5f, 1 - deltaY - ceiling * deltaY,	// top right [leaving space for clng]
+
+		// quad2 [audio quadrant] - Only drawn without an audio image, covering the single audio texel in the viewport
+		// 4 vertices
+		// pos [no concept of time step]		no tex coords required, the listener's are uniforms
+		-1, -1,					0,    0,			0,    0,			0,    0,			0,    0,			0,    0,	// bottom left
+		-1, 1,	    			0,    0,			0,    0,			0,    0,			0,    0,			0,    0,	// top left
+		1, -1,					0,    0,			0,    0,			0,    0,			0,    0,			0,    0,	// bottom right
+		1, 1,					0,    0,			0,    0,			0,    0,			0,    0,			0,    0,	// top right
+	};
+
+	/////////////////
+	//Quad Vertices//
+	/////////////////
+
+	//quad0 is composed of vertices 0 to 3.
+	vertices[0][0] = 0;						//Index of first vertex.
+	vertices[0][1] = numOfVerticesPerQuad;	//Number of vertices.
+
+	//quad1 is composed of vertices 4 to 7.
+	vertices[1][0] = 4;
+	vertices[1][1] = numOfVerticesPerQuad;
+
+	//quad2 is composed of vertices 8 to 11.
+	vertices[2][0] = 8;
+	vertices[2][1] = numOfVerticesPerQuad;
+
+	////////////////////////////
+	//Create VBO + VAO objects//
+	////////////////////////////
+
+	//VBO is GPU memory containing vertices data//
+	glGenBuffers(1, &vbo);
+
+	//VAO interprets how VBO content is read//
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(attributes), attributes, GL_STATIC_DRAW);
+
+	/////////////////////////////////////////////
+	//Describe attributes shaders access in VBO//
+	/////////////////////////////////////////////
+
+	int numOfElementsPerAttribute = 4;	//Each attribute has 2 sets of coodinates. Therefore 4(vec4) elements form vertices data structure.
+
+	GLint pos_and_texc_loc = glGetAttribLocation(fboShaderProgram, "pos_and_texc");
+	glEnableVertexAttribArray(pos_and_texc_loc);
+	glVertexAttribPointer(pos_and_texc_loc, numOfElementsPerAttribute, GL_FLOAT, GL_FALSE, numOfAttributesPerVertex * sizeof(GLfloat), (void*)(0 * numOfElementsPerAttribute * sizeof(GLfloat)));
+
+	GLint texl_and_texu_loc = glGetAttribLocation(fboShaderProgram, "texl_and_texu");
+	glEnableVertexAttribArray(texl_and_texu_loc);
+	glVertexAttribPointer(texl_and_texu_loc, numOfElementsPerAttribute, GL_FLOAT, GL_FALSE, numOfAttributesPerVertex * sizeof(GLfloat), (void*)(1 * numOfElementsPerAttribute * sizeof(GLfloat)));
+
+	GLint texr_and_texd_loc = glGetAttribLocation(fboShaderProgram, "texr_and_texd");
+	glEnableVertexAttribArray(texr_and_texd_loc);
+	glVertexAttribPointer(texr_and_texd_loc, numOfElementsPerAttribute, GL_FLOAT, GL_FALSE, numOfAttributesPerVertex * sizeof(GLfloat), (void*)(2 * numOfElementsPerAttribute * sizeof(GLfloat)));
+
+	/////////////////////
+	//Initalize Texture//
+	/////////////////////
+
+	//Initalize flattened multidimensional float array that will contain all fragments//
+	uint8_t numChannels = 2;																//2 channels per pixel - Pressure and previous pressure.
+	float* texturePixels = new float[textureWidth*textureHeight*numChannels];				//Allocate enough memory to represent texture.
+	memset(texturePixels, 0, sizeof(float) * textureWidth * textureHeight * numChannels);
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	//Define the domain - Point types live in their own narrow texture rather than float channels of every texel//
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	domain = buildDomain(settings);
+	domain.cellTypes[settings.listenerPosition[1] * domainSize[0] + settings.listenerPosition[0]] |= CELL_LISTENER;
+
+	glGenTextures(1, &cellTypeTexture);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, cellTypeTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, domainSize[0], domainSize[1], 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);	//Integer textures can't be filtered.
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	//Material folded into per cell coefficients - One extra fetch per fragment, whether uniform or not//
+	glGenTextures(1, &coefficientTexture);
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_2D, coefficientTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, domainSize[0], domainSize[1], 0, GL_RGBA, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	glGenFramebuffers(1, &coefficientFbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, coefficientFbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, coefficientTexture, 0);
+
+	glGenTextures(1, &materialTexture);
+	glActiveTexture(GL_TEXTURE3);
+	glBindTexture(GL_TEXTURE_2D, materialTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, domainSize[0], domainSize[1], 0, GL_RGBA, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	uploadDomain();
+
+	///////////////////////////////////////////
+	//Create texture using texture pixel data//
+	///////////////////////////////////////////
+
+	glGenTextures(1, &texture);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	//fp16 storage halves the bytes every draw reads and writes - The shader still computes in fp32//
+	GLint internalFormat = settings.storagePrecision == PRECISION_FP16 ? GL_RG16F : GL_RG32F;
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, textureWidth, textureHeight, 0, GL_RG, GL_FLOAT, texturePixels);	//Load texture pixels that define inital model state.
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	delete[] texturePixels;
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	//Create Framebuffer object - Memory we write the texture to on memory. This is done instead of using the default rendering framebuffer provided for window//
+	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "Framebuffer object successfully created!" << std::endl;
+	else
+		std::cout << "Error creating framebuffer." << std::endl;
+
+	////////////////////////////////////////////////////////////////////////////
+	//Create Audio image - The listener fragment stores each step's sample here//
+	////////////////////////////////////////////////////////////////////////////
+
+	//Sized for FBO_AUDIO_CAPACITY steps - process() reads back whenever it fills//
+	std::vector<float> silence(FBO_AUDIO_CAPACITY, 0.0f);
+	glGenTextures(1, &audioTexture);
+	glBindTexture(GL_TEXTURE_2D, audioTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, FBO_AUDIO_CAPACITY, 1, 0, GL_RED, GL_FLOAT, &silence[0]);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	//Without an audio image the audio pass renders here rather than into texture, so it samples the step just drawn without a feedback loop//
+	glGenFramebuffers(1, &audioFbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, audioFbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, audioTexture, 0);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	float listenerFragCoord[2][2];
+	if (!isAudioImage)
+	{
+		//Compute texture coordinates of the listener point which shader can recognize - Quad0 reads audio from Quad1, Quad1 from Quad0//
+		listenerFragCoord[0][0] = (float)(settings.listenerPosition[0] + 0.5 + domainSize[0]) / (float)textureWidth;
+		listenerFragCoord[0][1] = (float)(settings.listenerPosition[1] + 0.5) / (float)textureHeight;
+		listenerFragCoord[1][0] = (float)(settings.listenerPosition[0] + 0.5) / (float)textureWidth;
+		listenerFragCoord[1][1] = (float)(settings.listenerPosition[1] + 0.5) / (float)textureHeight;
+	}
+
+	//////////////////////////////
+	//Setup FBO Shader Uniforms//
+	/////////////////////////////
+
+	glUseProgram(fboShaderProgram);
+
+	///////////////////
+	//Static Uniforms//
+	///////////////////
+
+	//Width of each fragment - Used for working out excitation fragment//
+	GLint deltaCoordLocation = glGetUniformLocation(fboShaderProgram, "deltaCoord");
+	glUniform2f(deltaCoordLocation, deltaX, deltaY);
+
+	if (isAudioImage)
+	{
+		//fp16 storage rounds the listener's sample as the texture would have//
+		glUniform1i(glGetUniformLocation(fboShaderProgram, "isHalfStorage"), settings.storagePrecision == PRECISION_FP16);
+	}
+	else
+	{
+		//Listener fragment coordinates as uniforms - For both quads//
+		char name[22];
+		for (int i = 0; i != NUM_OF_TIMESTEPS; ++i)
+		{
+			sprintf(name, "listenerFragCoord[%d]", i);
+			glUniform2f(glGetUniformLocation(fboShaderProgram, name), listenerFragCoord[i][0], listenerFragCoord[i][1]);
+		}
+	}
+
+	////////////////////
+	//Dynamic Uniforms//
+	////////////////////
+
+	//Value of excitation point - Active or not. This could be done differently? Just need an identified excitation point.//
+	excitationMagnitudeLocation = glGetUniformLocation(fboShaderProgram, "excitationMagnitude");
+	glUniform1f(excitationMagnitudeLocation, 0);
+	excitationPositionLocation = glGetUniformLocation(fboShaderProgram, "excitationPosition");
+	setExcitationPosition(settings.excitationPosition[0], settings.excitationPosition[1]);
+
+	//Step of the chunk, so texel of the audio image the listener fragment stores to - With an audio image//
+	audioIndexLocation = glGetUniformLocation(fboShaderProgram, "audioIndex");
+
+	//The current state of FDTD processing in the shader - Without one//
+	stateLocation = glGetUniformLocation(fboShaderProgram, "state");
+
+	//Set inOutTexture uniform to the texture number zero created previously, cellTypes to number one, coefficients to two//
+	glUniform1i(glGetUniformLocation(fboShaderProgram, "inOutTexture"), 0);
+	glUniform1i(glGetUniformLocation(fboShaderProgram, "cellTypes"), 1);
+	glUniform1i(glGetUniformLocation(fboShaderProgram, "coefficients"), 2);
+	glUniform2i(glGetUniformLocation(fboShaderProgram, "listenerCell"), settings.listenerPosition[0], settings.listenerPosition[1]);
+
+	glUseProgram(0);	//Finished with this shader program for now.
+}
+
+GLSolver::~GLSolver()
+{
+	glDeleteFramebuffers(1, &audioFbo);
+	glDeleteFramebuffers(1, &coefficientFbo);
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteTextures(1, &materialTexture);
+	glDeleteTextures(1, &coefficientTexture);
+	glDeleteTextures(1, &cellTypeTexture);
+	glDeleteTextures(1, &audioTexture);
+	glDeleteTextures(1, &texture);
+	glDeleteVertexArrays(1, &vao);
+	glDeleteBuffers(1, &vbo);
+	glDeleteProgram(coefficientShaderProgram);
+	glDeleteProgram(fboShaderProgram);
+}
+
+bool GLSolver::isValid() const
+{
+	return fboShaderProgram != 0 && coefficientShaderProgram != 0 && glIsFramebuffer(fbo);
+}
+
+const char* GLSolver::getName() const
+{
+	if (settings.storagePrecision == PRECISION_FP16)
+		return "GL FBO fp16";
+	return "GL FBO";
+}
+
+void GLSolver::bindSimulation()
+{
+	//Switch to FBO shader for Quad texture//
+	glUseProgram(fboShaderProgram);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);			//Render to our framebuffer!
+	glBindVertexArray(vao);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, cellTypeTexture);
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_2D, coefficientTexture);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	if (isAudioImage)
+		glBindImageTexture(0, audioTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+	glViewport(0, 0, textureWidth, textureHeight);	//Full viewport - Give access to all texture
+}
+
+int GLSolver::rampMaterial(int numSamples)
+{
+	bool isChanged;
+	int segment = materialRamp.advance(numSamples, isChanged);
+	if (isChanged)
+	{
+		updateCoefficients();
+		bindSimulation();
+	}
+	return segment;
+}
+
+void GLSolver::process(const float* excitation, float* output, int numSamples)
+{
+	//Only every GPU_TIMING_INTERVAL calls times its draws on the GPU - Previous timed batch is long finished by then//
+	bool isTimingGPU = (processCount++ % GPU_TIMING_INTERVAL) == 0;
+	if (isTimingGPU)
+	{
+		simulateTimer.collect();
+		if (!isAudioImage)
+			audioPassTimer.collect();
+	}
+
+	//Cycle simulation - The audio texture holds FBO_AUDIO_CAPACITY samples, so larger requests are read back in several chunks//
+	//A material glide redraws the coefficients at the start of each of its segments, between simulation draws//
+	int samplesDone = 0;
+	int segmentEnd = 0;
+	while (samplesDone != numSamples)
+	{
+		int chunkSize = std::min(numSamples - samplesDone, FBO_AUDIO_CAPACITY);
+		bindSimulation();
+
+		StageTimer simulateStageTimer;
+		TRACE_SPAN_BEGIN(simulateSpan, "simulate");
+#ifdef FDTD_TRACING
+		gpuTraceTimer.collect();
+		gpuTraceTimer.begin();
+#endif
+		for (int n = 0; n != chunkSize; ++n)
+		{
+			if (samplesDone + n == segmentEnd)
+				segmentEnd += rampMaterial(numSamples - segmentEnd);
+
+			//////////////////////
+			//Advance Simulation//
+			//////////////////////
+
+			//Pass next excitation Value, and the audio texel the listener fragment stores to or the state drawing the focused quad//
+			glUniform1f(excitationMagnitudeLocation, excitation[samplesDone + n]);
+			glUniform2f(excitationPositionLocation, excitationFragCoord[currentQuad][0], excitationFragCoord[currentQuad][1]);
+			if (isAudioImage)
+				glUniform1i(audioIndexLocation, n);
+			else
+			{
+				state = currentQuad * 2;
+				glUniform1i(stateLocation, state);
+			}
+
+			//Simulation step - Execute shader on the focused quad, which also captures the listener into an audio image//
+			if (isTimingGPU)
+				simulateTimer.begin();
+			glDrawArrays(GL_TRIANGLE_STRIP, vertices[currentQuad][0], vertices[currentQuad][1]);	//Draw quad0 or quad1.
+			if (isTimingGPU)
+				simulateTimer.end();
+
+			//Audio step - Without an audio image, read audio sample from previous quad, defined by current state//
+			//Drawn into the step's texel of audioTexture through audioFbo - texture isn't attached there, so the quad just rendered is read like any texture//
+			if (!isAudioImage)
+			{
+				glUniform1i(stateLocation, state + 1);										//Use next state, which will be to read audio from correct quad in shader.
+				glBindFramebuffer(GL_FRAMEBUFFER, audioFbo);
+				glViewport(n, 0, 1, 1);
+				if (isTimingGPU)
+					audioPassTimer.begin();
+				glDrawArrays(GL_TRIANGLE_STRIP, vertices[QUAD2][0], vertices[QUAD2][1]);	//Draw quad2, the audio quad. Recording audio from quad0 or quad1.
+				if (isTimingGPU)
+					audioPassTimer.end();
+				glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+				glViewport(0, 0, textureWidth, textureHeight);
+			}
+
+			//Prepare next simulation cycle//
+			currentQuad = 1 - currentQuad;
+
+			//Re-sync all parallel GPU threads - Also done implictly when buffers swapped//
+			//Basically glDrawArray calls make asynchronous GPU computations - Calling this makes CPU wait for all GPU threads to complete before continue//
+			glFlush();
+		}
+#ifdef FDTD_TRACING
+		gpuTraceTimer.end();
+#endif
+		TRACE_SPAN_END(simulateSpan);
+		profiler.recordCPU(STAGE_SIMULATE, simulateStageTimer.elapsed());
+
+		StageTimer readbackStageTimer;
+		TRACE_SPAN_BEGIN(readbackSpan, "readback");
+		//Retrieve the chunk's audio in one read - glReadPixels reads image stores through audioFbo's attachment, and the next chunk's stores reuse its texels//
+		if (isAudioImage)
+			glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+		glBindFramebuffer(GL_FRAMEBUFFER, audioFbo);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		glReadPixels(0, 0, chunkSize, 1, GL_RED, GL_FLOAT, output + samplesDone);
+		TRACE_SPAN_END(readbackSpan);
+		profiler.recordCPU(STAGE_READBACK, readbackStageTimer.elapsed());
+
+		samplesDone += chunkSize;
+	}
+}
+
+void GLSolver::setExcitationPosition(float x, float y)
+{
+	//Snap to the centre of the cell - The shader matches fragments within half a fragment of this coordinate//
+	int cellX = std::min(std::max((int)(x * settings.domainSize[0]), 0), settings.domainSize[0] - 1);
+	int cellY = std::min(std::max((int)(y * settings.domainSize[1]), 0), settings.domainSize[1] - 1);
+
+	//Quad0 is drawn from the right half of the texture, Quad1 from the left half//
+	excitationFragCoord[QUAD0][0] = (float)(cellX + 0.5 + settings.domainSize[0]) / (float)textureWidth;
+	excitationFragCoord[QUAD0][1] = (float)(cellY + 0.5) / (float)textureHeight;
+	excitationFragCoord[QUAD1][0] = (float)(cellX + 0.5) / (float)textureWidth;
+	excitationFragCoord[QUAD1][1] = (float)(cellY + 0.5) / (float)textureHeight;
+}
+
+void GLSolver::setMaterial(float propagation, float damping, float boundaryGain)
+{
+	materialRamp.setTarget(propagation, damping, boundaryGain);
+}
+
+double GLSolver::getEnergy()
+{
+	//Reduced on the CPU from a snapshot - ParkedSolver only asks once the listener has gone quiet//
+	std::vector<float> field(domain.cellTypes.size() * 4);
+	getField(&field[0]);
+	std::vector<float> current(domain.cellTypes.size());
+	std::vector<float> previous(domain.cellTypes.size());
+	for (size_t i = 0; i != domain.cellTypes.size(); ++i)
+	{
+		current[i] = field[i * 4 + 0];
+		previous[i] = field[i * 4 + 1];
+	}
+	return computeFieldEnergy(domain, &current[0], &previous[0]);
+}
+
+void GLSolver::getField(float* field)
+{
+	TRACE_SCOPE("snapshot");
+
+	//The last quad drawn holds the latest timestep - Quad0 is drawn into the left half of the texture//
+	int lastQuad = 1 - currentQuad;
+
+	//Reading RGBA from the RG texture leaves room for the cell channels, filled from the CPU copy//
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glReadPixels(lastQuad * settings.domainSize[0], 0, settings.domainSize[0], settings.domainSize[1], GL_RGBA, GL_FLOAT, field);
+	for (size_t i = 0; i != domain.cellTypes.size(); ++i)
+	{
+		field[i * 4 + 2] = getTransmission(domain.cellTypes[i]);
+		field[i * 4 + 3] = domain.cellTypes[i];
+	}
+}
+
+void GLSolver::setField(const float* field)
+{
+	//Upload straight into the quad the next step reads from - The RG texture keeps the first two channels of each RGBA cell and discards the rest//
+	int lastQuad = 1 - currentQuad;
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, lastQuad * settings.domainSize[0], 0, settings.domainSize[0], settings.domainSize[1], GL_RGBA, GL_FLOAT, field);
+
+	for (size_t i = 0; i != domain.cellTypes.size(); ++i)
+		domain.cellTypes[i] = (uint8_t)field[i * 4 + 3];
+	uploadDomain();
+}
+
+void GLSolver::uploadDomain()
+{
+	//Rows of bytes aren't 4 byte aligned unless the width happens to be//
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, cellTypeTexture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, domain.width, domain.height, GL_RED_INTEGER, GL_UNSIGNED_BYTE, &domain.cellTypes[0]);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	std::vector<float> texels = computeMaterialTexels(domain);
+	glActiveTexture(GL_TEXTURE3);
+	glBindTexture(GL_TEXTURE_2D, materialTexture);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, domain.width, domain.height, GL_RGBA, GL_FLOAT, &texels[0]);
+	updateCoefficients();
+
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void GLSolver::updateCoefficients()
+{
+	MaterialOffset offset = materialRamp.getOffset();
+	glUseProgram(coefficientShaderProgram);
+	glUniform3f(materialOffsetLocation, offset.propagation, offset.damping, offset.boundaryGain);
+	glBindFramebuffer(GL_FRAMEBUFFER, coefficientFbo);
+	glBindVertexArray(vao);		//Vertices come from the vertex index - Any vertex array will do.
+	glActiveTexture(GL_TEXTURE3);
+	glBindTexture(GL_TEXTURE_2D, materialTexture);
+	glViewport(0, 0, domain.width, domain.height);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <glad\glad.h>
+
+#include "solver.h"
+#include "domain.h"
+#include "materialRamp.h"
+#include "gpuTimer.h"
+
+///////////
+//DEFINES//
+///////////
+
+#define NUM_OF_TIMESTEPS	2		//Number of textures which hold simulation model time steps.
+#define FBO_AUDIO_CAPACITY	4096	//Listener samples the audio image holds before it must be read back.
+
+//Index into vertices to indentify texture Quad//
+#define QUAD0				0		//The first simulation model grid - Alternatively switches between timestep n & n-1.
+#define QUAD1				1		//The second simulation model grid - Alteratively switches between timestep n-1 & n.
+#define QUAD2				2		//The audio quad - Drawn into one texel of the audio texture after each step, recording the listener point below OpenGL 4.2.
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//GLSolver - FDTD model held in a texture and advanced by the fbo shader program. On     //
+//OpenGL 4.2 the listener fragment stores its own sample into an audio image as it is   //
+//computed, so each step is a single draw. Older contexts draw the listener into the   //
+//audio texture through its own framebuffer after each step instead. Needs a current    //
+//OpenGL context on the calling thread for its whole lifetime.                          //
+//////////////////////////////////////////////////////////////////////////////////////////
+class GLSolver : public Solver {
+private:
+	SolverSettings settings;
+	bool isAudioImage;				//Listener stored with image load/store - Otherwise copied into the audio texture by a second draw.
+	Domain domain;					//Cell types and material as uploaded to cellTypeTexture and materialTexture.
+	MaterialRamp materialRamp;
+
+	//Texture layout//
+	int ceiling = 1;				//The isolation row located at top of texture, comprising the "ceiling" - Keeps the top row's up neighbour at 0.
+	int textureWidth;
+	int textureHeight;
+
+	//OpenGL objects//
+	GLuint fboShaderProgram = 0;
+	GLuint coefficientShaderProgram = 0;	//Folds material and its runtime offset into coefficientTexture.
+	GLuint vbo = 0;
+	GLuint vao = 0;
+	GLuint texture = 0;				//Pressure and previous pressure of both quads, plus the ceiling.
+	GLuint cellTypeTexture = 0;		//Domain sized R8UI texture of CELL_ bits - Shared by both quads.
+	GLuint coefficientTexture = 0;	//Domain sized RGBA32F texture of update coefficients [centre, previous, neighbour, unused] - Rendered, so RGBA.
+	GLuint materialTexture = 0;		//Domain sized RGBA32F texture of computeMaterialTexels().
+	GLuint fbo = 0;
+	GLuint coefficientFbo = 0;		//Renders into coefficientTexture.
+	GLuint audioTexture = 0;		//FBO_AUDIO_CAPACITY x 1 R32F listener sample of each step, stored by the fbo shader or drawn by the audio pass.
+	GLuint audioFbo = 0;			//Reads audioTexture back, and renders the audio pass into it.
+
+	int vertices[NUM_OF_TIMESTEPS + 1][2];	//First vertex and number of vertices of each quad.
+
+	//Uniform Locations//
+	GLint excitationPositionLocation;
+	GLint excitationMagnitudeLocation;
+	GLint audioIndexLocation;
+	GLint stateLocation;
+	GLint materialOffsetLocation;
+
+	//Upload domain's cell types and material into their textures, then recompute coefficients - Leaves texture unit 0 active//
+	void uploadDomain();
+
+	//Draw the current material into coefficientTexture - Leaves the coefficient program and framebuffer bound//
+	void updateCoefficients();
+
+	//Bind the fbo program, framebuffer and textures the simulation draws use//
+	void bindSimulation();
+
+	//Glide material over the next steps of a block of numSamples, recomputing coefficients if it moved - Returns the steps to run before calling again//
+	int rampMaterial(int numSamples);
+
+	int currentQuad = QUAD0;					//Quad focused on for current time step - We start to draw from quad 0, left quad.
+	float excitationFragCoord[NUM_OF_TIMESTEPS][2];	//Texture coordinates of the excitation point as seen by each quad.
+
+	/*
+	* Audio pass states:
+	* state0: draw quad0 [left]
+	* state1: read audio from quad1 [right] cos quad0 might not be ready yet
+	* state2: draw quad1 [right]
+	* state3: read audio from quad0 [left] cos quad1 might not be ready yet
+	*/
+	int state = -1;
+
+	//Profiling//
+	GPUTimer simulateTimer;
+	GPUTimer audioPassTimer;
+#ifdef FDTD_TRACING
+	GPUTraceTimer gpuTraceTimer;
+#endif
+	int processCount = 0;
+
+public:
+	GLSolver(const SolverSettings& aSettings);
+	~GLSolver();
+
+	bool isValid() const;
+
+	const char* getName() const;
+	void process(const float* excitation, float* output, int numSamples);
+	void setExcitationPosition(float x, float y);
+	void setMaterial(float propagation, float damping, float boundaryGain);
+	double getEnergy();
+	void getField(float* field);
+	void setField(const float* field);
+};
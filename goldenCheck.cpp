@@ -0,0 +1,399 @@
+/* goldenCheck: renders fixed scenarios through every available solver backend and compares the listener streams against stored golden files, reporting the largest absolute error and ULP distance. Run with --generate to rewrite the golden files from the reference backend */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include <glad\glad.h>
+#include <GLFW\glfw3.h>
+
+#include "solverFactory.h"
+#include "oversampledSolver.h"
+
+///////////
+//DEFINES//
+///////////
+
+#define GOLDEN_MAGIC			0x474C4F47	//"GOLG" - Identifies golden files.
+#define GOLDEN_VERSION			7			//Bump when scenarios change - Golden files must then be regenerated.
+#define GOLDEN_BLOCK_SIZE		128			//Samples processed per call, as the real-time loop would.
+#define DEFAULT_TOLERANCE		1e-4		//Largest absolute error allowed, relative to the golden stream's peak.
+
+//A fixed configuration rendered identically through every backend//
+struct Scenario {
+	const char* name;
+	int domainSize[2];
+	int listenerPosition[2];
+	float propagationFactor;
+	float dampingFactor;
+	float boundaryGain;
+	int numSamples;
+	bool isMovingExcitation;	//Excitation position sweeps across the domain, restruck every block.
+	const char* domainShape;	//Shape and material descriptions, see domainBuilder.h - NULL for the uniform rectangle.
+	const char* materialMap;
+	bool isMaterialGlide;		//A quarter of the way in, the material glides to lower propagation, heavier damping and halved gain.
+	float silenceFloor;			//Field energy the solver parks below, struck again halfway in to wake it - 0 never parks.
+	bool isSlidingProbes;		//A bowed excitation slides across the drum and the listener circles, between cells every step - Backends without isProbePathSupported() are unavailable.
+	bool isCentredStrike;		//Struck on the centre cell, so cpu-simd and cpu-threaded fold an odd grid to a quarter.
+};
+
+const Scenario scenarios[] = {
+	//Name					Domain		Listener	Prop	Damp		Gain	Samples	Moving
+	{ "clamped",			{ 40, 40 },	{ 5, 5 },	0.5f,	0.0005f,	0.0f,	4096,	false },
+	{ "free",				{ 40, 40 },	{ 5, 5 },	0.5f,	0.0005f,	1.0f,	4096,	false,	//Bottom wall clamped - Free on every side would leave a constant mode.
+		NULL, "gain = 0 in rect(0, 0, 1, 0.02)" },
+	{ "undamped",			{ 40, 40 },	{ 5, 5 },	0.5f,	0.0f,		0.7f,	4096,	false },
+	{ "heavy-damping",		{ 40, 40 },	{ 5, 5 },	0.5f,	0.01f,		0.5f,	4096,	false },
+	{ "odd-domain",			{ 67, 53 },	{ 30, 9 },	0.4f,	0.003f,		0.5f,	4096,	false },
+	{ "moving-excitation",	{ 64, 48 },	{ 10, 20 },	0.5f,	0.0005f,	0.8f,	8192,	true },
+	{ "drum-material",		{ 64, 64 },	{ 14, 44 },	0.4f,	0.0005f,	0.8f,	4096,	false,
+		"subtract(circle(0.5, 0.5, 0.48), circle(0.35, 0.6, 0.08))",
+		"propagation = gradient(0, 0, 0.2, 1, 1, 0.45); damping = 0.01 in circle(0.3, 0.3, 0.1); gain = 0 in rect(0, 0.5, 0.5, 1)" },
+	{ "material-glide",		{ 48, 48 },	{ 12, 30 },	0.45f,	0.0005f,	0.8f,	8192,	false,	//Partly reflecting, so the glide to half the gain still leaves no constant mode.
+		NULL, "damping = 0.005 in circle(0.7, 0.3, 0.15)", true },
+	{ "oversampled",		{ 40, 40 },	{ 5, 5 },	1.2f,	0.002f,		0.7f,	4096,	false },	//Beyond CFL_LIMIT - Runs 2 steps per sample. Damped and partly reflecting, like odd-domain.
+	{ "parked",				{ 40, 40 },	{ 5, 5 },	0.5f,	0.02f,		1.0f,	16384,	false,	//Exempt - Free walls rest the membrane off centre, which must still park. Heavy damping holds drift near 2e-5.
+		NULL, NULL, false, 1e-8f },
+	{ "sliding-probes",		{ 56, 44 },	{ 16, 26 },	0.45f,	0.001f,		0.8f,	8192,	false,
+		NULL, NULL, false, 0.0f, true },
+	{ "folded",				{ 41, 31 },	{ 7, 5 },	0.4f,	0.001f,		0.8f,	4096,	false,
+		NULL, "damping = 0.004 in circle(0.5, 0.5, 0.3)", false, 0.0f, false, true }
+};
+const int numOfScenarios = sizeof(scenarios) / sizeof(scenarios[0]);
+
+//Options//
+std::vector<SolverBackend> backends;
+SolverBackend referenceBackend = BACKEND_CPU_SCALAR;
+StoragePrecision precision = PRECISION_FP32;	//Storage precision checked backends run with - Goldens are always fp32.
+std::string goldenDirectory = "Golden";
+double tolerance = DEFAULT_TOLERANCE;
+bool isGenerating = false;
+bool isTrackingActiveTiles = false;				//Checked backends step only active tiles - Goldens always step the whole grid.
+bool isUpdatingInPlace = false;					//Checked backends overwrite previous pressure in place - gl-fbo switches to image load/store.
+
+////////////////////
+//HELPER FUNCTIONS//
+////////////////////
+
+//Render a scenario through a backend - Returns false if the backend is unavailable//
+bool renderScenario(SolverBackend backend, StoragePrecision storagePrecision, bool isActiveTiles, bool isInPlace, const Scenario& scenario, std::vector<float>& stream);
+
+bool writeGolden(const std::string& path, const std::vector<float>& stream);
+bool readGolden(const std::string& path, std::vector<float>& stream);
+
+//Distance in representable floats between a and b - 0 if identical//
+uint32_t ulpDistance(float a, float b);
+
+int main(int argc, char* argv[])
+{
+	//cpu-kspace is free of the FDTD scheme's dispersion the goldens hold, so is only checked when asked for//
+	for (int i = 0; i != NUM_OF_BACKENDS; ++i)
+	{
+		if ((SolverBackend)i != BACKEND_CPU_KSPACE)
+			backends.push_back((SolverBackend)i);
+	}
+
+	//Options//
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string option = argv[i];
+		if (option == "--generate")
+			isGenerating = true;
+		else if (option == "--active-tiles")
+			isTrackingActiveTiles = true;
+		else if (option == "--in-place")
+			isUpdatingInPlace = true;
+		else if (option == "--golden-dir" && i + 1 < argc)
+			goldenDirectory = argv[++i];
+		else if (option == "--tolerance" && i + 1 < argc)
+			tolerance = std::stod(argv[++i]);
+		else if (option == "--precision" && i + 1 < argc)
+		{
+			precision = findPrecision(argv[++i]);
+			if (precision == NUM_OF_PRECISIONS)
+			{
+				std::cout << "Unknown precision " << argv[i] << std::endl;
+				return -1;
+			}
+		}
+		else if (option == "--backends" && i + 1 < argc)
+		{
+			backends.clear();
+			std::stringstream stream(argv[++i]);
+			std::string name;
+			while (std::getline(stream, name, ','))
+			{
+				SolverBackend backend = findBackend(name.c_str());
+				if (backend == NUM_OF_BACKENDS)
+				{
+					std::cout << "Unknown backend " << name << std::endl;
+					return -1;
+				}
+				backends.push_back(backend);
+			}
+		}
+		else
+		{
+			std::cout << "Usage: goldenCheck [--generate] [--golden-dir Golden] [--tolerance 1e-4] [--precision fp16] [--active-tiles] [--in-place] [--backends gl-fbo,cpu-simd]" << std::endl;
+			return -1;
+		}
+	}
+
+	//Hidden window only provides an OpenGL context - GL backends are skipped without one//
+	bool hasGLContext = false;
+	GLFWwindow* window = NULL;
+	if (glfwInit())
+	{
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		window = glfwCreateWindow(1, 1, "Golden Check", NULL, NULL);
+		if (window != NULL)
+		{
+			glfwMakeContextCurrent(window);
+			hasGLContext = gladLoadGLLoader((GLADloadproc)glfwGetProcAddress) != 0;
+		}
+	}
+	if (!hasGLContext)
+		std::cout << "No OpenGL context - GL backends skipped." << std::endl;
+
+	int numFailures = 0;
+
+	////////////////////
+	//Generate Goldens//
+	////////////////////
+	if (isGenerating)
+	{
+		for (int s = 0; s != numOfScenarios; ++s)
+		{
+			std::vector<float> stream;
+			std::string path = goldenDirectory + "/" + scenarios[s].name + ".golden";
+			if (!renderScenario(referenceBackend, PRECISION_FP32, false, false, scenarios[s], stream) || !writeGolden(path, stream))
+			{
+				std::cout << "Failed to generate " << path << std::endl;
+				++numFailures;
+			}
+
+			//A silent stream passes every backend, so it tests nothing - Usually a listener on a wall//
+			else if (std::find_if(stream.begin(), stream.end(), [](float sample) { return sample != 0.0f; }) == stream.end())
+			{
+				std::cout << "Generated " << path << " is silent - Move the listener off the walls" << std::endl;
+				++numFailures;
+			}
+			else
+				std::cout << "Generated " << path << " from " << getBackendName(referenceBackend) << std::endl;
+		}
+	}
+
+	///////////////////
+	//Compare Streams//
+	///////////////////
+	else
+	{
+		if (precision != PRECISION_FP32)
+			std::cout << "Checking " << getPrecisionName(precision) << " storage against fp32 goldens." << std::endl;
+		std::cout << "scenario            backend        max abs err   rel err     max ulp  result" << std::endl;
+		for (int s = 0; s != numOfScenarios; ++s)
+		{
+			std::vector<float> golden;
+			std::string path = goldenDirectory + "/" + scenarios[s].name + ".golden";
+			if (!readGolden(path, golden) || (int)golden.size() != scenarios[s].numSamples)
+			{
+				std::cout << "Missing or outdated " << path << " - Run with --generate" << std::endl;
+				++numFailures;
+				continue;
+			}
+
+			float peak = 0.0f;
+			for (size_t n = 0; n != golden.size(); ++n)
+				peak = std::max(peak, std::fabs(golden[n]));
+
+			for (size_t b = 0; b != backends.size(); ++b)
+			{
+				if ((isGLBackend(backends[b]) && !hasGLContext) || !isPrecisionSupported(backends[b], precision))
+					continue;
+				if (isTrackingActiveTiles && !isActiveTilingSupported(backends[b]))
+					continue;
+				if (isUpdatingInPlace && !isInPlaceSupported(backends[b], precision))
+					continue;
+
+				std::vector<float> stream;
+				if (!renderScenario(backends[b], precision, isTrackingActiveTiles, isUpdatingInPlace, scenarios[s], stream))
+				{
+					printf("%-19s %-12s   unavailable\n", scenarios[s].name, getBackendName(backends[b]));
+					continue;
+				}
+
+				//Largest errors, and first sample to exceed the tolerance for locating divergence//
+				double maxError = 0.0;
+				uint32_t maxULP = 0;
+				long firstFailure = -1;
+				for (size_t n = 0; n != golden.size(); ++n)
+				{
+					double error = std::fabs((double)stream[n] - (double)golden[n]);
+					maxError = std::max(maxError, error);
+					maxULP = std::max(maxULP, ulpDistance(stream[n], golden[n]));
+					if (firstFailure < 0 && !(error <= tolerance * peak))
+						firstFailure = (long)n;
+				}
+
+				bool isPassing = firstFailure < 0;
+				printf("%-19s %-12s %13.3e %9.3e %11u  %s", scenarios[s].name, getBackendName(backends[b]),
+					maxError, peak > 0.0f ? maxError / peak : 0.0, maxULP, isPassing ? "PASS" : "FAIL");
+				if (!isPassing)
+				{
+					printf(" - diverges at sample %ld", firstFailure);
+					++numFailures;
+				}
+				printf("\n");
+			}
+		}
+		std::cout << numFailures << " failures." << std::endl;
+	}
+
+	if (window != NULL)
+		glfwDestroyWindow(window);
+	glfwTerminate();
+
+	return numFailures == 0 ? 0 : 1;
+}
+
+bool renderScenario(SolverBackend backend, StoragePrecision storagePrecision, bool isActiveTiles, bool isInPlace, const Scenario& scenario, std::vector<float>& stream)
+{
+	SolverSettings settings;
+	settings.domainSize[0] = scenario.domainSize[0];
+	settings.domainSize[1] = scenario.domainSize[1];
+	settings.listenerPosition[0] = scenario.listenerPosition[0];
+	settings.listenerPosition[1] = scenario.listenerPosition[1];
+	settings.propagationFactor = scenario.propagationFactor;
+	settings.dampingFactor = scenario.dampingFactor;
+	settings.boundaryGain = scenario.boundaryGain;
+	if (scenario.isCentredStrike)
+	{
+		settings.excitationPosition[0] = ((scenario.domainSize[0] - 1) / 2 + 0.5f) / (float)scenario.domainSize[0];
+		settings.excitationPosition[1] = ((scenario.domainSize[1] - 1) / 2 + 0.5f) / (float)scenario.domainSize[1];
+	}
+	settings.storagePrecision = storagePrecision;
+	if (scenario.domainShape != NULL)
+		settings.domainShape = scenario.domainShape;
+	if (scenario.materialMap != NULL)
+		settings.materialMap = scenario.materialMap;
+	settings.silenceFloor = scenario.silenceFloor;
+	settings.isTrackingActiveTiles = isActiveTiles;
+	settings.isUpdatingInPlace = isInPlace;
+
+	std::string error;
+	if (!applyStabilityGuard(settings, error))
+	{
+		std::cout << scenario.name << " is unstable - " << error << std::endl;
+		return false;
+	}
+
+	Solver* solver = createSolver(backend, settings);
+	if (solver == NULL)
+		return false;
+	if (scenario.isSlidingProbes && !solver->isProbePathFollowed())
+	{
+		delete solver;
+		return false;
+	}
+
+	stream.assign(scenario.numSamples, 0.0f);
+	std::vector<float> excitation(GOLDEN_BLOCK_SIZE);
+	std::vector<float> excitationPath(GOLDEN_BLOCK_SIZE * 2);
+	std::vector<float> listenerPath(GOLDEN_BLOCK_SIZE * 2);
+	int numBlocks = (scenario.numSamples + GOLDEN_BLOCK_SIZE - 1) / GOLDEN_BLOCK_SIZE;
+	for (int block = 0; block != numBlocks; ++block)
+	{
+		int blockBegin = block * GOLDEN_BLOCK_SIZE;
+		int blockSize = std::min(GOLDEN_BLOCK_SIZE, scenario.numSamples - blockBegin);
+
+		//Moving excitation traces a Lissajous path, struck at the start of each block - Otherwise a single strike at the start//
+		std::fill(excitation.begin(), excitation.end(), 0.0f);
+		if (scenario.isMovingExcitation)
+		{
+			float t = (float)block / (float)numBlocks;
+			solver->setExcitationPosition(0.5f + 0.35f * std::sin(6.2831853f * t), 0.5f + 0.35f * std::sin(4.0f * 6.2831853f * t));
+			excitation[0] = 1.0f;
+		}
+		else if (block == 0 || (scenario.silenceFloor > 0.0f && block == numBlocks / 2))
+			excitation[0] = 1.0f;
+
+		//Sliding probes - Excitation bowed along a Lissajous path for the first half, listener circling its cell 3 cells out throughout//
+		if (scenario.isSlidingProbes)
+		{
+			for (int n = 0; n != blockSize; ++n)
+			{
+				float t = (float)(blockBegin + n) / (float)scenario.numSamples;
+				excitation[n] = t < 0.5f ? 0.1f * std::sin(6.2831853f * (float)(blockBegin + n) / 50.0f) : 0.0f;
+				excitationPath[n * 2 + 0] = (scenario.domainSize[0] - 1) * (0.5f + 0.3f * std::sin(6.2831853f * t));
+				excitationPath[n * 2 + 1] = (scenario.domainSize[1] - 1) * (0.5f + 0.3f * std::sin(3.0f * 6.2831853f * t));
+				listenerPath[n * 2 + 0] = scenario.listenerPosition[0] + 3.0f * std::cos(4.0f * 6.2831853f * t);
+				listenerPath[n * 2 + 1] = scenario.listenerPosition[1] + 3.0f * std::sin(4.0f * 6.2831853f * t);
+			}
+			solver->setProbePaths(&excitationPath[0], &listenerPath[0]);
+		}
+
+		//Set between blocks, as the real-time loop does//
+		if (scenario.isMaterialGlide && block == numBlocks / 4)
+			solver->setMaterial(scenario.propagationFactor * 0.6f, scenario.dampingFactor * 4.0f, scenario.boundaryGain * 0.5f);
+
+		solver->process(&excitation[0], &stream[blockBegin], blockSize);
+	}
+
+	delete solver;
+	return true;
+}
+
+bool writeGolden(const std::string& path, const std::vector<float>& stream)
+{
+	std::ofstream file(path.c_str(), std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	uint32_t header[3] = { GOLDEN_MAGIC, GOLDEN_VERSION, (uint32_t)stream.size() };
+	file.write((const char*)header, sizeof(header));
+	file.write((const char*)&stream[0], sizeof(float) * stream.size());
+	return file.good();
+}
+
+bool readGolden(const std::string& path, std::vector<float>& stream)
+{
+	std::ifstream file(path.c_str(), std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	uint32_t header[3];
+	file.read((char*)header, sizeof(header));
+	if (!file.good() || header[0] != GOLDEN_MAGIC || header[1] != GOLDEN_VERSION)
+		return false;
+
+	stream.resize(header[2]);
+	file.read((char*)&stream[0], sizeof(float) * stream.size());
+	return file.good();
+}
+
+uint32_t ulpDistance(float a, float b)
+{
+	if (a == b)
+		return 0;
+	if (a != a || b != b)
+		return UINT32_MAX;	//NaN never matches.
+
+	//Map the sign-magnitude bit patterns onto a monotonic unsigned line//
+	uint32_t ua, ub;
+	memcpy(&ua, &a, sizeof(float));
+	memcpy(&ub, &b, sizeof(float));
+	ua = (ua & 0x80000000u) ? ~ua : (ua | 0x80000000u);
+	ub = (ub & 0x80000000u) ? ~ub : (ub | 0x80000000u);
+	return ua > ub ? ua - ub : ub - ua;
+}
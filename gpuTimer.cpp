@@ -0,0 +1,120 @@
+#include "gpuTimer.h"
+
+GPUTimer::GPUTimer(ProfileStage aStage) : stage(aStage)
+{
+}
+
+GPUTimer::~GPUTimer()
+{
+	if (!queries.empty())
+		glDeleteQueries((GLsizei)queries.size(), &queries[0]);
+}
+
+void GPUTimer::begin()
+{
+	if (numIssued == (int)queries.size())
+	{
+		GLuint query;
+		glGenQueries(1, &query);
+		queries.push_back(query);
+	}
+	glBeginQuery(GL_TIME_ELAPSED, queries[numIssued]);
+}
+
+void GPUTimer::end()
+{
+	glEndQuery(GL_TIME_ELAPSED);
+	++numIssued;
+}
+
+void GPUTimer::collect()
+{
+	if (numIssued == 0)
+		return;
+
+	//Queries complete in order - If the last is available the whole batch is//
+	GLint isAvailable = 0;
+	glGetQueryObjectiv(queries[numIssued - 1], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+	if (isAvailable)
+	{
+		GLuint64 total = 0;
+		for (int i = 0; i != numIssued; ++i)
+		{
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &elapsed);
+			total += elapsed;
+		}
+		profiler.recordGPU(stage, total);
+	}
+	numIssued = 0;
+}
+
+#ifdef FDTD_TRACING
+GPUTraceTimer::GPUTraceTimer(const char* aName) : name(aName)
+{
+	glGenQueries(GPU_TRACE_PENDING * 2, &queries[0][0]);
+}
+
+GPUTraceTimer::~GPUTraceTimer()
+{
+	glDeleteQueries(GPU_TRACE_PENDING * 2, &queries[0][0]);
+}
+
+void GPUTraceTimer::syncClocks()
+{
+	GLint64 gpuTime = 0;
+	glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+	clockOffset = (int64_t)tracer.now() - (int64_t)gpuTime;
+	spansUntilResync = GPU_TRACE_RESYNC;
+}
+
+void GPUTraceTimer::begin()
+{
+	if (!tracer.isEnabled())
+		return;
+
+	//Oldest span still unfinished - Drop it rather than wait//
+	if (head - tail == GPU_TRACE_PENDING)
+		++tail;
+	glQueryCounter(queries[head % GPU_TRACE_PENDING][0], GL_TIMESTAMP);
+}
+
+void GPUTraceTimer::end()
+{
+	if (!tracer.isEnabled())
+		return;
+
+	glQueryCounter(queries[head % GPU_TRACE_PENDING][1], GL_TIMESTAMP);
+	++head;
+}
+
+void GPUTraceTimer::collect()
+{
+	if (!tracer.isEnabled())
+		return;
+
+	if (track == NULL)
+		track = tracer.createTrack("GPU");
+	if (spansUntilResync <= 0)
+		syncClocks();
+
+	while (tail != head)
+	{
+		GLuint* span = queries[tail % GPU_TRACE_PENDING];
+		GLint isAvailable = 0;
+		glGetQueryObjectiv(span[1], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+		if (!isAvailable)
+			break;
+
+		GLuint64 beginTime = 0;
+		GLuint64 endTime = 0;
+		glGetQueryObjectui64v(span[0], GL_QUERY_RESULT, &beginTime);
+		glGetQueryObjectui64v(span[1], GL_QUERY_RESULT, &endTime);
+		int64_t traceBegin = (int64_t)beginTime + clockOffset;
+		if (traceBegin > 0)
+			track->push(name, (uint64_t)traceBegin, (uint64_t)((int64_t)endTime + clockOffset));
+		++tail;
+		--spansUntilResync;
+	}
+}
+#endif
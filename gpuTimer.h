@@ -0,0 +1,66 @@
+#pragma once
+
+#include <glad\glad.h>
+#include <vector>
+
+#include "profiler.h"
+
+#define GPU_TIMING_INTERVAL	16		//Calls to process() between GPU timed ones - Timer queries around every draw are too costly to run always.
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//GPUTimer - GL_TIME_ELAPSED queries for one profiler stage. Queries issued between collect()    //
+//calls form a batch whose durations are summed into a single GPU record. Results are only read //
+//once available, so collecting never stalls the pipeline - An unfinished batch is just dropped.//
+//Must be used on the thread owning the OpenGL context it was created on.                      //
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class GPUTimer {
+private:
+	ProfileStage stage;
+	std::vector<GLuint> queries;	//Pool grows to the largest batch seen.
+	int numIssued = 0;				//Queries used by the current batch.
+
+public:
+	GPUTimer(ProfileStage aStage);
+	~GPUTimer();
+
+	void begin();
+	void end();
+
+	//Record the current batch if the GPU has finished it, then start a new batch//
+	void collect();
+};
+
+#ifdef FDTD_TRACING
+#include "tracer.h"
+
+#define GPU_TRACE_PENDING	8	//Spans that can be in flight on the GPU before the oldest is dropped.
+#define GPU_TRACE_RESYNC	64	//Collected spans between re-measuring the GPU to CPU clock offset.
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//GPUTraceTimer - GL_TIMESTAMP queries marking when a span of GPU work actually ran. Completed     //
+//spans are moved onto the CPU clock and pushed to their own "GPU" track, so the trace shows GPU   //
+//execution next to the CPU submission that caused it.                                             //
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+class GPUTraceTimer {
+private:
+	const char* name;
+	TraceBuffer* track = NULL;
+	GLuint queries[GPU_TRACE_PENDING][2];	//Begin and end timestamp of each span.
+	int head = 0;							//Next span to issue.
+	int tail = 0;							//Oldest span not yet collected.
+	int64_t clockOffset = 0;				//Trace time minus GPU time.
+	int spansUntilResync = 0;
+
+	void syncClocks();
+
+public:
+	GPUTraceTimer(const char* aName);
+	~GPUTraceTimer();
+
+	void begin();
+	void end();
+
+	//Push every finished span to the trace - Never waits on the GPU//
+	void collect();
+};
+#endif
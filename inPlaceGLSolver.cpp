@@ -0,0 +1,291 @@
+#include "inPlaceGLSolver.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "shaderProgram.h"
+#include "domainBuilder.h"
+#include "tracer.h"
+
+//Nearest filtered texture - Every read is a texelFetch or image load//
+static GLuint createTexture(GLint internalFormat, GLenum format, GLenum type, int textureWidth, int textureHeight, const void* pixels)
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, textureWidth, textureHeight, 0, format, type, pixels);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	return texture;
+}
+
+InPlaceGLSolver::InPlaceGLSolver(const SolverSettings& aSettings) : settings(aSettings), materialRamp(aSettings), simulateTimer(STAGE_SIMULATE)
+{
+	width = settings.domainSize[0];
+	height = settings.domainSize[1];
+
+	//Both programs draw a single triangle over the viewport//
+	if (!loadShaderProgram("Shaders/coefficients_vs.glsl", "Shaders/inplace_fs.glsl", inPlaceShaderProgram))
+	{
+		std::cout << "Failed to create in place shader." << std::endl;
+		glDeleteProgram(inPlaceShaderProgram);
+		inPlaceShaderProgram = 0;
+		return;
+	}
+	if (!loadShaderProgram("Shaders/coefficients_vs.glsl", "Shaders/coefficients_fs.glsl", coefficientShaderProgram))
+	{
+		std::cout << "Failed to create coefficient shader." << std::endl;
+		glDeleteProgram(coefficientShaderProgram);
+		glDeleteProgram(inPlaceShaderProgram);
+		coefficientShaderProgram = 0;
+		inPlaceShaderProgram = 0;
+		return;
+	}
+	glGenVertexArrays(1, &vao);
+
+	glUseProgram(inPlaceShaderProgram);
+	glUniform1i(glGetUniformLocation(inPlaceShaderProgram, "cellTypes"), 1);
+	glUniform1i(glGetUniformLocation(inPlaceShaderProgram, "coefficients"), 2);
+	glUniform2i(glGetUniformLocation(inPlaceShaderProgram, "listenerCell"), settings.listenerPosition[0], settings.listenerPosition[1]);
+	excitationCellLocation = glGetUniformLocation(inPlaceShaderProgram, "excitationCell");
+	excitationMagnitudeLocation = glGetUniformLocation(inPlaceShaderProgram, "excitationMagnitude");
+	audioIndexLocation = glGetUniformLocation(inPlaceShaderProgram, "audioIndex");
+
+	glUseProgram(coefficientShaderProgram);
+	glUniform1i(glGetUniformLocation(coefficientShaderProgram, "material"), 3);
+	materialOffsetLocation = glGetUniformLocation(coefficientShaderProgram, "materialOffset");
+
+	////////////////////
+	//Create Textures//
+	////////////////////
+
+	std::vector<float> zeros(std::max(width * height, INPLACE_AUDIO_CAPACITY), 0.0f);
+	planes[0] = createTexture(GL_R32F, GL_RED, GL_FLOAT, width, height, &zeros[0]);
+	planes[1] = createTexture(GL_R32F, GL_RED, GL_FLOAT, width, height, &zeros[0]);
+	audioTexture = createTexture(GL_R32F, GL_RED, GL_FLOAT, INPLACE_AUDIO_CAPACITY, 1, &zeros[0]);
+	cellTypeTexture = createTexture(GL_R8UI, GL_RED_INTEGER, GL_UNSIGNED_BYTE, width, height, NULL);
+	coefficientTexture = createTexture(GL_RGBA32F, GL_RGBA, GL_FLOAT, width, height, NULL);
+	materialTexture = createTexture(GL_RGBA32F, GL_RGBA, GL_FLOAT, width, height, NULL);
+
+	glGenFramebuffers(1, &coefficientFbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, coefficientFbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, coefficientTexture, 0);
+
+	//Simulation draws write nothing but images, so their framebuffer only needs a size//
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferParameteri(GL_FRAMEBUFFER, GL_FRAMEBUFFER_DEFAULT_WIDTH, width);
+	glFramebufferParameteri(GL_FRAMEBUFFER, GL_FRAMEBUFFER_DEFAULT_HEIGHT, height);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Error creating attachmentless framebuffer." << std::endl;
+		glDeleteFramebuffers(1, &fbo);
+		fbo = 0;
+	}
+
+	domain = buildDomain(settings);
+	domain.cellTypes[settings.listenerPosition[1] * width + settings.listenerPosition[0]] |= CELL_LISTENER;
+	uploadDomain();
+
+	setExcitationPosition(settings.excitationPosition[0], settings.excitationPosition[1]);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glUseProgram(0);
+}
+
+InPlaceGLSolver::~InPlaceGLSolver()
+{
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteFramebuffers(1, &coefficientFbo);
+	glDeleteTextures(2, planes);
+	glDeleteTextures(1, &audioTexture);
+	glDeleteTextures(1, &cellTypeTexture);
+	glDeleteTextures(1, &coefficientTexture);
+	glDeleteTextures(1, &materialTexture);
+	glDeleteVertexArrays(1, &vao);
+	glDeleteProgram(coefficientShaderProgram);
+	glDeleteProgram(inPlaceShaderProgram);
+}
+
+bool InPlaceGLSolver::isValid() const
+{
+	return inPlaceShaderProgram != 0 && coefficientShaderProgram != 0 && fbo != 0;
+}
+
+const char* InPlaceGLSolver::getName() const
+{
+	return "GL in place";
+}
+
+void InPlaceGLSolver::uploadDomain()
+{
+	//Rows of bytes aren't 4 byte aligned unless the width happens to be//
+	glBindTexture(GL_TEXTURE_2D, cellTypeTexture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RED_INTEGER, GL_UNSIGNED_BYTE, &domain.cellTypes[0]);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	std::vector<float> material = computeMaterialTexels(domain);
+	glBindTexture(GL_TEXTURE_2D, materialTexture);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_FLOAT, &material[0]);
+
+	updateCoefficients();
+}
+
+void InPlaceGLSolver::updateCoefficients()
+{
+	MaterialOffset offset = materialRamp.getOffset();
+	glUseProgram(coefficientShaderProgram);
+	glUniform3f(materialOffsetLocation, offset.propagation, offset.damping, offset.boundaryGain);
+	glBindVertexArray(vao);
+	glBindFramebuffer(GL_FRAMEBUFFER, coefficientFbo);
+	glActiveTexture(GL_TEXTURE3);
+	glBindTexture(GL_TEXTURE_2D, materialTexture);
+	glViewport(0, 0, width, height);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+int InPlaceGLSolver::rampMaterial(int numSamples)
+{
+	bool isChanged;
+	int segment = materialRamp.advance(numSamples, isChanged);
+	if (isChanged)
+		updateCoefficients();
+	return segment;
+}
+
+void InPlaceGLSolver::process(const float* excitation, float* output, int numSamples)
+{
+	bool isTimingGPU = (processCount++ % GPU_TIMING_INTERVAL) == 0;
+	if (isTimingGPU)
+		simulateTimer.collect();
+
+	//The audio image holds INPLACE_AUDIO_CAPACITY samples, so larger requests are read back in several chunks//
+	int samplesDone = 0;
+	int segmentEnd = 0;
+	while (samplesDone != numSamples)
+	{
+		int chunkSize = std::min(numSamples - samplesDone, INPLACE_AUDIO_CAPACITY);
+
+		StageTimer simulateStageTimer;
+		TRACE_SPAN_BEGIN(simulateSpan, "simulate");
+		if (isTimingGPU)
+			simulateTimer.begin();
+		for (int n = 0; n != chunkSize; ++n)
+		{
+			if (samplesDone + n == segmentEnd)
+				segmentEnd += rampMaterial(numSamples - segmentEnd);
+
+			glUseProgram(inPlaceShaderProgram);
+			glBindVertexArray(vao);
+			glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+			glViewport(0, 0, width, height);
+			glActiveTexture(GL_TEXTURE1);
+			glBindTexture(GL_TEXTURE_2D, cellTypeTexture);
+			glActiveTexture(GL_TEXTURE2);
+			glBindTexture(GL_TEXTURE_2D, coefficientTexture);
+			glActiveTexture(GL_TEXTURE0);
+
+			//Roles of the planes swap every step by rebinding, never by copying//
+			glBindImageTexture(0, planes[currentPlane], 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+			glBindImageTexture(1, planes[1 - currentPlane], 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32F);
+			glBindImageTexture(2, audioTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+			glUniform1f(excitationMagnitudeLocation, excitation[samplesDone + n]);
+			glUniform1i(audioIndexLocation, n);
+			glDrawArrays(GL_TRIANGLES, 0, 3);
+
+			//Next step reads this one's stores as its current plane//
+			glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+			currentPlane = 1 - currentPlane;
+		}
+		if (isTimingGPU)
+			simulateTimer.end();
+		TRACE_SPAN_END(simulateSpan);
+		profiler.recordCPU(STAGE_SIMULATE, simulateStageTimer.elapsed());
+
+		//Retrieve the chunk's audio - Whole image, as glGetTexImage has no sub range before 4.5//
+		StageTimer readbackStageTimer;
+		TRACE_SPAN_BEGIN(readbackSpan, "readback");
+		std::vector<float> samples(INPLACE_AUDIO_CAPACITY);
+		glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		glBindTexture(GL_TEXTURE_2D, audioTexture);
+		glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_FLOAT, &samples[0]);
+		std::copy(samples.begin(), samples.begin() + chunkSize, output + samplesDone);
+		TRACE_SPAN_END(readbackSpan);
+		profiler.recordCPU(STAGE_READBACK, readbackStageTimer.elapsed());
+
+		samplesDone += chunkSize;
+	}
+}
+
+void InPlaceGLSolver::setExcitationPosition(float x, float y)
+{
+	excitationCell[0] = std::min(std::max((int)(x * width), 0), width - 1);
+	excitationCell[1] = std::min(std::max((int)(y * height), 0), height - 1);
+	glUseProgram(inPlaceShaderProgram);
+	glUniform2i(excitationCellLocation, excitationCell[0], excitationCell[1]);
+}
+
+void InPlaceGLSolver::setMaterial(float propagation, float damping, float boundaryGain)
+{
+	materialRamp.setTarget(propagation, damping, boundaryGain);
+}
+
+double InPlaceGLSolver::getEnergy()
+{
+	//Reduced on the CPU from a snapshot - ParkedSolver only asks once the listener has gone quiet//
+	std::vector<float> current(width * height);
+	std::vector<float> previous(width * height);
+	glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, planes[currentPlane]);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_FLOAT, &current[0]);
+	glBindTexture(GL_TEXTURE_2D, planes[1 - currentPlane]);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_FLOAT, &previous[0]);
+	return computeFieldEnergy(domain, &current[0], &previous[0]);
+}
+
+void InPlaceGLSolver::getField(float* field)
+{
+	TRACE_SCOPE("snapshot");
+
+	std::vector<float> current(width * height);
+	std::vector<float> previous(width * height);
+	glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, planes[currentPlane]);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_FLOAT, &current[0]);
+	glBindTexture(GL_TEXTURE_2D, planes[1 - currentPlane]);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_FLOAT, &previous[0]);
+
+	for (int i = 0; i != width * height; ++i)
+	{
+		field[i * 4 + 0] = current[i];
+		field[i * 4 + 1] = previous[i];
+		field[i * 4 + 2] = getTransmission(domain.cellTypes[i]);
+		field[i * 4 + 3] = domain.cellTypes[i];
+	}
+}
+
+void InPlaceGLSolver::setField(const float* field)
+{
+	std::vector<float> current(width * height);
+	std::vector<float> previous(width * height);
+	for (int i = 0; i != width * height; ++i)
+	{
+		current[i] = field[i * 4 + 0];
+		previous[i] = field[i * 4 + 1];
+		domain.cellTypes[i] = (uint8_t)field[i * 4 + 3];
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, planes[currentPlane]);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RED, GL_FLOAT, &current[0]);
+	glBindTexture(GL_TEXTURE_2D, planes[1 - currentPlane]);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RED, GL_FLOAT, &previous[0]);
+	uploadDomain();
+}
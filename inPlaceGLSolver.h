@@ -0,0 +1,77 @@
+#pragma once
+
+#include <glad\glad.h>
+
+#include "solver.h"
+#include "domain.h"
+#include "materialRamp.h"
+#include "gpuTimer.h"
+
+///////////
+//DEFINES//
+///////////
+
+#define INPLACE_AUDIO_CAPACITY	4096	//Listener samples the audio image holds before it must be read back.
+
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//InPlaceGLSolver - gl-fbo's model with pressure held in a single pair of R32F planes instead  //
+//of two quads of current and previous pressure. inplace_fs.glsl reads neighbours from the     //
+//current plane with image loads and stores the next timestep over the previous one, so the   //
+//field is stored twice rather than four times. Draws render into a framebuffer without       //
+//attachments, separated by image access barriers. Needs an OpenGL 4.3 context.              //
+/////////////////////////////////////////////////////////////////////////////////////////////////
+class InPlaceGLSolver : public Solver {
+private:
+	SolverSettings settings;
+	Domain domain;					//Cell types and material as uploaded to cellTypeTexture and materialTexture.
+	MaterialRamp materialRamp;
+	int width;
+	int height;
+
+	//OpenGL objects//
+	GLuint inPlaceShaderProgram = 0;
+	GLuint coefficientShaderProgram = 0;	//Folds material and its runtime offset into coefficientTexture.
+	GLuint vao = 0;					//Vertices come from the vertex index - Bound only because a draw needs one.
+	GLuint fbo = 0;					//No attachments - Only sizes the draws, which write images.
+	GLuint planes[2] = { 0, 0 };	//R32F pressure - Alternately hold timestep n & n-1.
+	GLuint cellTypeTexture = 0;		//Domain sized R8UI texture of CELL_ bits.
+	GLuint coefficientTexture = 0;	//Domain sized RGBA32F texture of update coefficients [centre, previous, neighbour, unused].
+	GLuint materialTexture = 0;		//Domain sized RGBA32F texture of computeMaterialTexels().
+	GLuint coefficientFbo = 0;		//Renders into coefficientTexture.
+	GLuint audioTexture = 0;		//R32F listener sample of each step.
+
+	//Uniform Locations//
+	GLint excitationCellLocation;
+	GLint excitationMagnitudeLocation;
+	GLint audioIndexLocation;
+	GLint materialOffsetLocation;
+
+	int currentPlane = 0;			//Plane holding timestep n.
+	int excitationCell[2];
+
+	GPUTimer simulateTimer;
+	int processCount = 0;
+
+	//Upload domain's cell types and material into their textures, then recompute coefficients//
+	void uploadDomain();
+
+	//Draw the current material into coefficientTexture//
+	void updateCoefficients();
+
+	//Glide material over the next steps of a block of numSamples, recomputing coefficients if it moved - Returns the steps to run before calling again//
+	int rampMaterial(int numSamples);
+
+public:
+	InPlaceGLSolver(const SolverSettings& aSettings);
+	~InPlaceGLSolver();
+
+	bool isValid() const;
+
+	const char* getName() const;
+	void process(const float* excitation, float* output, int numSamples);
+	void setExcitationPosition(float x, float y);
+	void setMaterial(float propagation, float damping, float boundaryGain);
+	double getEnergy();
+	void getField(float* field);
+	void setField(const float* field);
+};
@@ -0,0 +1,220 @@
+#include "kSpaceSolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "domainBuilder.h"
+#include "simdSolver.h"
+#include "profiler.h"
+#include "tracer.h"
+
+#ifdef SIMD_SOLVER_AVAILABLE
+#include <emmintrin.h>
+#endif
+
+KSpaceSolver::KSpaceSolver(const SolverSettings& aSettings) : settings(aSettings), materialRamp(aSettings),
+	rowTransform(aSettings.domainSize[0] - 2, aSettings.boundaryGain == 0.0f), columnTransform(aSettings.domainSize[1] - 2, aSettings.boundaryGain == 0.0f)
+{
+	width = settings.domainSize[0];
+	height = settings.domainSize[1];
+	domain = buildDomain(settings);
+	domain.cellTypes[settings.listenerPosition[1] * width + settings.listenerPosition[0]] |= CELL_LISTENER;
+
+	numModes = (width - 2) * (height - 2);
+	numPaddedModes = (numModes + 3) & ~3;
+	amplitude[0].assign(numPaddedModes, 0.0f);
+	amplitude[1].assign(numPaddedModes, 0.0f);
+	transformWork.resize(numModes);
+
+	//Modes of each axis combine as |k|^2 = kx^2 + ky^2//
+	wavenumber.assign(numPaddedModes, 0.0f);
+	for (int n = 0; n != height - 2; ++n)
+	{
+		for (int m = 0; m != width - 2; ++m)
+		{
+			double kx = rowTransform.getWavenumber(m);
+			double ky = columnTransform.getWavenumber(n);
+			wavenumber[n * (width - 2) + m] = (float)std::sqrt(kx * kx + ky * ky);
+		}
+	}
+	computeModeCoefficients();
+
+	computeWeights(settings.listenerPosition[0], settings.listenerPosition[1], listenerWeight);
+	setExcitationPosition(settings.excitationPosition[0], settings.excitationPosition[1]);
+}
+
+const char* KSpaceSolver::getName() const
+{
+	return "CPU k-space";
+}
+
+void KSpaceSolver::computeModeCoefficients()
+{
+	//Material is uniform, so any interior cell holds it - Already scaled to the step rate//
+	MaterialOffset offset = materialRamp.getOffset();
+	int cell = width + 1;
+	double prop = std::min(std::max((double)domain.propagation[cell] + offset.propagation, 0.0), 0.5);
+	double damp = std::max((double)domain.damping[cell] + offset.damping, 0.0);
+
+	//Exact time step of each mode - The FDTD scheme's 2 - propagation * |k|^2 to leading order//
+	centre.assign(numPaddedModes, 0.0f);
+	double speed = std::sqrt(prop);
+	for (int k = 0; k != numModes; ++k)
+		centre[k] = (float)(2.0 * std::cos(speed * wavenumber[k]) / (1.0 + damp));
+	previousCoefficient = (float)((damp - 1.0) / (1.0 + damp));
+}
+
+void KSpaceSolver::computeWeights(int x, int y, std::vector<float>& weights) const
+{
+	weights.assign(numPaddedModes, 0.0f);
+	if (x < 1 || y < 1 || x >= width - 1 || y >= height - 1)
+		return;
+
+	for (int n = 0; n != height - 2; ++n)
+	{
+		double rowWeight = columnTransform.getBasis(n, y - 1);
+		for (int m = 0; m != width - 2; ++m)
+			weights[n * (width - 2) + m] = (float)(rowWeight * rowTransform.getBasis(m, x - 1));
+	}
+}
+
+void KSpaceSolver::toCells(const float* modes, float* cells, int cellStride)
+{
+	int interiorWidth = width - 2;
+	for (int k = 0; k != numModes; ++k)
+		transformWork[k] = modes[k];
+
+	//Separable - Columns then rows//
+	for (int m = 0; m != interiorWidth; ++m)
+		columnTransform.toCells(&transformWork[m], &transformWork[m], interiorWidth);
+	for (int n = 0; n != height - 2; ++n)
+		rowTransform.toCells(&transformWork[n * interiorWidth], &transformWork[n * interiorWidth]);
+
+	for (int y = 1; y != height - 1; ++y)
+	{
+		for (int x = 1; x != width - 1; ++x)
+			cells[(y * width + x) * cellStride] = (float)transformWork[(y - 1) * interiorWidth + x - 1];
+	}
+}
+
+void KSpaceSolver::toModes(const float* cells, int cellStride, float* modes)
+{
+	int interiorWidth = width - 2;
+	for (int y = 1; y != height - 1; ++y)
+	{
+		for (int x = 1; x != width - 1; ++x)
+			transformWork[(y - 1) * interiorWidth + x - 1] = cells[(y * width + x) * cellStride];
+	}
+
+	for (int n = 0; n != height - 2; ++n)
+		rowTransform.toModes(&transformWork[n * interiorWidth], &transformWork[n * interiorWidth]);
+	for (int m = 0; m != interiorWidth; ++m)
+		columnTransform.toModes(&transformWork[m], &transformWork[m], interiorWidth);
+
+	for (int k = 0; k != numModes; ++k)
+		modes[k] = (float)transformWork[k];
+}
+
+int KSpaceSolver::rampMaterial(int numSamples)
+{
+	bool isChanged;
+	int segment = materialRamp.advance(numSamples, isChanged);
+	if (isChanged)
+		computeModeCoefficients();
+	return segment;
+}
+
+void KSpaceSolver::process(const float* excitation, float* output, int numSamples)
+{
+	StageTimer simulateStageTimer;
+	TRACE_SCOPE("simulate");
+
+	int n = 0;
+	while (n != numSamples)
+	{
+		int segmentEnd = n + rampMaterial(numSamples - n);
+		for (; n != segmentEnd; ++n)
+		{
+			const float* current = &amplitude[currentPlane][0];
+			float* previous = &amplitude[1 - currentPlane][0];
+			float drive = excitation[n];
+
+			//Every mode in one pass - Next amplitude over previous, excitation added and listener summed on the way//
+#ifdef SIMD_SOLVER_AVAILABLE
+			const __m128 previousScale = _mm_set1_ps(previousCoefficient);
+			const __m128 driveScale = _mm_set1_ps(drive);
+			__m128 sum = _mm_setzero_ps();
+			for (int k = 0; k != numPaddedModes; k += 4)
+			{
+				__m128 next = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&centre[k]), _mm_loadu_ps(current + k)), _mm_mul_ps(previousScale, _mm_loadu_ps(previous + k)));
+				if (drive != 0.0f)
+					next = _mm_add_ps(next, _mm_mul_ps(driveScale, _mm_loadu_ps(&excitationWeight[k])));
+				_mm_storeu_ps(previous + k, next);
+				sum = _mm_add_ps(sum, _mm_mul_ps(next, _mm_loadu_ps(&listenerWeight[k])));
+			}
+			float lanes[4];
+			_mm_storeu_ps(lanes, sum);
+			output[n] = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+			float sum = 0.0f;
+			for (int k = 0; k != numPaddedModes; ++k)
+			{
+				float next = centre[k] * current[k] + previousCoefficient * previous[k];
+				next += drive * excitationWeight[k];
+				previous[k] = next;
+				sum += next * listenerWeight[k];
+			}
+			output[n] = sum;
+#endif
+
+			currentPlane = 1 - currentPlane;
+		}
+	}
+
+	profiler.recordCPU(STAGE_SIMULATE, simulateStageTimer.elapsed());
+}
+
+void KSpaceSolver::setExcitationPosition(float x, float y)
+{
+	int cellX = std::min(std::max((int)(x * width), 0), width - 1);
+	int cellY = std::min(std::max((int)(y * height), 0), height - 1);
+	computeWeights(cellX, cellY, excitationWeight);
+}
+
+void KSpaceSolver::setMaterial(float propagation, float damping, float boundaryGain)
+{
+	//Boundary gain picks the modes, so is fixed on creation - Propagation and damping still glide//
+	if (boundaryGain != settings.boundaryGain)
+		std::cout << "cpu-kspace can't change boundary gain from " << settings.boundaryGain << " while running - Ignoring " << boundaryGain << "." << std::endl;
+	materialRamp.setTarget(propagation, damping, settings.boundaryGain);
+}
+
+double KSpaceSolver::getEnergy()
+{
+	std::vector<float> current(width * height, 0.0f);
+	std::vector<float> previous(width * height, 0.0f);
+	toCells(&amplitude[currentPlane][0], &current[0], 1);
+	toCells(&amplitude[1 - currentPlane][0], &previous[0], 1);
+	return computeFieldEnergy(domain, &current[0], &previous[0]);
+}
+
+void KSpaceSolver::getField(float* field)
+{
+	for (int i = 0; i != width * height; ++i)
+	{
+		field[i * 4 + 0] = 0.0f;
+		field[i * 4 + 1] = 0.0f;
+		field[i * 4 + 2] = getTransmission(domain.cellTypes[i]);
+		field[i * 4 + 3] = domain.cellTypes[i];
+	}
+	toCells(&amplitude[currentPlane][0], field + 0, 4);
+	toCells(&amplitude[1 - currentPlane][0], field + 1, 4);
+}
+
+void KSpaceSolver::setField(const float* field)
+{
+	//Cell types are ignored - Only the full rectangle has these modes//
+	toModes(field + 0, 4, &amplitude[currentPlane][0]);
+	toModes(field + 1, 4, &amplitude[1 - currentPlane][0]);
+}
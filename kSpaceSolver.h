@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+
+#include "solver.h"
+#include "domain.h"
+#include "materialRamp.h"
+#include "fft.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//KSpaceSolver - Pseudo-spectral solver for the full rectangle of uniform material. The    //
+//Laplacian is diagonal over the grid's standing wave modes - sine modes for walls of gain //
+//0, cosine modes for gain 1 - so each mode is advanced on its own with the exact k-space  //
+//update 2cos(sqrt(propagation) * |k|), free of the 5 point stencil's dispersion up to 2   //
+//cells per wavelength. As the medium is uniform the field stays in mode space between    //
+//steps - Excitation and listener are projected through each mode's value at their cell,  //
+//and the FFT based ModeTransform only moves the field to and from cells in getField(),     //
+//setField() and getEnergy(). Matches the FDTD backends on low modes, so it plays the same  //
+//drum on a coarser grid.                                                                   //
+//////////////////////////////////////////////////////////////////////////////////////////////
+class KSpaceSolver : public Solver {
+private:
+	SolverSettings settings;
+	Domain domain;						//Rectangle the field is drawn into - Walls and listener only.
+	MaterialRamp materialRamp;
+	int width;
+	int height;
+	ModeTransform rowTransform;			//Across the interior of a row.
+	ModeTransform columnTransform;		//Up the interior of a column.
+	int numModes;						//Interior cells, which is also the number of modes.
+	int numPaddedModes;					//numModes rounded up to a whole SSE vector - Extra modes have zero coefficients.
+
+	//Mode space state, mode (m, n) at n * (width - 2) + m//
+	std::vector<float> amplitude[2];	//Mode amplitudes - Alternately hold timestep n & n-1.
+	int currentPlane = 0;
+	std::vector<float> wavenumber;		//|k| of every mode in radians per cell.
+	std::vector<float> centre;			//2cos(sqrt(propagation) * |k|) / (1 + damping) of every mode.
+	float previousCoefficient;			//(damping - 1) / (1 + damping), shared by every mode.
+	std::vector<float> excitationWeight;	//Each mode's basis value at the excitation cell.
+	std::vector<float> listenerWeight;		//Each mode's basis value at the listener cell.
+	std::vector<double> transformWork;		//Interior of the grid while transforming.
+
+	//Recompute mode coefficients for the domain's material under the current offset//
+	void computeModeCoefficients();
+
+	//Basis values of every mode at a grid cell - Zero for cells of the outer ring//
+	void computeWeights(int x, int y, std::vector<float>& weights) const;
+
+	//Mode amplitudes of a plane to cells, and back - Interior only, the ring is left alone//
+	void toCells(const float* modes, float* cells, int cellStride);
+	void toModes(const float* cells, int cellStride, float* modes);
+
+	//Glide material over the next steps of a block of numSamples, recomputing coefficients if it moved - Returns the steps to run before calling again//
+	int rampMaterial(int numSamples);
+
+public:
+	KSpaceSolver(const SolverSettings& aSettings);
+
+	const char* getName() const;
+	void process(const float* excitation, float* output, int numSamples);
+	void setExcitationPosition(float x, float y);
+
+	//Glides propagation and damping - boundaryGain must stay the gain of creation, as it picks the modes, and any other is refused with a message//
+	void setMaterial(float propagation, float damping, float boundaryGain);
+
+	double getEnergy();
+	void getField(float* field);
+	void setField(const float* field);
+};
@@ -1,12 +1,15 @@
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <string>
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
 #include <cstdio>
+#include <thread>
 #include <windows.h>
 
-#include <glad\glad.h> 
+#include <glad\glad.h>
 #include <GLFW\glfw3.h>
 
 #include <SFML/Audio.hpp>
@@ -14,31 +17,41 @@
 
 #include "squareWave.h"
 #include "sineWave.h"
+#include "solverFactory.h"
+#include "shaderProgram.h"
+#include "ringBuffer.h"
+#include "tripleBuffer.h"
+#include "audioStream.h"
+#include "profiler.h"
+#include "gpuTimer.h"
+#include "tracer.h"
+#include "checkpoint.h"
+#include "domainBuilder.h"
+#include "oversampledSolver.h"
+#include "parkedSolver.h"
 
 ///////////
 //DEFINES//
 ///////////
 
-#define NUM_OF_TIMESTEPS	2		//Number of textures which hold simulation model time steps.
 #define MAGNIFIER			10		//The factor which the model is scaled by when rendering the texture to screen.
-#define MICROSECS_IN_SEC	1000000	//Microseconds in second - Might be used to play recorded samples everysecond.
-
-//Index into vertices to indentify texture Quad//
-#define QUAD0				0		//The first simulation model grid - Alternatively switches between timestep n & n-1.
-#define QUAD1				1		//The second simulation model grid - Alteratively switches between timestep n-1 & n.
-#define QUAD2				2		//The audio buffer - Single fragment strip acting as a buffer for recording samples from listener point. 
+#define DISPLAY_RATE		60		//Field snapshots published per second of simulated audio - Visualisation never needs more.
+#define AUDIO_RING_SIZE		8192	//Samples queued between simulation and audio threads - Bounds how far simulation runs ahead of playback.
+#define PROFILE_DUMP_INTERVAL	5	//Seconds between printing profiler histograms.
+#define PROPAGATION_STEP	0.02f	//Propagation change per press of up/down.
+#define DAMPING_STEP		1.5f	//Damping factor per press of right/left - Multiplied, as useful values span decades.
+#define MIN_DAMPING			0.0001f	//Damping right raises zero damping to.
+#define GAIN_STEP			0.1f	//Boundary gain change per press of page up/down.
+#define STRIKE_SLIDE_RATE	200.0f	//Cells per second a sliding strike travels towards the clicked point.
+#define LISTENER_ORBIT_PERIOD	4.0f	//Seconds per turn of an orbiting listener.
 
 ////////////////////
 //GLOBAL VARIABLES//
 ////////////////////
 
 //Audio Buffers//
-int sampleCounter = 0;						//Counter used to track when seconds worth of samples collected.
-sf::Int16 realTimeAudioBuffer[54100];		//Records each second of generated samples to play in "real-time".
 std::vector<sf::Int16> playbackAudioBuffer;	//Records all samples generate to play at end of program.
-
-//Clock Variables//
-clock_t realTimeClock;
+RingBuffer<sf::Int16> realTimeAudioBuffer(AUDIO_RING_SIZE);	//Blocks handed from simulation thread to audio thread to play in "real-time".
 
 //SFML Audio Objects//
 sf::SoundBuffer engineSoundBuffer;
@@ -46,47 +59,63 @@ sf::Sound soundEngine;
 
 //Simulation Model Variables//
 int domainSize[2] = { 40, 40 };				//Number of simulation points - The number of cartisian cells in one quad. Used to produce models of both timesteps.
-int ceiling = 2;							//The audio row and isloation row located at top of texture, comprising the "ceiling".
-float excitationPosition[2] = { 0.7,0.5 };	//Contains coordinates of the excitation point - Currently supports one point.
+float excitationPosition[2] = { 0.7,0.5 };	//Contains normalised domain coordinates of the excitation point - Currently supports one point.
 int listenerPosition[2] = { 5,5 };			//Contains coordinates of the audio sampling point - Currently supports one point.
 int buffer_size = 128;						//Size of the audio buffer - The number samples recorded before audio buffer is read.
 
 //User Defined Settings//
 int sampleRate = 44100;													//Rate at which simulation is advanced, and audio sample collected.
 int duration = 20;														//Duration of simulation.
-float maxExcitation = 15.0;												//Amplitude of spike from excitation.
-int excitationFrequency = 20;										//Frequency of spikes. Number of zeros before excitation spike.
-int excitationDuration = sampleRate / excitationFrequency;				//How often strike/excitation.
 SquareWaveExcitor squareWaveExcitor = SquareWaveExcitor();
 SineWaveExcitor sineWaveExcitor = SineWaveExcitor();
-
-/*
-* state0: draw quad0 [left]
-* state1: read audio from quad1 [right] cos quad0 might not be ready yet
-* state2: draw quad1 [right]
-* state3: read audio from quad0 [left] cos quad1 might not be ready yet
-*/
-int state;
-
-
-/////////////////////
-//Uniform Locations//
-/////////////////////
-GLuint stateLocation;
-GLuint excitationPositionLocation;
-GLuint excitationMagnitudeLocation;
-GLuint wrCoordLocation;	
+SolverBackend solverBackend = BACKEND_GL_FBO;									//Backend advancing the model.
+StoragePrecision storagePrecision = PRECISION_FP32;								//Format pressure is stored in between steps - Computation is always fp32.
+std::string domainShape;														//Drum shape description, see domainBuilder.h - Empty for the rectangle.
+std::string materialMap;														//Per cell material description, see domainBuilder.h - Empty for uniform.
+bool isAbsorbingEdges = false;													//Let waves out through the grid's edges rather than reflect them.
+int spongeLayer = 0;															//Cells of sponge layer along each edge of the grid - 0 for none.
+float silenceFloor = DEFAULT_SILENCE_FLOOR;										//Field energy the solver parks below until the next strike - 0 keeps it stepping.
+bool isFoldingSymmetry = true;													//Step half or a quarter of a mirror symmetric drum struck on its axis - cpu-simd and cpu-threaded.
+bool isTrackingActiveTiles = false;												//Step only tiles a strike has reached - cpu-simd and gl-compute.
+int domainDepth = 1;															//Layers of a room extruded from the drum - 1 for the 2D membrane.
+int numStrings = 0;															//Strings of a bank played instead of the drum - 0 for the drum.
+float plateStiffness = 0.0f;													//Squared stiffness of a plate played instead of the membrane - 0 for the membrane.
+bool isUpdatingInPlace = false;													//Overwrite previous pressure in place - Moves gl-fbo onto image load/store.
+bool isSlidingStrike = false;													//Clicks slide the excitation to the point between cells rather than jumping - Backends with isProbePathSupported().
+float listenerOrbit = 0.0f;														//Radius in cells the listener circles its cell at - 0 keeps it still. Backends with isProbePathSupported().
+
+//Thread Communication//
+std::atomic<bool> isRunning(true);				//Cleared by whichever thread finishes first to stop the others.
+TripleBuffer<std::array<float, 2>> excitationClicks;	//Latest point clicked in the mouse callback for the simulation thread, normalised like excitationPosition.
+TripleBuffer<std::vector<float>> fieldSnapshots;	//Latest field from simulation thread for the visualisation thread.
+std::atomic<bool> isCheckpointRequested(false);	//Set by visualisation thread on S key, consumed by simulation thread.
+float materialParameters[3];					//Uniform [propagation, damping, boundaryGain] - Stepped by the key callback, only touched by the visualisation thread.
+TripleBuffer<std::array<float, 3>> materialChanges;	//Latest materialParameters from the key callback for the simulation thread.
+float maxPropagation = CFL_LIMIT;				//Largest propagation stable at the chosen steps per sample.
+
+//Checkpoints//
+std::string checkpointPath;				//File the model is saved to on S key and on exit - Empty disables saving.
+MappedCheckpoint restoredCheckpoint;	//Model state to warm start from - Open only if restoring.
 
 ////////////////////
 //HELPER FUNCTIONS//
 ////////////////////
 
-//OpenGL function to load specific text files into a OpenGL shader program//
-bool loadShaderProgram(const char* vertexShaderPath, const char* fragmentShaderPath, GLuint& shaderProgram);
+//Simulation thread - Advances the solver block by block and feeds audio and visualisation//
+void simulate(GLFWwindow* simulationContext, SolverSettings settings);
+
+//Save the solver's model and the excitors to checkpointPath//
+void writeCheckpoint(Solver* solver, const SolverSettings& settings, const float* excitationPoint, const float* material, uint64_t sampleCount);
+
+//Scale a pressure value to signed 16 bit sample//
+sf::Int16 toInt16Sample(float sample);
 
 //On mouse click callback - Handles setting new excitation point//
 void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
 
+//On key callback - Arrow and page keys change the material while running//
+void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+
 int main(int argc, char* argv[])
 {
 	//Command line control//
@@ -96,21 +125,230 @@ int main(int argc, char* argv[])
 	//dampingFactor = std::stoi(argv[2]);
 	//boundaryGain = std::stoi(argv[3]);
 	//isSingleExcitation = *argv[4] == '1';
-	
+
+	//Options - --backend <name> selects the solver, --trace <file.json> records an opt-in timeline of the pipeline//
+	//--precision <fp32|fp16|bf16|q15> stores pressure in 16 bits between steps, for backends with isPrecisionSupported()//
+	//--checkpoint <file> saves the model on S key and exit, --restore <file> starts from a saved model//
+	//--shape <description> rasterises the drum from shapes and images instead of the rectangle, --material <description> varies the material over it//
+	//--absorbing-edges 1 lets waves out through the grid's edges instead of reflecting them, for open fields, --sponge-layer <cells> damps what they still reflect over that many cells//
+	//--silence-floor <energy> sets the field energy the solver stops stepping below, 0 to never park//
+	//--fold 0 steps a mirror symmetric drum struck on its axis whole, rather than only its fundamental region//
+	//--active-tiles 1 steps only the tiles a strike has reached, for backends with isActiveTilingSupported()//
+	//--depth <layers> extrudes the drum into a room of that many layers, listening and striking half way up, for backends with isVolumeSupported()//
+	//--strings <count> plays a bank of 1D strings tuned down from the grid width instead of the drum, for backends with isStringBankSupported()//
+	//--plate <stiffness> plays a stiff plate with that squared stiffness per sample instead of the membrane, for backends with isPlateSupported()//
+	//--in-place 1 stores pressure as a single pair of planes updated in place, for backends with isInPlaceSupported()//
+	//--slide 1 slides the excitation to a clicked point, --listener-orbit <cells> circles the listener around its cell, for backends with isProbePathSupported()//
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		std::string option = argv[i];
+		if (option == "--backend")
+		{
+			solverBackend = findBackend(argv[i + 1]);
+			if (solverBackend == NUM_OF_BACKENDS)
+			{
+				std::cout << "Unknown backend " << argv[i + 1] << std::endl;
+				return -1;
+			}
+		}
+		else if (option == "--precision")
+		{
+			storagePrecision = findPrecision(argv[i + 1]);
+			if (storagePrecision == NUM_OF_PRECISIONS)
+			{
+				std::cout << "Unknown precision " << argv[i + 1] << std::endl;
+				return -1;
+			}
+		}
+		else if (option == "--shape")
+		{
+			std::string error;
+			domainShape = argv[i + 1];
+			if (!validateShape(domainShape, error))
+			{
+				std::cout << "Invalid shape " << domainShape << " - " << error << std::endl;
+				return -1;
+			}
+		}
+		else if (option == "--material")
+		{
+			std::string error;
+			materialMap = argv[i + 1];
+			if (!validateMaterial(materialMap, error))
+			{
+				std::cout << "Invalid material " << materialMap << " - " << error << std::endl;
+				return -1;
+			}
+		}
+		else if (option == "--silence-floor")
+		{
+			silenceFloor = std::stof(argv[i + 1]);
+			if (silenceFloor < 0.0f)
+			{
+				std::cout << "Silence floor must be >= 0" << std::endl;
+				return -1;
+			}
+		}
+		else if (option == "--absorbing-edges")
+			isAbsorbingEdges = std::string(argv[i + 1]) == "1";
+		else if (option == "--sponge-layer")
+		{
+			spongeLayer = std::stoi(argv[i + 1]);
+			if (spongeLayer < 0)
+			{
+				std::cout << "Sponge layer must be >= 0 cells" << std::endl;
+				return -1;
+			}
+		}
+		else if (option == "--fold")
+			isFoldingSymmetry = std::string(argv[i + 1]) == "1";
+		else if (option == "--active-tiles")
+			isTrackingActiveTiles = std::string(argv[i + 1]) == "1";
+		else if (option == "--depth")
+		{
+			domainDepth = std::stoi(argv[i + 1]);
+			if (domainDepth < 1)
+			{
+				std::cout << "Depth must be >= 1" << std::endl;
+				return -1;
+			}
+		}
+		else if (option == "--strings")
+			numStrings = std::stoi(argv[i + 1]);
+		else if (option == "--plate")
+			plateStiffness = std::stof(argv[i + 1]);
+		else if (option == "--in-place")
+			isUpdatingInPlace = std::string(argv[i + 1]) == "1";
+		else if (option == "--slide")
+			isSlidingStrike = std::string(argv[i + 1]) == "1";
+		else if (option == "--listener-orbit")
+		{
+			listenerOrbit = std::stof(argv[i + 1]);
+			if (listenerOrbit < 0.0f)
+			{
+				std::cout << "Listener orbit must be >= 0 cells" << std::endl;
+				return -1;
+			}
+		}
+		else if (option == "--checkpoint")
+			checkpointPath = argv[i + 1];
+		else if (option == "--restore")
+		{
+			if (!restoredCheckpoint.open(argv[i + 1]))
+			{
+				std::cout << "Failed to open checkpoint " << argv[i + 1] << std::endl;
+				return -1;
+			}
+		}
+#ifdef FDTD_TRACING
+		else if (option == "--trace")
+		{
+			if (tracer.start(argv[i + 1]))
+				std::cout << "Tracing to " << argv[i + 1] << std::endl;
+			else
+				std::cout << "Failed to open trace file " << argv[i + 1] << std::endl;
+		}
+#endif
+	}
+
+	//Checked once every option is read, as --backend may follow --precision//
+	if (!isPrecisionSupported(solverBackend, storagePrecision))
+	{
+		std::cout << getBackendName(solverBackend) << " does not store pressure in " << getPrecisionName(storagePrecision) << " - See isPrecisionSupported()." << std::endl;
+		return -1;
+	}
+
+	//Checkpoints hold a single layer of cells - Refused for rooms rather than saving or restoring part of one//
+	if (domainDepth > 1 && (!checkpointPath.empty() || restoredCheckpoint.isOpen()))
+	{
+		std::cout << "--checkpoint and --restore need a 2D model - Checkpoints hold one layer, not the " << domainDepth << " of a room." << std::endl;
+		return -1;
+	}
+
+	//Nor the bank of a string bank, which a restore would need to rebuild it//
+	if (numStrings > 0 && (!checkpointPath.empty() || restoredCheckpoint.isOpen()))
+	{
+		std::cout << "--checkpoint and --restore need a drum - Checkpoints do not hold the " << numStrings << " strings of a bank." << std::endl;
+		return -1;
+	}
+
 	///////////////////////////////
 	//Set model static parameters//
 	///////////////////////////////
-	float propagationFactor;
-	std::cout << "Input a propogation factor for membrane material - Valid range [0.0-0.5]: ";
-	std::cin >> propagationFactor;
+	SolverSettings settings;
+	if (restoredCheckpoint.isOpen())
+	{
+		//A restored model keeps the settings it was saved with//
+		settings = getCheckpointSettings(restoredCheckpoint.getHeader());
+		settings.materialMap = materialMap;		//Checkpoints hold cell types but not the material - Give the same --material to restore it.
+		domainSize[0] = settings.domainSize[0];
+		domainSize[1] = settings.domainSize[1];
+		listenerPosition[0] = settings.listenerPosition[0];
+		listenerPosition[1] = settings.listenerPosition[1];
+		excitationPosition[0] = settings.excitationPosition[0];
+		excitationPosition[1] = settings.excitationPosition[1];
+		std::cout << "Restoring model at sample " << restoredCheckpoint.getHeader().sampleCount << std::endl;
+	}
+	else
+	{
+		float propagationFactor;
+		std::cout << "Input a propogation factor for membrane material - Valid range [0.0-0.5], higher values run several steps per sample: ";
+		std::cin >> propagationFactor;
+
+		float dampingFactor;
+		std::cout << "Input a damping factor for membrane material - Valid range [0.0-1.0] but expected very low value: ";
+		std::cin >> dampingFactor;
+
+		float boundaryGain;
+		std::cout << "Input boundary gain. If it is clamped, and therefore reflects - 1 for fully clamped, 0 for free: ";
+		std::cin >> boundaryGain;
+
+		settings.domainSize[0] = domainSize[0];
+		settings.domainSize[1] = domainSize[1];
+		settings.listenerPosition[0] = listenerPosition[0];
+		settings.listenerPosition[1] = listenerPosition[1];
+		settings.excitationPosition[0] = excitationPosition[0];
+		settings.excitationPosition[1] = excitationPosition[1];
+		settings.propagationFactor = propagationFactor;
+		settings.dampingFactor = dampingFactor;
+		settings.boundaryGain = boundaryGain;
+		settings.domainShape = domainShape;
+		settings.materialMap = materialMap;
+	}
 
-	float dampingFactor;
-	std::cout << "Input a damping factor for membrane material - Valid range [0.0-1.0] but expected very low value: ";
-	std::cin >> dampingFactor;
+	settings.storagePrecision = storagePrecision;
+	settings.isAbsorbingEdges = isAbsorbingEdges;
+	settings.spongeLayer = spongeLayer;
+	settings.silenceFloor = silenceFloor;
+	settings.isFoldingSymmetry = isFoldingSymmetry;
+	settings.isTrackingActiveTiles = isTrackingActiveTiles;
+	settings.isUpdatingInPlace = isUpdatingInPlace;
+	settings.domainDepth = domainDepth;
+	settings.numStrings = numStrings;
+	settings.plateStiffness = plateStiffness;
+	settings.listenerLayer = domainDepth / 2;
+
+	//Reject invalid material before a run blows up, running several steps per sample where propagation needs it//
+	std::string stabilityError;
+	if (!applyStabilityGuard(settings, stabilityError))
+	{
+		std::cout << "Unstable material - " << stabilityError << std::endl;
+		return -1;
+	}
+
+	//Moving probes between cells need a backend following paths - Refused rather than left on whole cells without a word//
+	if ((isSlidingStrike || listenerOrbit > 0.0f) && !isProbePathSupported(solverBackend))
+	{
+		std::cout << "--slide and --listener-orbit need a backend following probe paths (cpu-scalar, cpu-simd or cpu-threaded) - " << getBackendName(solverBackend) << " keeps them on whole cells." << std::endl;
+		return -1;
+	}
+	if (settings.oversampling > 1)
+		std::cout << "Running " << settings.oversampling << " steps per sample for stability." << std::endl;
+	maxPropagation = getCFLLimit(settings) * settings.oversampling * settings.oversampling - 8.0f * settings.plateStiffness;
 
-	float boundaryGain;
-	std::cout << "Input boundary gain. If it is clamped, and therefore reflects - 1 for fully clamped, 0 for free: ";
-	std::cin >> boundaryGain;
+	materialParameters[0] = settings.propagationFactor;
+	materialParameters[1] = settings.dampingFactor;
+	materialParameters[2] = settings.boundaryGain;
 
 	bool isSingleExcitation;	//Indicates if interactions with mouse cause a single or continouse excitation.
 	std::cout << "Single or continous excitation - 0 for continous, 1 for single: ";
@@ -121,11 +359,11 @@ int main(int argc, char* argv[])
 	//////////////////////////
 	glfwInit();
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 
-	//Create GLFW window//
+	//Create GLFW window - Owned by the visualisation thread, which is the main thread as GLFW requires//
 	GLFWwindow* window = glfwCreateWindow(domainSize[0] * MAGNIFIER, domainSize[1] * MAGNIFIER, "LearnOpenGL", NULL, NULL);
 	if (window == NULL)
 	{
@@ -133,8 +371,21 @@ int main(int argc, char* argv[])
 		glfwTerminate();
 		return -1;
 	}
+
+	//Create hidden window - Only provides the simulation thread its own OpenGL context//
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* simulationContext = glfwCreateWindow(1, 1, "Simulation", NULL, NULL);
+	if (simulationContext == NULL)
+	{
+		std::cout << "Failed to create simulation context" << std::endl;
+		glfwTerminate();
+		return -1;
+	}
+
 	glfwMakeContextCurrent(window);
 	glfwSetMouseButtonCallback(window, mouseButtonCallback);
+	glfwSetKeyCallback(window, keyCallback);
+	glfwSwapInterval(1);	//Render at display rate.
 
 	//Initialize GLAD for loading OpenGL function pointers etc - Alternative to GLEW//
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
@@ -148,341 +399,184 @@ int main(int argc, char* argv[])
 	//Load Shader Programs//
 	////////////////////////
 
-	const char* vertex_fbo_shader_path = { "Shaders/fbo_vs.glsl" };			//Vertex shader of solver program
-	const char* fragment_fbo_shader_path = { "Shaders/fbo_fs.glsl" };		//Fragment shader of solver program
 	const char* vertex_render_shader_path = { "Shaders/render_vs.glsl" };	//Vertex shader of render program
 	const char* fragment_render_shader_path = { "Shaders/render_fs.glsl" }; //Fragment shader of render program
 
-	GLuint fboShaderProgram = 0;
-	if (!loadShaderProgram(vertex_fbo_shader_path, fragment_fbo_shader_path, fboShaderProgram))
-		std::cout << "Failed to create fbo shader." << std::endl;
-
 	GLuint renderShaderProgram = 0;
 	if (!loadShaderProgram(vertex_render_shader_path, fragment_render_shader_path, renderShaderProgram))
 		std::cout << "Failed to create render shader." << std::endl;
 
-	////////////////////////////////////////////
-	//Structure texture with FDTD audio layout//
-	////////////////////////////////////////////
-
-	//Calculate texture size to fit FDTD structure//
-	int textureWidth = domainSize[0] * NUM_OF_TIMESTEPS;	//The texture needs to contain the two timestep quads.
-	int textureHeight = domainSize[1] + ceiling;			//The texture needs to contain the quad and then the isolation and audio row.
-
-	//Calculate delta texture coordinates - The width & height of each fragment//
-	float deltaX = 1.0 / (float)textureWidth;
-	float deltaY = 1.0 / (float)textureHeight;
-
-	//Calculate delta to compute vertex y position leaving space for isolation + audio row.
-	float deltaV = 2.0 / (float)textureHeight;				//Unsure about this?
-
-	//Specify information for texture//
-	int numOfAttributesPerVertex = 12;						//The number of pieces of information each vertex contains.
-	int numOfVerticesPerQuad = 4;							//Number of vertices that make up each texture quad.
+	///////////////////////////////////////////////////////////////////
+	//Render quad - Covers whole window with a domain sized snapshot//
+	///////////////////////////////////////////////////////////////////
 	float attributes[] = {
-		// quad0 [left quadrant]
-		// 4 vertices
-		// pos N+1/-1				tex C coord N				tex L coord N							tex U coord N							tex R coord N							tex D coord N
-		-1, -1,						0.5, 0,					0.5f - deltaX, 0,						0.5f, 0 + deltaY,						0.5f + deltaX, 0,						0.5f, 0 - deltaY,						// bottom left
-		-1, 1 - ceiling * deltaV,	0.5f, 1 - ceiling * deltaY,	0.5f - deltaX, 1 - ceiling * deltaY,	0.5f, 1 + deltaY - ceiling * deltaY,	0.5f + deltaX, 1 - ceiling * deltaY,	0.5f, 1 - deltaY - ceiling * deltaY,	// top left [leaving space for clng]
-		0, -1,						1.0f, 0,					1 - deltaX,    0,						1,    0 + deltaY,						1 + deltaX,    0,						1, 	  0 - deltaY,						// bottom right
-		0, 1 - ceiling * deltaV,	1.0f, 1 - ceiling * deltaY,	1 - deltaX,    1 - ceiling * deltaY,	1,    1 + deltaY - ceiling * deltaY,	1 + deltaX,    1 - ceiling * deltaY,	1, 	  1 - deltaY - ceiling * deltaY,	// top right [leaving space for clng]
-
-		// quad1 [right quadrant]
-		// 4 vertices
-		// pos N+1/-1				tex C coord N				tex L coord N							tex U coord N							tex R coord N							tex D coord N
-		0, -1,						0, 0,						0 - deltaX,	0,							0, 0 + deltaY,							0 + deltaX,	0,							0, 0 - deltaY,							// bottom left
-		0, 1 - ceiling * deltaV,	0,    1 - ceiling * deltaY,	0 - deltaX, 1 - ceiling * deltaY,		0,    1 + deltaY - ceiling * deltaY,	0 + deltaX,    1 - ceiling * deltaY,	0,    1 - deltaY - ceiling * deltaY,	// top left [leaving space for clng]
-		1, -1,						0.5f, 0,					0.5f - deltaX, 0,						0.5f, 0 + deltaY,						0.5f + deltaX, 0,						0.5f, 0 - deltaY,						// bottom right
-		1, 1 - ceiling * deltaV,	0.5f, 1 - ceiling * deltaY,	0.5f - deltaX, 1 - ceiling * deltaY,	0.5f, 1 + deltaY - ceiling * deltaY,	0.5f + deltaX, 1 - ceiling * deltaY,	0.5f, 1 - deltaY - ceiling * deltaY,	// top right [leaving space for clng]
-
-		// quad2 [ audio quadrant]
-		// 4 vertices
-		// pos [no concept of time step]		tex C coords are the only ones required...
-		-1, 1 - deltaV,			0,    1 - deltaY,	0,    0,			0,    0,			0,    0,			0,    0,	// bottom left [1 pixel below top]
-		-1, 1,	    			0,    1,			0,    0,			0,    0,			0,    0,			0,    0,	// top left
-		1, 1 - deltaV,			1,    1 - deltaY,	0,    0,			0,    0,			0,    0,			0,    0,	// bottom right [1 pixel below top]
-		1, 1,					1,    1,			0,    0,			0,    0,			0,    0,			0,    0,	// top right
+		// pos		tex C coord
+		-1, -1,		0, 0,	// bottom left
+		-1,  1,		0, 1,	// top left
+		 1, -1,		1, 0,	// bottom right
+		 1,  1,		1, 1,	// top right
 	};
 
-	/////////////////
-	//Quad Vertices//
-	/////////////////
-	int vertices[NUM_OF_TIMESTEPS + 1][2];		//Vertices + attributes stored here - For timestep and audio quads.
-
-	//quad0 is composed of vertices 0 to 3.
-	vertices[0][0] = 0;						//Index of first vertex.
-	vertices[0][1] = numOfVerticesPerQuad;	//Number of vertices.
-
-	//quad1 is composed of vertices 4 to 7.
-	vertices[1][0] = 4;
-	vertices[1][1] = numOfVerticesPerQuad;
-
-	//quad2 is composed of vertices 8 to 11.
-	vertices[2][0] = 8;
-	vertices[2][1] = numOfVerticesPerQuad;
-
-	////////////////////////////
-	//Create VBO + VAO objects//
-	////////////////////////////
-
-	//VBO is GPU memory containing vertices data//
 	unsigned int vbo;
 	glGenBuffers(1, &vbo);
-
-
-	//VAO interprets how VBO content is read//
 	unsigned int vao;
 	glGenVertexArrays(1, &vao);
 	glBindVertexArray(vao);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(attributes), attributes, GL_STATIC_DRAW);
 
-	/////////////////////////////////////////////
-	//Describe attributes shaders access in VBO//
-	/////////////////////////////////////////////
-
-	int numOfElementsPerAttribute = 4;	//Each attribute has 2 sets of coodinates. Therefore 4(vec4) elements form vertices data structure.
-
-	GLint pos_and_texc_loc = glGetAttribLocation(fboShaderProgram, "pos_and_texc");
+	GLint pos_and_texc_loc = glGetAttribLocation(renderShaderProgram, "pos_and_texc");
 	glEnableVertexAttribArray(pos_and_texc_loc);
-	glVertexAttribPointer(pos_and_texc_loc, numOfElementsPerAttribute, GL_FLOAT, GL_FALSE, numOfAttributesPerVertex * sizeof(GLfloat), (void*)(0 * numOfElementsPerAttribute * sizeof(GLfloat)));
-
-	GLint texl_and_texu_loc = glGetAttribLocation(fboShaderProgram, "texl_and_texu");
-	glEnableVertexAttribArray(texl_and_texu_loc);
-	glVertexAttribPointer(texl_and_texu_loc, numOfElementsPerAttribute, GL_FLOAT, GL_FALSE, numOfAttributesPerVertex * sizeof(GLfloat), (void*)(1 * numOfElementsPerAttribute * sizeof(GLfloat)));
-
-	GLint texr_and_texd_loc = glGetAttribLocation(fboShaderProgram, "texr_and_texd");
-	glEnableVertexAttribArray(texr_and_texd_loc);
-	glVertexAttribPointer(texr_and_texd_loc, numOfElementsPerAttribute, GL_FLOAT, GL_FALSE, numOfAttributesPerVertex * sizeof(GLfloat), (void*)(2 * numOfElementsPerAttribute * sizeof(GLfloat)));
-
-	//Safe to set the location for the render shader too - Though it should be same location as already specified//
-	pos_and_texc_loc = glGetAttribLocation(renderShaderProgram, "pos_and_texc");
-	glEnableVertexAttribArray(pos_and_texc_loc);
-	glVertexAttribPointer(pos_and_texc_loc, numOfElementsPerAttribute, GL_FLOAT, GL_FALSE, numOfAttributesPerVertex * sizeof(GLfloat), (void*)(0 * numOfElementsPerAttribute * sizeof(GLfloat)));
-
-	/////////////////////
-	//Initalize Texture//
-	/////////////////////
+	glVertexAttribPointer(pos_and_texc_loc, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*)0);
 
-	//Initalize flattened multidimensional float array that will contain all fragments//
-	uint8_t numChannels = 4;																//4 channels per pixel - RGBA.
-	float* texturePixels = new float[textureWidth*textureHeight*numChannels];				//Allocate enough memory to represent texture.
-	memset(texturePixels, 0, sizeof(float) * textureWidth * textureHeight * numChannels);
+	//Snapshot texture - Re-uploaded whenever the simulation publishes a new field//
+	std::vector<float> emptyField(domainSize[0] * domainSize[1] * 4, 0.0f);
+	fieldSnapshots.fill(emptyField);
 
-	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-	//Define the domain - The area of the texture which includes information. Normal points, boundaries, excitation points//
-	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	unsigned int texture;
+	glGenTextures(1, &texture);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, domainSize[0], domainSize[1], 0, GL_RGBA, GL_FLOAT, &emptyField[0]);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-	float** pointType[3];	//Why need three types? Normal point, excitation point, and???
+	//////////////////////////////////
+	//Update render shader uniforms//
+	/////////////////////////////////
 
-	//Allocate memory for x axis//
-	pointType[0] = new float*[domainSize[0]];
-	pointType[1] = new float*[domainSize[0]];
-	for (int i = 0; i != domainSize[0]; ++i)
-	{
-		//Allocate memory for y axis//
-		pointType[0][i] = new float[domainSize[1]];
-		pointType[1][i] = new float[domainSize[1]];
+	glUseProgram(renderShaderProgram);
 
-		//Initalize point types//
-		for (int j = 0; j != domainSize[1]; ++j)
-		{
-			pointType[0][i][j] = 1;			//Regular point - Transmission value 1.
-			pointType[1][i][j] = 0;			//No excitation.
+	GLint deltaCoordLocationRender = glGetUniformLocation(renderShaderProgram, "deltaCoord");
+	glUniform2f(deltaCoordLocationRender, 1.0f / domainSize[0], 1.0f / domainSize[1]);
 
-			//Place excitation point specified//
-			if ((i == excitationPosition[0]) && (j == excitationPosition[1]))	//Could support multiple by being excitation grid with 1 in positions.
-				pointType[1][i][j] = 1;		//Excitation
-		}
-	}
+	//Listener fragment coordinates as uniforms - Snapshot holds a single quad//
+	GLint listenerFragCoordLocationRender = glGetUniformLocation(renderShaderProgram, "listenerFragCoord");
+	glUniform2f(listenerFragCoordLocationRender, (listenerPosition[0] + 0.5f) / domainSize[0], (listenerPosition[1] + 0.5f) / domainSize[1]);
 
-	//Add columns of boundary points on left and right//
-	//I think tutorial uses domainSize axis wrong way around. And only works as they are both equal in this program setup being {80, 80}//
-	//Also why is there -1 size from certain sides?
-	for (int i = 0; i != domainSize[0]; ++i)
-	{
-		pointType[0][i][0] = 0;		//Transmission value 0.
-		pointType[0][i][domainSize[1] - 1] = 0;
-	}
+	//Set inputTexture as same texture at index 0, just for reading from//
+	glUniform1i(glGetUniformLocation(renderShaderProgram, "inputTexture"), 0);
 
-	for (int i = 0; i != domainSize[1] - 1; ++i)
-	{
-		pointType[0][0][i] = 0;
-		pointType[0][domainSize[0] - 1][i] = 0;
-	}
+	/////////////////
+	//Start Threads//
+	/////////////////
 
-	//////////////////////////////////////////////////////////////////////////
-	//Apply domain in texture - Copy domain point types into  channels R, A //
-	//////////////////////////////////////////////////////////////////////////
-	for (int i = 0; i != textureWidth; ++i)
-	{
-		for (int j = 0; j != textureHeight - ceiling; ++j)
-		{
-			//Quad0//
-			if (i < domainSize[0])
-			{
-				texturePixels[(j*textureWidth + i) * 4 + 2] = pointType[0][i][j];
-				texturePixels[(j*textureWidth + i) * 4 + 3] = pointType[1][i][j];
-			}
-			//Quad1//
-			if (i >= domainSize[0])
-			{
-				texturePixels[(j*textureWidth + i) * 4 + 2] = pointType[0][i - domainSize[0]][j];
-				texturePixels[(j*textureWidth + i) * 4 + 3] = pointType[1][i - domainSize[0]][j];
-			}
-		}
-	}
+	profiler.setBudget(buffer_size, sampleRate);
+	GPUTimer renderTimer(STAGE_RENDER);
+	ProfileClock::time_point lastDumpTime = ProfileClock::now();
 
-	//Clean up//
-	for (int i = 0; i < domainSize[0]; i++) {
-		delete[] pointType[0][i];
-		delete[] pointType[1][i];
-	}
-	delete[] pointType[0];
-	delete[] pointType[1];
+	AudioStream audioStream(realTimeAudioBuffer, sampleRate);
+	audioStream.play();
 
-	///////////////////////////////////////////
-	//Create texture using texture pixel data//
-	///////////////////////////////////////////
+	std::thread simulationThread(simulate, simulationContext, settings);
+	bool wasSaveKeyDown = false;
+	TRACE_THREAD_NAME("Visualisation");
 
-	unsigned int texture;
-	glGenTextures(1, &texture);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, textureWidth, textureHeight, 0, GL_RGBA, GL_FLOAT, texturePixels);	//Load texture pixels that define inital model state.
-	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-	//Create Framebuffer object - Memory we write the texture to on memory. This is done instead of using the default rendering framebuffer provided for window//
-	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-	unsigned int fbo;
-	glGenFramebuffers(1, &fbo);
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
-
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE)
-		std::cout << "Framebuffer object successfully created!" << std::endl;
-	else
-		std::cout << "Error creating framebuffer." << std::endl;
-
-	///////////////////////////////////////////////////////////////////////////////
-	//Create Pixel buffer object - Apparently to read from texture, Audio buffer?//
-	///////////////////////////////////////////////////////////////////////////////
-
-	//The pbo is bound here, therefore later when glReadPixels used it reas from this pbo implicitly//
-	unsigned int pbo;
-	glGenBuffers(1, &pbo);
-	glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
-	glBufferData(GL_PIXEL_PACK_BUFFER, sizeof(float)*buffer_size * 4, NULL, GL_STREAM_READ);
-
-	/////////////////////////////////////////////////////////////////////////////
-	//Calculate useful(?) values - These will be used as uniforms in the shader//
-	/////////////////////////////////////////////////////////////////////////////
-
-	//Re-assign here for clarity//
-	float deltaCoordX = deltaX;
-	float deltaCoordY = deltaY;
-
-	//Compute texture coordinates of the listener point which shader can recognize//
-	float listenerFragCoord[2][2];
-
-	//Quad0 reads audio from Quad1//
-	listenerFragCoord[0][0] = (float)(listenerPosition[0] + 0.5 + domainSize[0]) / (float)textureWidth;
-	listenerFragCoord[0][1] = (float)(listenerPosition[1] + 0.5) / (float)textureHeight;
-
-	//Quad1 reads audio from Quad0//
-	listenerFragCoord[1][0] = (float)(listenerPosition[0] + 0.5) / (float)textureWidth;
-	listenerFragCoord[1][1] = (float)(listenerPosition[1] + 0.5) / (float)textureHeight;
-	//Apparently +0.5 needed to match fragment we want to sample. Would like to know why//
-
-	//////////////////////////////
-	//Setup FBO Shader Uniforms//
-	/////////////////////////////
-
-	//Update the FBO shader uniforms//
-	glUseProgram(fboShaderProgram);
-
-	///////////////////
-	//Static Uniforms//
-	///////////////////
-
-	GLuint propagationFactorLocation = glGetUniformLocation(fboShaderProgram, "propFactor");
-	glUniform1f(propagationFactorLocation, propagationFactor);
-	GLuint dampingFactorLocation = glGetUniformLocation(fboShaderProgram, "dampFactor");
-	glUniform1f(dampingFactorLocation, dampingFactor);
-	GLuint boundaryClampedLocation = glGetUniformLocation(fboShaderProgram, "boundaryGain");
-	glUniform1f(boundaryClampedLocation, boundaryGain);
-
-	//Width of each fragment - Used for working out excitation fragment + audio fragment//
-	GLuint deltaCoordLocation = glGetUniformLocation(fboShaderProgram, "deltaCoord");
-	glUniform2f(deltaCoordLocation, deltaCoordX, deltaCoordY);
-
-	//Listener fragment coordinates as uniforms - For both quads//
-	GLuint listenerFragCoordLocation[2];
-	char name[22];
-	for (int i = 0; i != NUM_OF_TIMESTEPS; ++i)
+	///////////////////////////////////////////////////
+	//Visualisation Cycle - Runs at display rate until//
+	//simulation finishes or user exits              //
+	///////////////////////////////////////////////////
+	while (isRunning)
 	{
-		//Form name of shader uniforms, to get their locations, to update values.//
-		sprintf(name, "listenerFragCoord[%d]", i);
-		listenerFragCoordLocation[i] = glGetUniformLocation(fboShaderProgram, name);
-		glUniform2f(listenerFragCoordLocation[i], listenerFragCoord[i][0], listenerFragCoord[i][1]);
-	}
+		glfwPollEvents();
 
-	////////////////////
-	//Dynamic Uniforms//
-	////////////////////
+		//Poll escape key state - If presses, exit program//
+		if (GLFW_PRESS == glfwGetKey(window, GLFW_KEY_ESCAPE) || glfwWindowShouldClose(window))
+			isRunning = false;
 
-	//Dynamic Uniform Variables//
-	float excitationMagnitude = 0;							//Starts with no excitation.
-	int currentQuad = QUAD0;								//Quad focused on for current time step - We start to draw from quad 0, left quad.
-	float wrCoord[2] = { 0, 0 };							//Coordinates of current audio buffer recording point - Contains x coordinate of fragment and index of next available RGBA channel.
+		//S key saves a checkpoint - Simulation thread owns the model, so only request it//
+		bool isSaveKeyDown = GLFW_PRESS == glfwGetKey(window, GLFW_KEY_S);
+		if (isSaveKeyDown && !wasSaveKeyDown && !checkpointPath.empty())
+			isCheckpointRequested = true;
+		wasSaveKeyDown = isSaveKeyDown;
 
-	//The current state of FDTD processing in the shader//
-	stateLocation = glGetUniformLocation(fboShaderProgram, "state");
+		StageTimer renderStageTimer;
+		TRACE_SPAN_BEGIN(renderSpan, "render");
+		renderTimer.collect();
+		renderTimer.begin();
 
-	//Value of excitation point - Active or not. This could be done differently? Just need an identified excitation point.//
-	excitationMagnitudeLocation = glGetUniformLocation(fboShaderProgram, "excitationMagnitude");
-	glUniform1f(excitationMagnitudeLocation, excitationMagnitude);
-	excitationPositionLocation = glGetUniformLocation(fboShaderProgram, "excitationPosition");
-	glUniform2f(excitationPositionLocation, excitationPosition[0], excitationPosition[1]);
+		//Upload latest field if simulation published one since last frame//
+		if (fieldSnapshots.acquire())
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, domainSize[0], domainSize[1], GL_RGBA, GL_FLOAT, &fieldSnapshots.getFront()[0]);
 
-	//Fragment coordinate of the audioWrite pixel - Increments over X axis with audio samples?//
-	wrCoordLocation = glGetUniformLocation(fboShaderProgram, "wrCoord");
+		int framebufferWidth, framebufferHeight;
+		glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+		glViewport(0, 0, framebufferWidth, framebufferHeight);
 
-	//Set inOutTexture uniform to the texture number zero created previously//
-	glUniform1i(glGetUniformLocation(fboShaderProgram, "inOutTexture"), 0);
+		//Render to screen//
+		glUseProgram(renderShaderProgram);
+		glBindVertexArray(vao);
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		renderTimer.end();
+		TRACE_SPAN_END(renderSpan);
+		profiler.recordCPU(STAGE_RENDER, renderStageTimer.elapsed());	//Excludes swap, which only waits for vsync.
+		glfwSwapBuffers(window);
 
-	//////////////////////////////////
-	//Update render shader uniforms//
-	/////////////////////////////////
+		//Periodic dump of pipeline timings//
+		if (ProfileClock::now() - lastDumpTime > std::chrono::seconds(PROFILE_DUMP_INTERVAL))
+		{
+			profiler.dump(std::cout);
+			lastDumpTime = ProfileClock::now();
+		}
+	}
 
-	glUseProgram(renderShaderProgram);
+	simulationThread.join();
+	audioStream.stop();
+	std::cout << "Audio underruns: " << audioStream.getUnderrunCount() << std::endl;
+	profiler.dump(std::cout);
+#ifdef FDTD_TRACING
+	tracer.stop();
+#endif
 
-	///////////////////
-	//Static Uniforms//
-	///////////////////
+	//Playback audio - Plays the whole program accumulated audio//
+	if (!playbackAudioBuffer.empty())
+	{
+		engineSoundBuffer.loadFromSamples(&playbackAudioBuffer[0], playbackAudioBuffer.size(), 1, sampleRate);
+		soundEngine.setBuffer(engineSoundBuffer);
+		soundEngine.play();
+	}
 
-	GLuint deltaCoordLocationRender = glGetUniformLocation(renderShaderProgram, "deltaCoord");
-	glUniform2f(deltaCoordLocationRender, deltaCoordX, deltaCoordY);
+	//////////////////
+	//End of program//
+	//////////////////
+	std::cout << "End of program." << std::endl;
+	char c;
+	std::cin >> c;
 
-	//Listener fragment coordinates as uniforms - Only need one quad for rendering//
-	GLuint listenerFragCoordLocationRender = glGetUniformLocation(renderShaderProgram, "listenerFragCoord");
-	glUniform2f(listenerFragCoordLocationRender, listenerFragCoord[0][0], listenerFragCoord[0][1]);
+	glfwTerminate();
+	return 0;
+}
 
-	//Set inputTexture as same texture at index 0, just for reading from//
-	glUniform1i(glGetUniformLocation(renderShaderProgram, "inputTexture"), 0);
+void simulate(GLFWwindow* simulationContext, SolverSettings settings)
+{
+	glfwMakeContextCurrent(simulationContext);
+	TRACE_THREAD_NAME("Simulation");
 
-	glUseProgram(0);	//Finished with this shader program for now.
+	Solver* solver = createSolver(solverBackend, settings);
+	if (solver == NULL)
+	{
+		std::cout << "Failed to create " << getBackendName(solverBackend) << " solver." << std::endl;
+		isRunning = false;
+		return;
+	}
 
+	//Volumes and string banks keep whole cell probes on every backend - Refused like the backends main() turned away//
+	bool isMovingProbes = isSlidingStrike || listenerOrbit > 0.0f;
+	if (isMovingProbes && !solver->isProbePathFollowed())
+	{
+		std::cout << "--slide and --listener-orbit need a membrane or plate - Volumes and string banks keep the probes on whole cells." << std::endl;
+		delete solver;
+		isRunning = false;
+		return;
+	}
+	float strikePoint[2] = { (float)(int)(settings.excitationPosition[0] * settings.domainSize[0]), (float)(int)(settings.excitationPosition[1] * settings.domainSize[1]) };
+	float strikeTarget[2] = { strikePoint[0], strikePoint[1] };
+	std::vector<float> excitationPath(buffer_size * 2);
+	std::vector<float> listenerPath(buffer_size * 2);
 
-	////////////////////
-	//Simulation Cycle//
-	////////////////////
+	//Simulation thread's copies of what the callbacks hand over - Checkpoints save these//
+	float excitationPoint[2] = { settings.excitationPosition[0], settings.excitationPosition[1] };
+	std::array<float, 3> material = { { settings.propagationFactor, settings.dampingFactor, settings.boundaryGain } };
 
 	//Total number samples collected over set duration//
 	int totalSampleNum = sampleRate * duration;
@@ -490,217 +584,234 @@ int main(int argc, char* argv[])
 	//Compute number of filled audio buffers needed for specified duration//
 	int bufferNum = totalSampleNum / buffer_size;
 
-	//Initalize variables//
-	state = -1;
-	int sampleCnt = 0;	//Think it is sample counter, used to show when next excitation should occour.
+	//Warm start - Field uploaded straight from the mapped file, then resume the excitors and sample count where they were saved//
+	uint64_t sampleCount = 0;
+	int firstBuffer = 0;
+	if (restoredCheckpoint.isOpen())
+	{
+		const CheckpointHeader& header = restoredCheckpoint.getHeader();
+		solver->setField(restoredCheckpoint.getField());
+		squareWaveExcitor.setIndex(header.excitorIndex[0]);
+		sineWaveExcitor.setIndex(header.excitorIndex[1]);
+		sampleCount = header.sampleCount;
+		firstBuffer = (int)(sampleCount / buffer_size);
+		if (firstBuffer > bufferNum)
+			firstBuffer = bufferNum;
+		restoredCheckpoint.close();
+	}
+
+	std::vector<float> excitation(buffer_size);
+	std::vector<float> output(buffer_size);
+	std::vector<sf::Int16> block(buffer_size);
+	playbackAudioBuffer.reserve(bufferNum * buffer_size);
+
+	int snapshotInterval = sampleRate / DISPLAY_RATE;	//Samples between field snapshots.
+	int samplesSinceSnapshot = snapshotInterval;
 
 	//Cycle filling audio buffer until desired durations worth collected//
-	for (int i = 0; i != bufferNum; ++i)
+	for (int i = firstBuffer; i != bufferNum && isRunning; ++i)
 	{
-		//Record time before rendering.
-		clock_t beginRealTimeClock = clock();
-
-		//Switch to FBO shader for Quad texture//
-		glUseProgram(fboShaderProgram);
-		glBindFramebuffer(GL_FRAMEBUFFER, fbo);			//Render to our framebuffer!
-		glViewport(0, 0, textureWidth, textureHeight);	//Full viewport - Give access to all texture
+		//Apply excitation point moved by visualisation thread//
+		if (excitationClicks.acquire())
+		{
+			excitationPoint[0] = excitationClicks.getFront()[0];
+			excitationPoint[1] = excitationClicks.getFront()[1];
+			strikeTarget[0] = excitationPoint[0] * settings.domainSize[0] - 0.5f;
+			strikeTarget[1] = excitationPoint[1] * settings.domainSize[1] - 0.5f;
+			if (!isMovingProbes || !isSlidingStrike)
+				solver->setExcitationPosition(excitationPoint[0], excitationPoint[1]);
+			squareWaveExcitor.resetExcitation();
+			sineWaveExcitor.resetExcitation();
+		}
 
-		//Cycle simulation - Advance until single audio buffer filled//
-		for (int n = 0; n != buffer_size; ++n)
+		//Sliding strike travels towards the clicked point at a steady rate, orbiting listener turns - Both step between cells every sample//
+		if (isMovingProbes)
 		{
-			//////////////////////
-			//Advance Simulation//
-			//////////////////////
-
-			//Pass next excitation Value//
-			glUniform1f(excitationMagnitudeLocation, excitationMagnitude);
-			glUniform2f(excitationPositionLocation, excitationPosition[0], excitationPosition[1]);
-
-			//Simulation step - Advance state to focus on next quad, then execute shader on it//
-			state = currentQuad * 2;
-			glUniform1i(stateLocation, state);
-			glDrawArrays(GL_TRIANGLE_STRIP, vertices[currentQuad][0], vertices[currentQuad][1]);	//Draw quad0 or quad1.
-
-			//Audio step - Read audio sample from previous quad, defined by current state//
-			glUniform2fv(wrCoordLocation, 1, wrCoord);									//Fragment and channel.
-			glUniform1i(stateLocation, state + 1);										//Use next state, which will be to read audio from correct quad in shader.
-			glDrawArrays(GL_TRIANGLE_STRIP, vertices[QUAD2][0], vertices[QUAD2][1]);	//Draw quad2, the audio quad. Appending audio from quad0 or quad1.
-
-			//Prepare next simulation cycle//
-			currentQuad = 1 - currentQuad;
-			wrCoord[1] = int(wrCoord[1] + 1) % 4;	//Increment audio channel by 1?
-			if (wrCoord[1] == 0)
-				wrCoord[0] += deltaCoordX;
-
-			//Next excitation//
-			/*if (++sampleCnt == excitationDuration)
+			float slideStep = STRIKE_SLIDE_RATE / (float)sampleRate;
+			for (int n = 0; n != buffer_size; ++n)
 			{
-				excitationMagnitude = maxExcitation;
-				sampleCnt = 0;
-				if(isSingleExcitation)
-					maxExcitation = 0;
+				float dx = strikeTarget[0] - strikePoint[0];
+				float dy = strikeTarget[1] - strikePoint[1];
+				float distance = std::sqrt(dx * dx + dy * dy);
+				float move = distance > slideStep ? slideStep / distance : 1.0f;
+				strikePoint[0] += dx * move;
+				strikePoint[1] += dy * move;
+				excitationPath[n * 2 + 0] = strikePoint[0];
+				excitationPath[n * 2 + 1] = strikePoint[1];
+
+				float angle = 6.2831853f * (float)(i * buffer_size + n) / (LISTENER_ORBIT_PERIOD * sampleRate);
+				listenerPath[n * 2 + 0] = settings.listenerPosition[0] + listenerOrbit * std::cos(angle);
+				listenerPath[n * 2 + 1] = settings.listenerPosition[1] + listenerOrbit * std::sin(angle);
 			}
-			else
-				excitationMagnitude = 0;*/
+			solver->setProbePaths(isSlidingStrike ? &excitationPath[0] : NULL, listenerOrbit > 0.0f ? &listenerPath[0] : NULL);
+		}
 
-			//New excitation method//
+		//Apply material changed by visualisation thread - The solver glides to it over the next blocks//
+		if (materialChanges.acquire())
+		{
+			material = materialChanges.getFront();
+			solver->setMaterial(material[0], material[1], material[2]);
+		}
+
+		//Excitation for each step of this block//
+		for (int n = 0; n != buffer_size; ++n)
+		{
 			if (squareWaveExcitor.isExcitation())
-			{
-				excitationMagnitude = squareWaveExcitor.getNextSample();
-			}
+				excitation[n] = squareWaveExcitor.getNextSample();
 			else
-				excitationMagnitude = 0;
-
-			//Re-sync all parallel GPU threads - Also done implictly when buffers swapped//
-			//Basically glDrawArray calls make asynchronous GPU computations - Calling this makes CPU wait for all GPU threads to complete before continue//
-			//gl texture barrier//
-			glFlush();
-			//glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+				excitation[n] = 0;
 		}
 
-		//Reset audio buffer write coordinates to beginning of buffer and first channel//
-		wrCoord[0] = 0;
-		wrCoord[1] = 0;
+		//Advance simulation until single audio buffer filled//
+		StageTimer bufferTimer;
+		TRACE_SPAN_BEGIN(bufferSpan, "buffer");
+		solver->process(&excitation[0], &output[0], buffer_size);
 
-		//Retrieve audio samples from texture - Uses pbo as last buffer bind//
-		glReadPixels(0, textureHeight - 1, buffer_size / 4, 1, GL_RGBA, GL_FLOAT, 0);	//Quad2 is single audio row on top of texture with 4 samples in each row.
-		float* sampleBuffer = (float*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
-		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);	//Apparently to have physical copy of samples on CPU.
-
-		//Append audio texture samples to audioBuffer//
-		for (int i = 0; i != buffer_size; ++i)
+		//Append audio samples to audio buffers//
+		StageTimer conversionTimer;
+		TRACE_SPAN_BEGIN(conversionSpan, "conversion");
+		for (int n = 0; n != buffer_size; ++n)
 		{
-			//Should go from full singed range or unsigned?//
-			//sf::Int16 sample = sampleBuffer[i];
-			//sf::Int16 sample = sampleBuffer[i] * 32767;
-			//sf::Int16 sample = (((sampleBuffer[i] - 0.0)*(32767 + 32768)) / (1.0 - 0.0)) - 32768;
-			sf::Int16 sample = (((sampleBuffer[i] + 15.0)*(32767 + 32768)) / (15.0 + 15.0)) - 32768;
-			playbackAudioBuffer.push_back(sample);
-			realTimeAudioBuffer[sampleCounter++] = sample;
+			block[n] = toInt16Sample(output[n]);
+			playbackAudioBuffer.push_back(block[n]);
 		}
-
-		//Implement timing to playback realtime audio?//
-		clock_t endRealTimeClock = clock();
-		clock_t differenceRealTimeClock = endRealTimeClock - beginRealTimeClock;
-		if (differenceRealTimeClock < MICROSECS_IN_SEC)
-			//Sleep(MICROSECS_IN_SEC - renderFrame);
-
-		//Real Time audio - Plays second of samples when accumulated//
-		if (sampleCounter > sampleRate)
+		TRACE_SPAN_END(conversionSpan);
+		TRACE_SPAN_END(bufferSpan);
+		profiler.recordCPU(STAGE_CONVERSION, conversionTimer.elapsed());
+		uint64_t bufferTime = bufferTimer.elapsed();
+
+		//Hand block to audio thread - Waits while ring is full, which paces simulation to real-time//
+		//Only time spent pushing counts towards the sink stage and deadline, not the pacing sleeps//
+		uint64_t sinkTime = 0;
+		int pushed = 0;
+		while (isRunning)
 		{
-			engineSoundBuffer.loadFromSamples(&realTimeAudioBuffer[0], sampleCounter, 1, 44100);
-			soundEngine.setBuffer(engineSoundBuffer);
-			soundEngine.play();
-			sampleCounter = 0;
+			StageTimer sinkTimer;
+			TRACE_SPAN_BEGIN(sinkSpan, "sink");
+			pushed += realTimeAudioBuffer.push(&block[pushed], buffer_size - pushed);
+			TRACE_SPAN_END(sinkSpan);
+			sinkTime += sinkTimer.elapsed();
+			if (pushed == buffer_size)
+				break;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
 		}
+		profiler.recordCPU(STAGE_SINK, sinkTime);
+		profiler.recordBuffer(bufferTime + sinkTime);
 
-		//Switch to render shader - Only happens once every full audio buffer filled//
-		glUseProgram(renderShaderProgram);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);	//Disable FBO to render to screen.
-		glBindVertexArray(vao);
-		glViewport(0, 0, textureWidth*MAGNIFIER, textureHeight*MAGNIFIER);
+		sampleCount += buffer_size;
 
-		//Render to screen//
-		glDrawArrays(GL_TRIANGLE_STRIP, vertices[QUAD0][0], vertices[QUAD0][1]);	//Just pass quad0 from  texture to render.
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+		if (isCheckpointRequested.exchange(false))
+			writeCheckpoint(solver, settings, excitationPoint, &material[0], sampleCount);
 
-		//Poll escape key state - If presses, exit program//
-		if (GLFW_PRESS == glfwGetKey(window, GLFW_KEY_ESCAPE))
-			break;
+		//Publish field for visualisation thread - Only at display rate, never waits on the reader//
+		samplesSinceSnapshot += buffer_size;
+		if (samplesSinceSnapshot >= snapshotInterval)
+		{
+			solver->getField(&fieldSnapshots.getBack()[0]);
+			fieldSnapshots.publish();
+			samplesSinceSnapshot = 0;
+		}
 	}
 
-	//Playback audio - Plays the whole program accumulated audio//
-	engineSoundBuffer.loadFromSamples(&playbackAudioBuffer[0], bufferNum*buffer_size, 1, 44100);
-	soundEngine.setBuffer(engineSoundBuffer);
-	soundEngine.play();
+	if (!checkpointPath.empty())
+		writeCheckpoint(solver, settings, excitationPoint, &material[0], sampleCount);
 
-	//////////////////
-	//End of program//
-	//////////////////
-	std::cout << "End of program." << std::endl;
-	char c;
-	std::cin >> c;
+	delete solver;
+	isRunning = false;
+	glfwMakeContextCurrent(NULL);
+}
 
-	return 0;
+void writeCheckpoint(Solver* solver, const SolverSettings& settings, const float* excitationPoint, const float* material, uint64_t sampleCount)
+{
+	TRACE_SCOPE("checkpoint");
+
+	//Material as last changed at runtime, which the solver is gliding to - settings holds the values it started with//
+	CheckpointHeader header = makeCheckpointHeader(settings);
+	header.propagationFactor = material[0];
+	header.dampingFactor = material[1];
+	header.boundaryGain = material[2];
+	header.excitationPosition[0] = excitationPoint[0];
+	header.excitationPosition[1] = excitationPoint[1];
+	header.excitorIndex[0] = squareWaveExcitor.getIndex();
+	header.excitorIndex[1] = sineWaveExcitor.getIndex();
+	header.sampleCount = sampleCount;
+
+	std::vector<float> field(settings.domainSize[0] * settings.domainSize[1] * 4);
+	solver->getField(&field[0]);
+	if (saveCheckpoint(checkpointPath.c_str(), header, &field[0]))
+		std::cout << "Saved checkpoint at sample " << sampleCount << " to " << checkpointPath << std::endl;
+	else
+		std::cout << "Failed to save checkpoint " << checkpointPath << std::endl;
 }
 
-bool loadShaderProgram(const char* vertexShaderPath, const char* fragmentShaderPath, GLuint& shaderProgram)
+sf::Int16 toInt16Sample(float sample)
 {
-	//Load files source code//
-	std::string vertexSource;
-	std::string fragmentSource;
-	std::ifstream vShaderFile;
-	std::ifstream fShaderFile;
-
-	//Open files to ifstream//
-	vShaderFile.open(vertexShaderPath);
-	fShaderFile.open(fragmentShaderPath);
-
-	//Read file's buffer content into stream//
-	std::stringstream vShaderStream, fShaderStream;
-	vShaderStream << vShaderFile.rdbuf();
-	fShaderStream << fShaderFile.rdbuf();
-
-	//Close files//
-	vShaderFile.close();
-	fShaderFile.close();
-
-	//Convert stream to string//
-	vertexSource = vShaderStream.str();
-	fragmentSource = fShaderStream.str();
-
-	//Set source code in char* for opengl c use//
-	const char* vShaderCode = vertexSource.c_str();
-	const char* fShaderCode = fragmentSource.c_str();
-
-	//Compile vertex shader from source//
-	GLuint vertexShader;
-	vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &vShaderCode, NULL);
-	glCompileShader(vertexShader);
-
-	//Compile fragment shader from source//
-	GLuint fragmentShader;
-	fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &fShaderCode, NULL);
-	glCompileShader(fragmentShader);
-
-	//Create and link shaders into shader program//
-	shaderProgram = glCreateProgram();
-	glAttachShader(shaderProgram, vertexShader);
-	glAttachShader(shaderProgram, fragmentShader);
-	glLinkProgram(shaderProgram);
-
-	//Clean up shaders//
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
-
-	//Return status of new shader//
-	int status;
-	glGetProgramiv(shaderProgram, GL_LINK_STATUS, &status);
-	if (status == GL_FALSE)
-		return false;
-	return true;
+	//Should go from full singed range or unsigned?//
+	//sf::Int16 sample = sampleBuffer[i];
+	//sf::Int16 sample = sampleBuffer[i] * 32767;
+	//sf::Int16 sample = (((sampleBuffer[i] - 0.0)*(32767 + 32768)) / (1.0 - 0.0)) - 32768;
+	double scaled = (((sample + 15.0)*(32767 + 32768)) / (15.0 + 15.0)) - 32768;
+	if (scaled > 32767)
+		scaled = 32767;
+	else if (scaled < -32768)
+		scaled = -32768;
+	return (sf::Int16)scaled;
 }
 
 void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
 {
-	//Because the coordinates from top left of screen taken, if the domain exceeds window size, then glfw returned coordinates will not calcualte correctly//
+	//Window shows the whole domain - Normalise cursor position to domain coordinates//
 	if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
 	{
 		double xPos, yPos;
+		int windowWidth, windowHeight;
 		glfwGetCursorPos(window, &xPos, &yPos);
-		xPos = xPos / (domainSize[0] * MAGNIFIER);
-		xPos = (((xPos - 0.0)*(1.0 - 0.5)) / (1.0 - 0.0)) + 0.5;
-		//NewValue = (((OldValue - OldMin) * (NewMax - NewMin)) / (OldMax - OldMin)) + NewMin
-		//xPos += 0.5;
-		yPos = yPos / (domainSize[1] * MAGNIFIER);
-		yPos = 1.0 - yPos;
-		excitationPosition[0] = xPos;
-		excitationPosition[1] = yPos;
-		//maxExcitation = 15.0;
-		squareWaveExcitor.resetExcitation();
-		sineWaveExcitor.resetExcitation();
+		glfwGetWindowSize(window, &windowWidth, &windowHeight);
+		xPos = xPos / windowWidth;
+		yPos = 1.0 - yPos / windowHeight;	//GLFW measures from top left of window.
+		excitationClicks.getBack()[0] = (float)xPos;
+		excitationClicks.getBack()[1] = (float)yPos;
+		excitationClicks.publish();	//Simulation thread resets the excitors when it next picks this up.
 	}
-}
\ No newline at end of file
+}
+
+void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	//Held keys repeat the step//
+	if (action == GLFW_RELEASE)
+		return;
+
+	float propagation = materialParameters[0];
+	float damping = materialParameters[1];
+	float boundaryGain = materialParameters[2];
+	switch (key)
+	{
+	case GLFW_KEY_UP:
+		propagation = propagation + PROPAGATION_STEP > maxPropagation ? maxPropagation : propagation + PROPAGATION_STEP;
+		break;
+	case GLFW_KEY_DOWN:
+		propagation = propagation - PROPAGATION_STEP < 0.0f ? 0.0f : propagation - PROPAGATION_STEP;
+		break;
+	case GLFW_KEY_RIGHT:
+		damping = damping * DAMPING_STEP < MIN_DAMPING ? MIN_DAMPING : damping * DAMPING_STEP;
+		break;
+	case GLFW_KEY_LEFT:
+		damping = damping / DAMPING_STEP < MIN_DAMPING ? 0.0f : damping / DAMPING_STEP;
+		break;
+	case GLFW_KEY_PAGE_UP:
+		boundaryGain = boundaryGain + GAIN_STEP > 1.0f ? 1.0f : boundaryGain + GAIN_STEP;
+		break;
+	case GLFW_KEY_PAGE_DOWN:
+		boundaryGain = boundaryGain - GAIN_STEP < 0.0f ? 0.0f : boundaryGain - GAIN_STEP;
+		break;
+	default:
+		return;
+	}
+
+	materialParameters[0] = propagation;
+	materialParameters[1] = damping;
+	materialParameters[2] = boundaryGain;
+	materialChanges.getBack() = { { propagation, damping, boundaryGain } };
+	materialChanges.publish();	//Simulation thread hands it to the solver when it next picks this up.
+	std::cout << "Material - Propagation " << propagation << ", damping " << damping << ", boundary gain " << boundaryGain << std::endl;
+}
@@ -0,0 +1,48 @@
+#include "materialRamp.h"
+
+#include <algorithm>
+
+MaterialRamp::MaterialRamp(const SolverSettings& settings) : oversampling(settings.oversampling)
+{
+	base[0] = settings.propagationFactor;
+	base[1] = settings.dampingFactor;
+	base[2] = settings.boundaryGain;
+	for (int k = 0; k != 3; ++k)
+		current[k] = target[k] = base[k];
+}
+
+void MaterialRamp::setTarget(float propagation, float damping, float boundaryGain)
+{
+	target[0] = propagation;
+	target[1] = damping;
+	target[2] = boundaryGain;
+	remainingSamples = MATERIAL_RAMP_SAMPLES;
+}
+
+int MaterialRamp::advance(int numSamples, bool& isChanged)
+{
+	isChanged = false;
+	if (remainingSamples == 0)
+		return numSamples;
+
+	//Linear glide - Each segment takes its share of the distance left//
+	int segment = std::min(std::min(numSamples, MATERIAL_RAMP_SEGMENT), remainingSamples);
+	float fraction = (float)segment / (float)remainingSamples;
+	for (int k = 0; k != 3; ++k)
+		current[k] += (target[k] - current[k]) * fraction;
+	remainingSamples -= segment;
+	if (remainingSamples == 0)
+		std::copy(target, target + 3, current);
+
+	isChanged = true;
+	return segment;
+}
+
+MaterialOffset MaterialRamp::getOffset() const
+{
+	MaterialOffset offset;
+	offset.propagation = (current[0] - base[0]) / (float)(oversampling * oversampling);
+	offset.damping = (current[1] - base[1]) / (float)oversampling;
+	offset.boundaryGain = current[2] - base[2];
+	return offset;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "solver.h"
+#include "domain.h"
+
+///////////
+//DEFINES//
+///////////
+
+#define MATERIAL_RAMP_SAMPLES	2048	//Steps a material change is glided over - About 46ms at 44.1kHz, long enough to avoid zipper noise.
+#define MATERIAL_RAMP_SEGMENT	64		//Steps run on one set of coefficients while gliding.
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//MaterialRamp - Glides a backend's uniform material from the values it was created with to//
+//those last set at runtime. process() splits a block into segments while gliding, moving  //
+//the material a little and refreshing the coefficients before each, and runs whole blocks //
+//once settled. Material maps keep their shape, offset by the change in the uniform values.//
+/////////////////////////////////////////////////////////////////////////////////////////////
+class MaterialRamp {
+private:
+	float base[3];				//[propagation, damping, boundaryGain] the domain was built with.
+	float current[3];
+	float target[3];
+	int remainingSamples = 0;	//Steps until current reaches target.
+	int oversampling;			//Steps per output sample - Material is given per sample and offsets scaled to the step rate, as the domain's planes are.
+
+public:
+	MaterialRamp(const SolverSettings& settings);
+
+	//Glide to new uniform values, starting from wherever the current glide has got to//
+	void setTarget(float propagation, float damping, float boundaryGain);
+
+	//Steps of a block of numSamples to run before the next call - Sets isChanged if the material moved, so coefficients need recomputing//
+	int advance(int numSamples, bool& isChanged);
+
+	//Current material as an offset over the domain's planes, scaled to the step rate//
+	MaterialOffset getOffset() const;
+};
@@ -0,0 +1,238 @@
+#include "oversampledSolver.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "domainBuilder.h"
+#include "volume.h"
+#include "stringBankSolver.h"
+#include "simdSolver.h"		//SIMD_SOLVER_AVAILABLE.
+#include "tracer.h"
+
+#ifdef SIMD_SOLVER_AVAILABLE
+#include <emmintrin.h>
+#endif
+
+float getCFLLimit(const SolverSettings& settings)
+{
+	if (settings.numStrings > 0)
+		return CFL_LIMIT_1D;
+	return settings.domainDepth > 1 ? CFL_LIMIT_3D : CFL_LIMIT;
+}
+
+bool applyStabilityGuard(SolverSettings& settings, std::string& error)
+{
+	if (settings.propagationFactor < 0.0f || settings.dampingFactor < 0.0f || settings.boundaryGain < 0.0f || settings.boundaryGain > 1.0f || settings.plateStiffness < 0.0f)
+	{
+		error = "Propagation, damping and plate stiffness must be >= 0 and boundary gain in [0, 1]";
+		return false;
+	}
+
+	//Largest propagation of any cell - Only a map can raise it above the uniform value//
+	float maxPropagation = settings.propagationFactor;
+	if (!settings.materialMap.empty())
+	{
+		SolverSettings unscaled = settings;
+		unscaled.oversampling = 1;
+		Domain domain = buildDomain(unscaled);
+		for (size_t i = 0; i != domain.cellTypes.size(); ++i)
+		{
+			if (domain.propagation[i] < 0.0f || domain.damping[i] < 0.0f)
+			{
+				error = "Material map sets a negative propagation or damping";
+				return false;
+			}
+			if (!(domain.cellTypes[i] & CELL_WALL))
+				maxPropagation = std::max(maxPropagation, domain.propagation[i]);
+		}
+	}
+
+	//A plate's biharmonic term takes up to 8 * stiffness of the same limit//
+	if (settings.plateStiffness > 0.0f)
+		maxPropagation += 8.0f * settings.plateStiffness;
+
+	//Steps per sample scale propagation per step by 1 / oversampling^2, and plate stiffness alike//
+	int oversampling = 1;
+	while (maxPropagation / (float)(oversampling * oversampling) > getCFLLimit(settings))
+	{
+		if (++oversampling > MAX_OVERSAMPLING)
+		{
+			error = "Propagation " + std::to_string(maxPropagation) + " would need more than " + std::to_string(MAX_OVERSAMPLING) + " steps per sample";
+			return false;
+		}
+	}
+	settings.oversampling = oversampling;
+	return true;
+}
+
+OversampledSolver::OversampledSolver(Solver* aSolver, int aOversampling) : solver(aSolver), oversampling(aOversampling)
+{
+	name = std::string(solver->getName()) + " x" + std::to_string(oversampling);
+
+	//Blackman windowed sinc at the step rate, unity gain at DC//
+	int numTaps = oversampling * tapsPerPhase;
+	float cutoff = DECIMATION_CUTOFF / (float)oversampling;
+	std::vector<double> taps(numTaps);
+	double sum = 0.0;
+	for (int k = 0; k != numTaps; ++k)
+	{
+		const double pi = 3.14159265358979323846;
+		double t = k - (numTaps - 1) * 0.5;
+		double sinc = t == 0.0 ? 1.0 : std::sin(2.0 * pi * cutoff * t) / (2.0 * pi * cutoff * t);
+		double window = 0.42 - 0.5 * std::cos(2.0 * pi * k / (numTaps - 1)) + 0.08 * std::cos(4.0 * pi * k / (numTaps - 1));
+		taps[k] = sinc * window;
+		sum += taps[k];
+	}
+
+	phaseTaps.resize(numTaps);
+	for (int q = 0; q != oversampling; ++q)
+	{
+		for (int j = 0; j != tapsPerPhase; ++j)
+			phaseTaps[q * tapsPerPhase + j] = (float)(taps[j * oversampling + q] / sum);
+	}
+	history.assign(oversampling * (tapsPerPhase - 1), 0.0f);
+}
+
+OversampledSolver::~OversampledSolver()
+{
+	delete solver;
+}
+
+const char* OversampledSolver::getName() const
+{
+	return name.c_str();
+}
+
+void OversampledSolver::process(const float* excitation, float* output, int numSamples)
+{
+	//Strikes land on the first step of each sample - Adding to pressure is a velocity kick over one step, so shorter steps take proportionally less//
+	float excitationScale = 1.0f / (float)oversampling;
+	stepExcitation.assign(numSamples * oversampling, 0.0f);
+	stepOutput.resize(numSamples * oversampling);
+	for (int n = 0; n != numSamples; ++n)
+		stepExcitation[n * oversampling] = excitation[n] * excitationScale;
+
+	//Step r of sample n lies (r + 1) / oversampling of the way from sample n - 1's point, so the last step of each sample is on the path//
+	for (int p = 0; p != 2 && numSamples > 0; ++p)
+	{
+		const float* path = probePath[p];
+		if (path == NULL)
+			continue;
+		stepPath[p].resize(numSamples * oversampling * 2);
+		for (int n = 0; n != numSamples; ++n)
+		{
+			const float* from = n > 0 ? path + (n - 1) * 2 : (isPathEnded[p] ? pathEnd[p] : path);
+			for (int r = 0; r != oversampling; ++r)
+			{
+				float t = (float)(r + 1) / (float)oversampling;
+				stepPath[p][(n * oversampling + r) * 2 + 0] = from[0] + (path[n * 2 + 0] - from[0]) * t;
+				stepPath[p][(n * oversampling + r) * 2 + 1] = from[1] + (path[n * 2 + 1] - from[1]) * t;
+			}
+		}
+		pathEnd[p][0] = path[numSamples * 2 - 2];
+		pathEnd[p][1] = path[numSamples * 2 - 1];
+		isPathEnded[p] = true;
+		solver->setProbePaths(p == 0 ? &stepPath[p][0] : NULL, p == 1 ? &stepPath[p][0] : NULL);
+	}
+	probePath[0] = NULL;
+	probePath[1] = NULL;
+
+	solver->process(&stepExcitation[0], &stepOutput[0], numSamples * oversampling);
+	decimate(output, numSamples);
+}
+
+void OversampledSolver::decimate(float* output, int numSamples)
+{
+	TRACE_SCOPE("decimate");
+
+	//Deinterleave into branches - Branch r holds steps r, r + oversampling... after its history//
+	int historySize = tapsPerPhase - 1;
+	int stride = historySize + numSamples;
+	branches.resize(oversampling * stride);
+	for (int r = 0; r != oversampling; ++r)
+	{
+		float* branch = &branches[r * stride];
+		std::copy(&history[r * historySize], &history[r * historySize] + historySize, branch);
+		for (int n = 0; n != numSamples; ++n)
+			branch[historySize + n] = stepOutput[n * oversampling + r];
+	}
+
+	//Output n is the filter at the last step of sample n - Tap j * oversampling + q reads branch oversampling - 1 - q, j samples back//
+	int n = 0;
+#ifdef SIMD_SOLVER_AVAILABLE
+	for (; n + 4 <= numSamples; n += 4)
+	{
+		__m128 sum = _mm_setzero_ps();
+		for (int q = 0; q != oversampling; ++q)
+		{
+			const float* branch = &branches[(oversampling - 1 - q) * stride + historySize + n];
+			const float* taps = &phaseTaps[q * tapsPerPhase];
+			for (int j = 0; j != tapsPerPhase; ++j)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(taps[j]), _mm_loadu_ps(branch - j)));
+		}
+		_mm_storeu_ps(output + n, sum);
+	}
+#endif
+
+	//Remaining samples that don't fill a vector - Same sum order//
+	for (; n != numSamples; ++n)
+	{
+		float sum = 0.0f;
+		for (int q = 0; q != oversampling; ++q)
+		{
+			const float* branch = &branches[(oversampling - 1 - q) * stride + historySize + n];
+			const float* taps = &phaseTaps[q * tapsPerPhase];
+			for (int j = 0; j != tapsPerPhase; ++j)
+				sum += taps[j] * branch[-j];
+		}
+		output[n] = sum;
+	}
+
+	//Keep each branch's tail for the next block//
+	for (int r = 0; r != oversampling; ++r)
+	{
+		const float* branch = &branches[r * stride];
+		std::copy(branch + numSamples, branch + numSamples + historySize, &history[r * historySize]);
+	}
+}
+
+void OversampledSolver::setExcitationPosition(float x, float y)
+{
+	isPathEnded[0] = false;
+	solver->setExcitationPosition(x, y);
+}
+
+void OversampledSolver::setProbePaths(const float* excitationPath, const float* listenerPath)
+{
+	if (!solver->isProbePathFollowed())
+		return;
+	if (excitationPath != NULL)
+		probePath[0] = excitationPath;
+	if (listenerPath != NULL)
+		probePath[1] = listenerPath;
+}
+
+bool OversampledSolver::isProbePathFollowed() const
+{
+	return solver->isProbePathFollowed();
+}
+
+void OversampledSolver::setMaterial(float propagation, float damping, float boundaryGain)
+{
+	solver->setMaterial(propagation, damping, boundaryGain);
+}
+
+double OversampledSolver::getEnergy()
+{
+	return solver->getEnergy();
+}
+
+void OversampledSolver::getField(float* field)
+{
+	solver->getField(field);
+}
+
+void OversampledSolver::setField(const float* field)
+{
+	solver->setField(field);
+}
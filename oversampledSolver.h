@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "solver.h"
+
+///////////
+//DEFINES//
+///////////
+
+#define CFL_LIMIT					0.5f	//Largest stable propagation factor of the 2D scheme per step - (c * dt / dx)^2 <= 1/2.
+#define MAX_OVERSAMPLING			8		//Most steps per output sample the stability guard will choose before rejecting a material.
+#define DECIMATION_TAPS_PER_PHASE	16		//Low-pass taps per polyphase branch - The filter has oversampling times as many.
+#define DECIMATION_CUTOFF			0.45f	//Low-pass cutoff as a fraction of the output sample rate.
+
+//Check settings' material is valid and stable before a run - Sets oversampling to the fewest steps per output sample keeping every cell's propagation, plus 8 times any plate stiffness, within getCFLLimit().//
+//Returns false with error describing the problem if the material is invalid or would need more than MAX_OVERSAMPLING. Material maps are built to find their largest propagation//
+bool applyStabilityGuard(SolverSettings& settings, std::string& error);
+
+//Largest stable propagation per step of settings' grid - CFL_LIMIT, CFL_LIMIT_3D for a volume or CFL_LIMIT_1D for a string bank//
+float getCFLLimit(const SolverSettings& settings);
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//OversampledSolver - Runs a backend created with settings.oversampling steps per output   //
+//sample. Excitation is zero stuffed up to the step rate and scaled, so a strike moves the //
+//membrane as fast, and the listener stream decimated back down by a polyphase low-pass    //
+//FIR, 4 output samples at a time with SSE. The filter delays output by half its length at //
+//the step rate.                                                                           //
+/////////////////////////////////////////////////////////////////////////////////////////////
+class OversampledSolver : public Solver {
+private:
+	Solver* solver;						//Backend stepping at the internal rate - Owned.
+	int oversampling;
+	int tapsPerPhase = DECIMATION_TAPS_PER_PHASE;
+	std::string name;
+
+	std::vector<float> phaseTaps;		//Low-pass taps grouped by branch - Branch q holds taps q, q + oversampling, q + 2 * oversampling...
+	std::vector<float> history;			//Last tapsPerPhase - 1 samples of each branch's input from previous blocks.
+	std::vector<float> branches;		//Each branch's history followed by its input for the current block.
+	std::vector<float> stepExcitation;	//Excitation and listener at the step rate for the current block.
+	std::vector<float> stepOutput;
+
+	//Probe paths at the output rate for the next block, glided linearly between samples to the step rate//
+	const float* probePath[2] = { NULL, NULL };	//Excitation, listener.
+	std::vector<float> stepPath[2];
+	float pathEnd[2][2];				//Last point of each probe's previous path, which the next one glides on from.
+	bool isPathEnded[2] = { false, false };
+
+	//Filter the step rate listener stream of the current block down to numSamples output samples//
+	void decimate(float* output, int numSamples);
+
+public:
+	//Takes ownership of aSolver, which must have been created with aSolver's settings.oversampling = aOversampling//
+	OversampledSolver(Solver* aSolver, int aOversampling);
+	~OversampledSolver();
+
+	const char* getName() const;
+	void process(const float* excitation, float* output, int numSamples);
+	void setExcitationPosition(float x, float y);
+	void setProbePaths(const float* excitationPath, const float* listenerPath);
+	bool isProbePathFollowed() const;
+	void setMaterial(float propagation, float damping, float boundaryGain);
+	double getEnergy();
+	void getField(float* field);
+	void setField(const float* field);
+};
@@ -0,0 +1,133 @@
+#include "packedSolver.h"
+
+#include <cstring>
+
+#include "profiler.h"
+#include "tracer.h"
+
+PackedSolver::PackedSolver(const SolverSettings& aSettings) : CPUSolver(aSettings), precision(aSettings.storagePrecision)
+{
+	//Packed planes replace the fp32 ones//
+	pressure[0].clear();
+	pressure[1].clear();
+	packed[0].assign(width * height, 0);
+	packed[1].assign(width * height, 0);
+
+	currentWindow.assign(width * 3, 0.0f);
+	previousWindow.assign(width * 2, 0.0f);
+}
+
+const char* PackedSolver::getName() const
+{
+	switch (precision)
+	{
+	case PRECISION_FP16:	return "CPU scalar fp16";
+	case PRECISION_BF16:	return "CPU scalar bf16";
+	case PRECISION_Q15:		return "CPU scalar q15";
+	default:				return "CPU scalar";
+	}
+}
+
+void PackedSolver::computeStep(const uint16_t* current, uint16_t* previous, const CellProbe& probe, float excitation)
+{
+	float* window = &currentWindow[0];
+	float* previousRow = &previousWindow[width];
+
+	//Prime window with the first two rows//
+	unpackRow(current, window + width, width * 2, precision);
+
+	for (int y = 1; y != height - 1; ++y)
+	{
+		//Slide window down a row and unpack the new top row//
+		memmove(window, window + width, sizeof(float) * width * 2);
+		unpackRow(current + (y + 1) * width, window + width * 2, width, precision);
+		unpackRow(previous + y * width, previousRow, width, precision);
+
+		//Window row 1 is row y, so cell types and coefficients are offset to match//
+		computeSpan(window, &previousWindow[0], (y - 1) * width, 1, 1, width - 1);
+
+		//Probe cells of this row - The outer ring is wall, so never weighted//
+		for (int k = 0; k != 4; ++k)
+		{
+			if (probe.weight[k] != 0.0f && probe.index[k] / width == y)
+				previousRow[probe.index[k] % width] += excitation * probe.weight[k];
+		}
+
+		packRow(previousRow + 1, previous + y * width + 1, width - 2, precision);
+	}
+}
+
+void PackedSolver::process(const float* excitation, float* output, int numSamples)
+{
+	StageTimer simulateStageTimer;
+	TRACE_SCOPE("simulate");
+
+	int n = 0;
+	while (n != numSamples)
+	{
+		int segmentEnd = n + rampMaterial(numSamples - n);
+		for (; n != segmentEnd; ++n)
+		{
+			uint16_t* next = &packed[1 - currentPlane][0];
+			computeStep(&packed[currentPlane][0], next, getExcitationProbe(n), excitation[n]);
+
+			//Listener hears the stored values - Walls weigh 0, silencing boundaries//
+			CellProbe probe = getListenerProbe(n);
+			output[n] = 0.0f;
+			for (int k = 0; k != 4; ++k)
+			{
+				if (probe.weight[k] == 0.0f)
+					continue;
+				float listener;
+				unpackRow(next + probe.index[k], &listener, 1, precision);
+				output[n] += listener * probe.weight[k];
+			}
+
+			currentPlane = 1 - currentPlane;
+		}
+	}
+	endPaths(numSamples);
+
+	profiler.recordCPU(STAGE_SIMULATE, simulateStageTimer.elapsed());
+}
+
+double PackedSolver::getEnergy()
+{
+	std::vector<float> current(width * height);
+	std::vector<float> previous(width * height);
+	unpackRow(&packed[currentPlane][0], &current[0], width * height, precision);
+	unpackRow(&packed[1 - currentPlane][0], &previous[0], width * height, precision);
+	return computeFieldEnergy(domain, &current[0], &previous[0]);
+}
+
+void PackedSolver::getField(float* field)
+{
+	std::vector<float> current(width * height);
+	std::vector<float> previous(width * height);
+	unpackRow(&packed[currentPlane][0], &current[0], width * height, precision);
+	unpackRow(&packed[1 - currentPlane][0], &previous[0], width * height, precision);
+	for (int i = 0; i != width * height; ++i)
+	{
+		field[i * 4 + 0] = current[i];
+		field[i * 4 + 1] = previous[i];
+		field[i * 4 + 2] = getTransmission(domain.cellTypes[i]);
+		field[i * 4 + 3] = domain.cellTypes[i];
+	}
+}
+
+void PackedSolver::setField(const float* field)
+{
+	std::vector<float> current(width * height);
+	std::vector<float> previous(width * height);
+	for (int i = 0; i != width * height; ++i)
+	{
+		current[i] = field[i * 4 + 0];
+		previous[i] = field[i * 4 + 1];
+		domain.cellTypes[i] = (uint8_t)field[i * 4 + 3];
+	}
+	computeUpdateCoefficients(domain, materialRamp.getOffset(), coefficients);
+	setExcitationPoint(excitationPoint[0], excitationPoint[1]);
+	setListenerPoint(listenerPoint[0], listenerPoint[1]);
+	packRow(&current[0], &packed[currentPlane][0], width * height, precision);
+	packRow(&previous[0], &packed[1 - currentPlane][0], width * height, precision);
+}
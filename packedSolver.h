@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "cpuSolver.h"
+#include "precision.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//PackedSolver - CPUSolver with the pressure planes stored in a 16 bit precision, halving   //
+//the memory each step streams through. Rows are unpacked into a small fp32 window, computed//
+//with the scalar kernel and packed back, so only storage loses precision, not arithmetic.  //
+///////////////////////////////////////////////////////////////////////////////////////////////
+class PackedSolver : public CPUSolver {
+private:
+	StoragePrecision precision;
+	std::vector<uint16_t> packed[2];	//Pressure planes in storage precision - Alternately hold timestep n & n-1.
+	std::vector<float> currentWindow;	//Rows y-1, y, y+1 of timestep n unpacked.
+	std::vector<float> previousWindow;	//Row y of timestep n-1 unpacked, second row - Laid out to index as the planes do.
+
+	//Compute next timestep into previous plane, adding excitation over the probe's cells before they are packed//
+	void computeStep(const uint16_t* current, uint16_t* previous, const CellProbe& probe, float excitation);
+
+public:
+	PackedSolver(const SolverSettings& aSettings);
+
+	const char* getName() const;
+	void process(const float* excitation, float* output, int numSamples);
+	double getEnergy();
+	void getField(float* field);
+	void setField(const float* field);
+};
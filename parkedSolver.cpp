@@ -0,0 +1,101 @@
+#include "parkedSolver.h"
+
+#include <cmath>
+
+#include "tracer.h"
+
+ParkedSolver::ParkedSolver(Solver* aSolver, float aSilenceFloor) : solver(aSolver), silenceFloor(aSilenceFloor)
+{
+	name = std::string(solver->getName()) + " parked";
+	listenerThreshold = std::sqrt(aSilenceFloor);
+}
+
+ParkedSolver::~ParkedSolver()
+{
+	delete solver;
+}
+
+const char* ParkedSolver::getName() const
+{
+	return name.c_str();
+}
+
+void ParkedSolver::process(const float* excitation, float* output, int numSamples)
+{
+	bool isExcited = false;
+	for (int i = 0; i != numSamples && !isExcited; ++i)
+		isExcited = excitation[i] != 0.0f;
+
+	//Parked until something happens - The held sample rather than zeros, so a field resting off zero doesn't click//
+	if (isParked && !isExcited)
+	{
+		for (int i = 0; i != numSamples; ++i)
+			output[i] = heldSample;
+		parkedSamples += numSamples;
+		return;
+	}
+
+	isParked = false;
+	solver->process(excitation, output, numSamples);
+	if (isExcited || numSamples == 0)
+		return;
+
+	//Only a quiet listener is worth a reduction over the whole field//
+	float low = output[0];
+	float high = output[0];
+	for (int i = 1; i != numSamples; ++i)
+	{
+		low = output[i] < low ? output[i] : low;
+		high = output[i] > high ? output[i] : high;
+	}
+	if (high - low >= listenerThreshold)
+		return;
+
+	TRACE_SCOPE("silence check");
+	if (solver->getEnergy() < silenceFloor)
+	{
+		isParked = true;
+		heldSample = output[numSamples - 1];
+	}
+}
+
+void ParkedSolver::setExcitationPosition(float x, float y)
+{
+	isParked = false;
+	solver->setExcitationPosition(x, y);
+}
+
+void ParkedSolver::setProbePaths(const float* excitationPath, const float* listenerPath)
+{
+	//Moving probes are moves too - The backend only lets go of its paths by stepping them//
+	if (solver->isProbePathFollowed() && (excitationPath != NULL || listenerPath != NULL))
+		isParked = false;
+	solver->setProbePaths(excitationPath, listenerPath);
+}
+
+bool ParkedSolver::isProbePathFollowed() const
+{
+	return solver->isProbePathFollowed();
+}
+
+void ParkedSolver::setMaterial(float propagation, float damping, float boundaryGain)
+{
+	isParked = false;
+	solver->setMaterial(propagation, damping, boundaryGain);
+}
+
+double ParkedSolver::getEnergy()
+{
+	return solver->getEnergy();
+}
+
+void ParkedSolver::getField(float* field)
+{
+	solver->getField(field);
+}
+
+void ParkedSolver::setField(const float* field)
+{
+	isParked = false;
+	solver->setField(field);
+}
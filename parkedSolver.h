@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+
+#include "solver.h"
+
+///////////
+//DEFINES//
+///////////
+
+#define DEFAULT_SILENCE_FLOOR	1e-8f	//Field energy below which the real-time loop parks the solver - Well under the quietest audible decay.
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//ParkedSolver - Stops stepping a backend once its field has decayed below a silence floor.//
+//While parked, blocks without excitation are answered with the listener's last sample and //
+//no simulation runs. The next strike, move, material change or field load resumes the    //
+//backend from the frozen field. Energy is only reduced after a block with no excitation   //
+//whose listener barely moved, so a ringing drum costs nothing extra.                      //
+/////////////////////////////////////////////////////////////////////////////////////////////
+class ParkedSolver : public Solver {
+private:
+	Solver* solver;						//Backend doing the stepping - Owned.
+	double silenceFloor;
+	float listenerThreshold;			//Listener peak to peak under which a block is worth checking energy for - sqrt(silenceFloor).
+	std::string name;
+
+	bool isParked = false;
+	float heldSample = 0.0f;			//Listener sample of the frozen field, repeated while parked.
+	long long parkedSamples = 0;		//Samples answered without stepping since creation - For logs.
+
+public:
+	//Takes ownership of aSolver//
+	ParkedSolver(Solver* aSolver, float aSilenceFloor);
+	~ParkedSolver();
+
+	bool getIsParked() const { return isParked; }
+	long long getParkedSamples() const { return parkedSamples; }
+
+	const char* getName() const;
+	void process(const float* excitation, float* output, int numSamples);
+	void setExcitationPosition(float x, float y);
+	void setProbePaths(const float* excitationPath, const float* listenerPath);
+	bool isProbePathFollowed() const;
+	void setMaterial(float propagation, float damping, float boundaryGain);
+	double getEnergy();
+	void getField(float* field);
+	void setField(const float* field);
+};
@@ -0,0 +1,188 @@
+#include "plateSolver.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#ifdef SIMD_SOLVER_AVAILABLE
+#include <emmintrin.h>
+#endif
+
+PlateSolver::PlateSolver(const SolverSettings& aSettings, int aNumThreads) : ThreadedSolver(aSettings, aNumThreads)
+{
+	isThreaded = aNumThreads != 1;
+	computeStiffness();
+
+	//Base construction placed the excitation before this class existed//
+	setExcitationPosition(settings.excitationPosition[0], settings.excitationPosition[1]);
+}
+
+const char* PlateSolver::getName() const
+{
+	return isThreaded ? "CPU plate threaded" : "CPU plate";
+}
+
+void PlateSolver::computeStiffness()
+{
+	//Stiffness is given per output sample and scales with the square of the step, as propagation does//
+	MaterialOffset offset = materialRamp.getOffset();
+	double stepStiffness = (double)settings.plateStiffness / (double)(settings.oversampling * settings.oversampling);
+	stiffness.assign(width * height, 0.0f);
+	for (int y = 1; y < height - 1; ++y)
+	{
+		for (int x = 1; x < width - 1; ++x)
+		{
+			int i = y * width + x;
+			if (domain.cellTypes[i] & CELL_WALL)
+				continue;
+			double damp = std::max((double)domain.damping[i] + offset.damping, 0.0);
+			stiffness[i] = (float)(stepStiffness / (1.0 + damp));
+		}
+	}
+	stiffnessDamping = offset.damping;
+}
+
+int PlateSolver::rampMaterial(int numSamples)
+{
+	int segment = ThreadedSolver::rampMaterial(numSamples);
+	if (materialRamp.getOffset().damping != stiffnessDamping)
+		computeStiffness();
+	return segment;
+}
+
+void PlateSolver::computePlateSpan(const float* current, float* previous, int y, int xBegin, int xEnd)
+{
+	//Cells outside the grid read as zero, like the walls around it//
+	auto at = [&](int x, int cellY) { return (x < 0 || cellY < 0 || x >= width || cellY >= height) ? 0.0f : current[cellY * width + x]; };
+
+	for (int x = xBegin; x < xEnd; ++x)
+	{
+		int i = y * width + x;
+
+		//Neighbours in the order the SSE kernel sums them - Mirror images paired first, so a symmetric plate rounds symmetrically//
+		float edge = (at(x - 1, y) + at(x + 1, y)) + (at(x, y + 1) + at(x, y - 1));
+		float diagonal = (at(x - 1, y + 1) + at(x + 1, y + 1)) + (at(x - 1, y - 1) + at(x + 1, y - 1));
+		float far = (at(x - 2, y) + at(x + 2, y)) + (at(x, y + 2) + at(x, y - 2));
+		float biharmonic = 20.0f * current[i] - 8.0f * edge + 2.0f * diagonal + far;
+
+		float p_next = coefficients.centre[i] * current[i] + coefficients.previous[i] * previous[i];
+		p_next += coefficients.neighbour[i] * edge;
+		p_next -= stiffness[i] * biharmonic;
+
+		previous[i] = p_next;	//Previous timestep is no longer needed - Overwritten with the next.
+	}
+}
+
+void PlateSolver::computeRows(const float* current, float* previous, int rowBegin, int rowEnd)
+{
+	int y = rowBegin;
+	while (y != rowEnd)
+	{
+		//Rows within 2 of the grid's edge would read outside it - Scalar with bounds checks//
+		if (y < 2 || y + PLATE_ROW_BLOCK > height - 2 || y + PLATE_ROW_BLOCK > rowEnd)
+		{
+			computePlateSpan(current, previous, y, 1, width - 1);
+			++y;
+			continue;
+		}
+
+#ifdef SIMD_SOLVER_AVAILABLE
+		const __m128 twenty = _mm_set1_ps(20.0f);
+		const __m128 eight = _mm_set1_ps(8.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+
+		int x = 1;
+		for (; x + 4 <= width - 1; x += 4)
+		{
+			//Rows y - 2 to y + 3 of the stencils of rows y and y + 1, indexed from 2 - Each loaded once for both//
+			const float* rows[6];
+			for (int k = 0; k != 6; ++k)
+				rows[k] = current + (y + k - 2) * width + x;
+			__m128 centreColumn[6];
+			for (int k = 0; k != 6; ++k)
+				centreColumn[k] = _mm_loadu_ps(rows[k]);
+			__m128 left[6];
+			__m128 right[6];
+			for (int k = 1; k != 5; ++k)
+			{
+				left[k] = _mm_loadu_ps(rows[k] - 1);
+				right[k] = _mm_loadu_ps(rows[k] + 1);
+			}
+
+			for (int r = 0; r != PLATE_ROW_BLOCK; ++r)
+			{
+				int k = r + 2;
+				int i = (y + r) * width + x;
+
+				__m128 edge = _mm_add_ps(_mm_add_ps(left[k], right[k]), _mm_add_ps(centreColumn[k + 1], centreColumn[k - 1]));
+				__m128 diagonal = _mm_add_ps(_mm_add_ps(left[k + 1], right[k + 1]), _mm_add_ps(left[k - 1], right[k - 1]));
+				__m128 far = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(rows[k] - 2), _mm_loadu_ps(rows[k] + 2)), _mm_add_ps(centreColumn[k + 2], centreColumn[k - 2]));
+				__m128 biharmonic = _mm_sub_ps(_mm_mul_ps(twenty, centreColumn[k]), _mm_mul_ps(eight, edge));
+				biharmonic = _mm_add_ps(_mm_add_ps(biharmonic, _mm_mul_ps(two, diagonal)), far);
+
+				__m128 p_next = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&coefficients.centre[i]), centreColumn[k]), _mm_mul_ps(_mm_loadu_ps(&coefficients.previous[i]), _mm_loadu_ps(previous + i)));
+				p_next = _mm_add_ps(p_next, _mm_mul_ps(_mm_loadu_ps(&coefficients.neighbour[i]), edge));
+				p_next = _mm_sub_ps(p_next, _mm_mul_ps(_mm_loadu_ps(&stiffness[i]), biharmonic));
+
+				_mm_storeu_ps(previous + i, p_next);
+			}
+		}
+
+		//Remaining cells that don't fill a vector//
+		for (int r = 0; r != PLATE_ROW_BLOCK; ++r)
+			computePlateSpan(current, previous, y + r, x, width - 1);
+#else
+		for (int r = 0; r != PLATE_ROW_BLOCK; ++r)
+			computePlateSpan(current, previous, y + r, 1, width - 1);
+#endif
+		y += PLATE_ROW_BLOCK;
+	}
+}
+
+void PlateSolver::setExcitationPosition(float x, float y)
+{
+	CPUSolver::setExcitationPosition(x, y);
+
+	//Walls must stay at zero - A strike on one moves to the nearest updated cell, searching outwards ring by ring//
+	int cellX = (int)excitationPoint[0];
+	int cellY = (int)excitationPoint[1];
+	for (int radius = 0; radius < std::max(width, height); ++radius)
+	{
+		for (int dy = -radius; dy <= radius; ++dy)
+		{
+			for (int dx = -radius; dx <= radius; ++dx)
+			{
+				if (std::max(std::abs(dx), std::abs(dy)) != radius)
+					continue;
+				int candidateX = cellX + dx;
+				int candidateY = cellY + dy;
+				if (candidateX < 1 || candidateY < 1 || candidateX >= width - 1 || candidateY >= height - 1)
+					continue;
+				if (!(domain.cellTypes[candidateY * width + candidateX] & CELL_WALL))
+				{
+					setExcitationPoint((float)candidateX, (float)candidateY);
+					return;
+				}
+			}
+		}
+	}
+}
+
+void PlateSolver::setField(const float* field)
+{
+	CPUSolver::setField(field);
+	computeStiffness();
+
+	//Walls and the outer ring are never updated, so must be loaded at rest//
+	for (int y = 0; y != height; ++y)
+	{
+		for (int x = 0; x != width; ++x)
+		{
+			int i = y * width + x;
+			if (x == 0 || y == 0 || x == width - 1 || y == height - 1 || (domain.cellTypes[i] & CELL_WALL))
+			{
+				pressure[0][i] = 0.0f;
+				pressure[1][i] = 0.0f;
+			}
+		}
+	}
+}
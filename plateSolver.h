@@ -0,0 +1,43 @@
+#pragma once
+
+#include "threadedSolver.h"
+
+///////////
+//DEFINES//
+///////////
+
+#define PLATE_ROW_BLOCK		2		//Rows the SSE kernel computes together, sharing the loads of the rows between them.
+
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//PlateSolver - Stiff plate over the drum's domain. Adds the biharmonic term of a Kirchhoff    //
+//plate, -stiffness * (20p - 8 * edge neighbours + 2 * diagonals + cells 2 away), to the       //
+//membrane update, so tension and stiffness can be mixed. The 13 point stencil is computed 4   //
+//cells by PLATE_ROW_BLOCK rows at a time, loading each row of the stencil once per block.     //
+//Walls hold zero pressure, which clamps the plate's edge and lets the kernel read neighbours  //
+//without masking them. Rows are split across threads as ThreadedSolver's are - 1 thread runs //
+//on the calling thread only.                                                                  //
+/////////////////////////////////////////////////////////////////////////////////////////////////
+class PlateSolver : public ThreadedSolver {
+private:
+	std::vector<float> stiffness;		//Biharmonic coefficient of every cell, pre-divided by 1 + damping - Zero for walls.
+	float stiffnessDamping;				//Damping offset stiffness was last computed for.
+	bool isThreaded;
+
+	//Recompute stiffness for the current damping offset//
+	void computeStiffness();
+
+	//Scalar update of cells [xBegin, xEnd) of row y, reading cells outside the grid as zero - Also used for the tails the SSE kernel can't cover//
+	void computePlateSpan(const float* current, float* previous, int y, int xBegin, int xEnd);
+
+protected:
+	void computeRows(const float* current, float* previous, int rowBegin, int rowEnd);
+	int rampMaterial(int numSamples);
+
+public:
+	//0 threads uses every hardware thread, as ThreadedSolver//
+	PlateSolver(const SolverSettings& aSettings, int aNumThreads = 1);
+
+	const char* getName() const;
+	void setExcitationPosition(float x, float y);
+	void setField(const float* field);
+};
@@ -0,0 +1,174 @@
+#include "precision.h"
+
+#include <cmath>
+#include <cstring>
+
+//F16C converts 8 halves per instruction - Part of every AVX2 target//
+#if defined(__F16C__) || defined(__AVX2__)
+#define F16C_AVAILABLE	1
+#include <immintrin.h>
+#endif
+
+const char* getPrecisionName(StoragePrecision precision)
+{
+	switch (precision)
+	{
+	case PRECISION_FP32:	return "fp32";
+	case PRECISION_FP16:	return "fp16";
+	case PRECISION_BF16:	return "bf16";
+	case PRECISION_Q15:		return "q15";
+	default:				return "unknown";
+	}
+}
+
+StoragePrecision findPrecision(const char* name)
+{
+	for (int i = 0; i != NUM_OF_PRECISIONS; ++i)
+	{
+		if (strcmp(name, getPrecisionName((StoragePrecision)i)) == 0)
+			return (StoragePrecision)i;
+	}
+	return NUM_OF_PRECISIONS;
+}
+
+int getPrecisionBytes(StoragePrecision precision)
+{
+	return precision == PRECISION_FP32 ? 4 : 2;
+}
+
+////////////////////////
+//Scalar Conversions//
+////////////////////////
+
+static uint32_t toBits(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+static float fromBits(uint32_t bits)
+{
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static uint16_t floatToHalf(float value)
+{
+	uint32_t bits = toBits(value);
+	uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+	uint32_t magnitude = bits & 0x7FFFFFFF;
+
+	//NaN stays NaN, overflow and infinity become infinity//
+	if (magnitude > 0x7F800000)
+		return sign | 0x7E00;
+	if (magnitude >= 0x477FF000)
+		return sign | 0x7C00;
+
+	//Below the smallest normal half - Let the FPU round to a multiple of 2^-24//
+	if (magnitude < 0x38800000)
+		return sign | (uint16_t)(int)std::nearbyint(fromBits(magnitude) * 16777216.0f);
+
+	//Normal - Rebias exponent and round mantissa to nearest even//
+	uint32_t rounded = magnitude + 0xFFF + ((magnitude >> 13) & 1);
+	return sign | (uint16_t)((rounded - 0x38000000) >> 13);
+}
+
+static float halfToFloat(uint16_t half)
+{
+	uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+	uint32_t exponent = (half >> 10) & 0x1F;
+	uint32_t mantissa = half & 0x3FF;
+
+	if (exponent == 0)
+		return fromBits(sign | toBits(mantissa * (1.0f / 16777216.0f)));	//Zero and subnormals.
+	if (exponent == 31)
+		return fromBits(sign | 0x7F800000 | (mantissa << 13));				//Infinity and NaN.
+	return fromBits(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+static uint16_t floatToBF16(float value)
+{
+	uint32_t bits = toBits(value);
+	if ((bits & 0x7FFFFFFF) > 0x7F800000)
+		return (uint16_t)((bits >> 16) | 0x40);		//Keep NaN quiet rather than rounding it to infinity.
+	bits += 0x7FFF + ((bits >> 16) & 1);
+	return (uint16_t)(bits >> 16);
+}
+
+static float bf16ToFloat(uint16_t value)
+{
+	return fromBits((uint32_t)value << 16);
+}
+
+static uint16_t floatToQ15(float value)
+{
+	float scaled = std::nearbyint(value * (32767.0f / Q15_FULL_SCALE));
+	if (scaled > 32767.0f)
+		scaled = 32767.0f;
+	else if (!(scaled >= -32767.0f))
+		scaled = scaled != scaled ? 0.0f : -32767.0f;	//Saturate symmetrically - NaN becomes silence.
+	return (uint16_t)(int16_t)scaled;
+}
+
+static float q15ToFloat(uint16_t value)
+{
+	return (float)(int16_t)value * (Q15_FULL_SCALE / 32767.0f);
+}
+
+///////////////////
+//Row Conversions//
+///////////////////
+
+void packRow(const float* input, uint16_t* output, int count, StoragePrecision precision)
+{
+	int i = 0;
+	switch (precision)
+	{
+	case PRECISION_FP16:
+#ifdef F16C_AVAILABLE
+		for (; i + 8 <= count; i += 8)
+			_mm_storeu_si128((__m128i*)(output + i), _mm256_cvtps_ph(_mm256_loadu_ps(input + i), _MM_FROUND_TO_NEAREST_INT));
+#endif
+		for (; i < count; ++i)
+			output[i] = floatToHalf(input[i]);
+		break;
+	case PRECISION_BF16:
+		for (; i < count; ++i)
+			output[i] = floatToBF16(input[i]);
+		break;
+	case PRECISION_Q15:
+		for (; i < count; ++i)
+			output[i] = floatToQ15(input[i]);
+		break;
+	default:
+		break;
+	}
+}
+
+void unpackRow(const uint16_t* input, float* output, int count, StoragePrecision precision)
+{
+	int i = 0;
+	switch (precision)
+	{
+	case PRECISION_FP16:
+#ifdef F16C_AVAILABLE
+		for (; i + 8 <= count; i += 8)
+			_mm256_storeu_ps(output + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(input + i))));
+#endif
+		for (; i < count; ++i)
+			output[i] = halfToFloat(input[i]);
+		break;
+	case PRECISION_BF16:
+		for (; i < count; ++i)
+			output[i] = bf16ToFloat(input[i]);
+		break;
+	case PRECISION_Q15:
+		for (; i < count; ++i)
+			output[i] = q15ToFloat(input[i]);
+		break;
+	default:
+		break;
+	}
+}
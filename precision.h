@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+///////////
+//DEFINES//
+///////////
+
+#define Q15_FULL_SCALE		16.0f	//Pressure stored as the largest Q15 value - Covers the +-15 range toInt16Sample() maps to full scale.
+
+//Format pressure values are stored in between steps - Computation is always done in fp32//
+enum StoragePrecision {
+	PRECISION_FP32,		//IEEE single - Reference.
+	PRECISION_FP16,		//IEEE half - 11 bit mantissa, range to 65504.
+	PRECISION_BF16,		//Truncated single - 8 bit mantissa, full fp32 range.
+	PRECISION_Q15,		//Signed 16 bit fixed point over +-Q15_FULL_SCALE - Saturates beyond it.
+	NUM_OF_PRECISIONS
+};
+
+//Short name used on the command line and in benchmark results//
+const char* getPrecisionName(StoragePrecision precision);
+
+//Parse a short name - Returns NUM_OF_PRECISIONS if unknown//
+StoragePrecision findPrecision(const char* name);
+
+//Bytes one pressure value occupies//
+int getPrecisionBytes(StoragePrecision precision);
+
+//Convert a row of values between fp32 and a 16 bit precision - Rounds to nearest even//
+void packRow(const float* input, uint16_t* output, int count, StoragePrecision precision);
+void unpackRow(const uint16_t* input, float* output, int count, StoragePrecision precision);
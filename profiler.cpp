@@ -0,0 +1,198 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <iomanip>
+
+Profiler profiler;
+
+////////////////////
+//StageHistogram//
+////////////////////
+
+StageHistogram::StageHistogram()
+{
+	reset();
+}
+
+int StageHistogram::getBin(uint64_t nanoseconds)
+{
+	//First 4 bins are exact//
+	if (nanoseconds < 4)
+		return (int)nanoseconds;
+
+	//Position of most significant bit, then the 2 bits below it select the quarter octave//
+	int msb = 63;
+	while (!(nanoseconds >> msb))
+		--msb;
+	int subBin = (int)((nanoseconds >> (msb - 2)) & 3);
+	return (msb - 1) * 4 + subBin;
+}
+
+uint64_t StageHistogram::getBinUpperBound(int bin)
+{
+	if (bin < 4)
+		return (uint64_t)bin + 1;
+
+	int msb = bin / 4 + 1;
+	uint64_t subBin = bin % 4;
+	return ((4 + subBin + 1) << (msb - 2)) - 1;
+}
+
+void StageHistogram::record(uint64_t nanoseconds)
+{
+	bins[getBin(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+	count.fetch_add(1, std::memory_order_relaxed);
+
+	//Lock free maximum - Retry only while a smaller value is stored//
+	uint64_t current = maximum.load(std::memory_order_relaxed);
+	while (nanoseconds > current && !maximum.compare_exchange_weak(current, nanoseconds, std::memory_order_relaxed))
+		;
+}
+
+void StageHistogram::reset()
+{
+	for (int i = 0; i != HISTOGRAM_BINS; ++i)
+		bins[i].store(0, std::memory_order_relaxed);
+	count.store(0, std::memory_order_relaxed);
+	maximum.store(0, std::memory_order_relaxed);
+}
+
+uint64_t StageHistogram::getCount() const
+{
+	return count.load(std::memory_order_relaxed);
+}
+
+uint64_t StageHistogram::getMaximum() const
+{
+	return maximum.load(std::memory_order_relaxed);
+}
+
+uint64_t StageHistogram::getPercentile(double fraction) const
+{
+	//Bins may be recorded into while scanning - Total taken from the bins themselves so the scan always terminates//
+	uint64_t binCounts[HISTOGRAM_BINS];
+	uint64_t total = 0;
+	for (int i = 0; i != HISTOGRAM_BINS; ++i)
+	{
+		binCounts[i] = bins[i].load(std::memory_order_relaxed);
+		total += binCounts[i];
+	}
+	if (total == 0)
+		return 0;
+
+	uint64_t target = (uint64_t)(fraction * total);
+	if (target >= total)
+		target = total - 1;
+
+	uint64_t cumulative = 0;
+	for (int i = 0; i != HISTOGRAM_BINS; ++i)
+	{
+		cumulative += binCounts[i];
+		if (cumulative > target)
+			return std::min(getBinUpperBound(i), getMaximum());
+	}
+	return getMaximum();
+}
+
+////////////
+//Profiler//
+////////////
+
+Profiler::Profiler() : budget(0), deadlineMisses(0)
+{
+}
+
+void Profiler::setBudget(int bufferSize, int sampleRate)
+{
+	budget = (uint64_t)bufferSize * 1000000000ull / (uint64_t)sampleRate;
+}
+
+void Profiler::recordCPU(ProfileStage stage, uint64_t nanoseconds)
+{
+	cpuHistograms[stage].record(nanoseconds);
+}
+
+void Profiler::recordGPU(ProfileStage stage, uint64_t nanoseconds)
+{
+	gpuHistograms[stage].record(nanoseconds);
+}
+
+void Profiler::recordBuffer(uint64_t nanoseconds)
+{
+	bufferHistogram.record(nanoseconds);
+	if (nanoseconds > budget.load(std::memory_order_relaxed))
+		deadlineMisses.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t Profiler::getDeadlineMisses() const
+{
+	return deadlineMisses.load(std::memory_order_relaxed);
+}
+
+const StageHistogram& Profiler::getCPUHistogram(ProfileStage stage) const
+{
+	return cpuHistograms[stage];
+}
+
+const StageHistogram& Profiler::getGPUHistogram(ProfileStage stage) const
+{
+	return gpuHistograms[stage];
+}
+
+//Print a single histogram row in microseconds//
+static void dumpHistogram(std::ostream& stream, const char* name, const char* device, const StageHistogram& histogram)
+{
+	if (histogram.getCount() == 0)
+		return;
+
+	stream << std::setw(12) << name << std::setw(5) << device
+		<< std::setw(10) << histogram.getCount()
+		<< std::setw(12) << histogram.getPercentile(0.5) / 1000.0
+		<< std::setw(12) << histogram.getPercentile(0.99) / 1000.0
+		<< std::setw(12) << histogram.getMaximum() / 1000.0 << std::endl;
+}
+
+void Profiler::dump(std::ostream& stream) const
+{
+	std::ios::fmtflags flags = stream.flags();
+	stream << std::fixed << std::setprecision(1);
+	stream << std::setw(12) << "stage" << std::setw(5) << "" << std::setw(10) << "count"
+		<< std::setw(12) << "p50 (us)" << std::setw(12) << "p99 (us)" << std::setw(12) << "max (us)" << std::endl;
+
+	for (int i = 0; i != NUM_OF_STAGES; ++i)
+	{
+		dumpHistogram(stream, getStageName((ProfileStage)i), "cpu", cpuHistograms[i]);
+		dumpHistogram(stream, getStageName((ProfileStage)i), "gpu", gpuHistograms[i]);
+	}
+	dumpHistogram(stream, "buffer", "cpu", bufferHistogram);
+
+	stream << "Deadline misses: " << getDeadlineMisses() << " of " << bufferHistogram.getCount()
+		<< " buffers (budget " << budget.load(std::memory_order_relaxed) / 1000.0 << " us)" << std::endl;
+	stream.flags(flags);
+}
+
+void Profiler::reset()
+{
+	for (int i = 0; i != NUM_OF_STAGES; ++i)
+	{
+		cpuHistograms[i].reset();
+		gpuHistograms[i].reset();
+	}
+	bufferHistogram.reset();
+	deadlineMisses = 0;
+}
+
+const char* getStageName(ProfileStage stage)
+{
+	switch (stage)
+	{
+	case STAGE_SIMULATE:	return "simulate";
+	case STAGE_HALO:		return "halo";
+	case STAGE_AUDIO_PASS:	return "audio-pass";
+	case STAGE_READBACK:	return "readback";
+	case STAGE_CONVERSION:	return "conversion";
+	case STAGE_SINK:		return "sink";
+	case STAGE_RENDER:		return "render";
+	default:				return "unknown";
+	}
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+///////////
+//DEFINES//
+///////////
+
+#define HISTOGRAM_BINS		256		//Log spaced bins - 4 per octave of nanoseconds, enough to cover any duration in a uint64.
+
+//Stages of the pipeline timed by the profiler//
+enum ProfileStage {
+	STAGE_SIMULATE,		//Solver time steps - CPU submission for GL backends.
+	STAGE_HALO,			//Copying tile edges into neighbouring halos - gl-tiled only.
+	STAGE_AUDIO_PASS,	//Copying the listener point into the audio row - gl-fbo below OpenGL 4.2 only.
+	STAGE_READBACK,		//Retrieving the audio buffer from the solver.
+	STAGE_CONVERSION,	//Scaling float samples to 16 bit.
+	STAGE_SINK,			//Handing the block to the audio thread.
+	STAGE_RENDER,		//Uploading and drawing a field snapshot.
+	NUM_OF_STAGES
+};
+
+//Clock used for every CPU stage - Monotonic, so the system clock being adjusted never shows up as a spike//
+typedef std::chrono::steady_clock ProfileClock;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+//StageHistogram - Lock free histogram of durations. Any thread records, any thread reads. Bins //
+//are log spaced so percentiles are accurate to a quarter octave whatever the duration.        //
+//////////////////////////////////////////////////////////////////////////////////////////////////
+class StageHistogram {
+private:
+	std::atomic<uint32_t> bins[HISTOGRAM_BINS];
+	std::atomic<uint64_t> count;
+	std::atomic<uint64_t> maximum;
+
+	static int getBin(uint64_t nanoseconds);
+	static uint64_t getBinUpperBound(int bin);
+
+public:
+	StageHistogram();
+
+	void record(uint64_t nanoseconds);
+	void reset();
+
+	uint64_t getCount() const;
+	uint64_t getMaximum() const;
+
+	//Duration below which the given fraction of records fall - Upper edge of the containing bin//
+	uint64_t getPercentile(double fraction) const;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+//Profiler - CPU and GPU histograms for every stage, plus deadline misses against the real-time //
+//budget of one audio buffer.                                                                   //
+//////////////////////////////////////////////////////////////////////////////////////////////////
+class Profiler {
+private:
+	StageHistogram cpuHistograms[NUM_OF_STAGES];
+	StageHistogram gpuHistograms[NUM_OF_STAGES];
+	StageHistogram bufferHistogram;		//Total work of each buffer - What is compared against the budget.
+	std::atomic<uint64_t> budget;		//Nanoseconds available to produce one buffer.
+	std::atomic<uint64_t> deadlineMisses;
+
+public:
+	Profiler();
+
+	//Real-time budget of one buffer - buffer_size / sampleRate seconds//
+	void setBudget(int bufferSize, int sampleRate);
+
+	void recordCPU(ProfileStage stage, uint64_t nanoseconds);
+	void recordGPU(ProfileStage stage, uint64_t nanoseconds);
+
+	//Total time spent producing one buffer - Counts a deadline miss when over budget//
+	void recordBuffer(uint64_t nanoseconds);
+
+	uint64_t getDeadlineMisses() const;
+	const StageHistogram& getCPUHistogram(ProfileStage stage) const;
+	const StageHistogram& getGPUHistogram(ProfileStage stage) const;
+
+	//Print p50/p99/max of every stage that has records//
+	void dump(std::ostream& stream) const;
+	void reset();
+};
+
+//////////////////////////////////////////////////////////////////////////
+//StageTimer - Measures from construction or start() until elapsed()//
+//////////////////////////////////////////////////////////////////////////
+class StageTimer {
+private:
+	ProfileClock::time_point begin;
+
+public:
+	StageTimer() : begin(ProfileClock::now()) {}
+
+	void start()
+	{
+		begin = ProfileClock::now();
+	}
+
+	uint64_t elapsed() const
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(ProfileClock::now() - begin).count();
+	}
+};
+
+const char* getStageName(ProfileStage stage);
+
+//Process wide profiler - Shared by the solvers and every thread of the pipeline//
+extern Profiler profiler;
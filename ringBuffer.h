@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////
+//RingBuffer - Lock free single producer, single consumer queue. The simulation thread//
+//pushes audio blocks and the audio thread pops them, neither ever waits on the other.//
+////////////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+class RingBuffer {
+private:
+	std::vector<T> buffer;
+	int capacity;
+	std::atomic<int> readIndex;		//Only advanced by the consumer.
+	std::atomic<int> writeIndex;	//Only advanced by the producer.
+
+public:
+	RingBuffer(int aCapacity) : buffer(aCapacity + 1), capacity(aCapacity + 1), readIndex(0), writeIndex(0) {}
+
+	//Number of elements ready to be popped//
+	int getReadAvailable() const
+	{
+		int available = writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_relaxed);
+		return available < 0 ? available + capacity : available;
+	}
+
+	//Number of elements that can be pushed without overwriting unread data//
+	int getWriteAvailable() const
+	{
+		int used = writeIndex.load(std::memory_order_relaxed) - readIndex.load(std::memory_order_acquire);
+		if (used < 0)
+			used += capacity;
+		return capacity - 1 - used;
+	}
+
+	//Producer side - Pushes as many of the elements as fit, returns the number pushed//
+	int push(const T* data, int count)
+	{
+		int write = writeIndex.load(std::memory_order_relaxed);
+		int available = getWriteAvailable();
+		if (count > available)
+			count = available;
+		for (int i = 0; i != count; ++i)
+		{
+			buffer[write] = data[i];
+			if (++write == capacity)
+				write = 0;
+		}
+		writeIndex.store(write, std::memory_order_release);
+		return count;
+	}
+
+	//Consumer side - Pops up to count elements, returns the number popped//
+	int pop(T* data, int count)
+	{
+		int read = readIndex.load(std::memory_order_relaxed);
+		int available = getReadAvailable();
+		if (count > available)
+			count = available;
+		for (int i = 0; i != count; ++i)
+		{
+			data[i] = buffer[read];
+			if (++read == capacity)
+				read = 0;
+		}
+		readIndex.store(read, std::memory_order_release);
+		return count;
+	}
+};
@@ -0,0 +1,98 @@
+#include "shaderProgram.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+bool loadShaderProgram(const char* vertexShaderPath, const char* fragmentShaderPath, GLuint& shaderProgram)
+{
+	//Load files source code//
+	std::string vertexSource;
+	std::string fragmentSource;
+	std::ifstream vShaderFile;
+	std::ifstream fShaderFile;
+
+	//Open files to ifstream//
+	vShaderFile.open(vertexShaderPath);
+	fShaderFile.open(fragmentShaderPath);
+
+	//Read file's buffer content into stream//
+	std::stringstream vShaderStream, fShaderStream;
+	vShaderStream << vShaderFile.rdbuf();
+	fShaderStream << fShaderFile.rdbuf();
+
+	//Close files//
+	vShaderFile.close();
+	fShaderFile.close();
+
+	//Convert stream to string//
+	vertexSource = vShaderStream.str();
+	fragmentSource = fShaderStream.str();
+
+	//Set source code in char* for opengl c use//
+	const char* vShaderCode = vertexSource.c_str();
+	const char* fShaderCode = fragmentSource.c_str();
+
+	//Compile vertex shader from source//
+	GLuint vertexShader;
+	vertexShader = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(vertexShader, 1, &vShaderCode, NULL);
+	glCompileShader(vertexShader);
+
+	//Compile fragment shader from source//
+	GLuint fragmentShader;
+	fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(fragmentShader, 1, &fShaderCode, NULL);
+	glCompileShader(fragmentShader);
+
+	//Create and link shaders into shader program//
+	shaderProgram = glCreateProgram();
+	glAttachShader(shaderProgram, vertexShader);
+	glAttachShader(shaderProgram, fragmentShader);
+	glLinkProgram(shaderProgram);
+
+	//Clean up shaders//
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	//Return status of new shader//
+	int status;
+	glGetProgramiv(shaderProgram, GL_LINK_STATUS, &status);
+	if (status == GL_FALSE)
+		return false;
+	return true;
+}
+
+bool loadComputeProgram(const char* computeShaderPath, GLuint& shaderProgram)
+{
+	//Load file source code//
+	std::ifstream cShaderFile;
+	cShaderFile.open(computeShaderPath);
+	std::stringstream cShaderStream;
+	cShaderStream << cShaderFile.rdbuf();
+	cShaderFile.close();
+
+	std::string computeSource = cShaderStream.str();
+	const char* cShaderCode = computeSource.c_str();
+
+	//Compile compute shader from source//
+	GLuint computeShader;
+	computeShader = glCreateShader(GL_COMPUTE_SHADER);
+	glShaderSource(computeShader, 1, &cShaderCode, NULL);
+	glCompileShader(computeShader);
+
+	//Create and link shader into shader program//
+	shaderProgram = glCreateProgram();
+	glAttachShader(shaderProgram, computeShader);
+	glLinkProgram(shaderProgram);
+
+	//Clean up shader//
+	glDeleteShader(computeShader);
+
+	//Return status of new shader//
+	int status;
+	glGetProgramiv(shaderProgram, GL_LINK_STATUS, &status);
+	if (status == GL_FALSE)
+		return false;
+	return true;
+}
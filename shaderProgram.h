@@ -0,0 +1,9 @@
+#pragma once
+
+#include <glad\glad.h>
+
+//OpenGL function to load specific text files into a OpenGL shader program//
+bool loadShaderProgram(const char* vertexShaderPath, const char* fragmentShaderPath, GLuint& shaderProgram);
+
+//OpenGL function to load a compute shader text file into a OpenGL shader program//
+bool loadComputeProgram(const char* computeShaderPath, GLuint& shaderProgram);
@@ -0,0 +1,77 @@
+#include "simdSolver.h"
+
+#ifdef SIMD_SOLVER_AVAILABLE
+#include <emmintrin.h>
+#include <cstring>
+#endif
+
+SIMDSolver::SIMDSolver(const SolverSettings& aSettings) : CPUSolver(aSettings)
+{
+}
+
+SIMDSolver::SIMDSolver(const SolverSettings& aSettings, const Domain& aDomain) : CPUSolver(aSettings, aDomain)
+{
+}
+
+const char* SIMDSolver::getName() const
+{
+	return "CPU SIMD";
+}
+
+void SIMDSolver::computeRows(const float* current, float* previous, int rowBegin, int rowEnd)
+{
+	computeRect(current, previous, rowBegin, rowEnd, 1, width - 1);
+}
+
+void SIMDSolver::computeRect(const float* current, float* previous, int rowBegin, int rowEnd, int xBegin, int xEnd)
+{
+#ifdef SIMD_SOLVER_AVAILABLE
+	const uint8_t* cellTypes = &domain.cellTypes[0];
+	const float* centre = &coefficients.centre[0];
+	const float* previousCoefficient = &coefficients.previous[0];
+	const float* neighbourCoefficient = &coefficients.neighbour[0];
+	const __m128i wallBit = _mm_set1_epi32(CELL_WALL);
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	for (int y = rowBegin; y != rowEnd; ++y)
+	{
+		int x = xBegin;
+		for (; x + 4 <= xEnd; x += 4)
+		{
+			int i = y * width + x;
+			__m128 p = _mm_loadu_ps(current + i);
+			__m128 p_prev = _mm_loadu_ps(previous + i);
+
+			//Neighbours [left, up, right, down] - Summed in the scalar kernel's mirror symmetric order//
+			const int offsets[4] = { -1, width, 1, -width };
+			__m128 pNeighbour[4];
+			for (int k = 0; k != 4; ++k)
+			{
+				__m128 neighbour = _mm_loadu_ps(current + i + offsets[k]);
+
+				//Widen 4 cell type bytes to 32 bit lanes, then select transmission per lane//
+				int32_t packedTypes;
+				memcpy(&packedTypes, cellTypes + i + offsets[k], sizeof(packedTypes));
+				__m128i types = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packedTypes), _mm_setzero_si128()), _mm_setzero_si128());
+				__m128 isWall = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(types, wallBit), wallBit));
+				__m128 isTransmissive = _mm_andnot_ps(isWall, one);
+
+				pNeighbour[k] = _mm_mul_ps(neighbour, isTransmissive);
+			}
+			__m128 pLRUD = _mm_add_ps(_mm_add_ps(pNeighbour[0], pNeighbour[2]), _mm_add_ps(pNeighbour[1], pNeighbour[3]));
+
+			//Assemble equation//
+			__m128 p_next = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(centre + i), p), _mm_mul_ps(_mm_loadu_ps(previousCoefficient + i), p_prev));
+			p_next = _mm_add_ps(p_next, _mm_mul_ps(_mm_loadu_ps(neighbourCoefficient + i), pLRUD));
+
+			_mm_storeu_ps(previous + i, p_next);
+		}
+
+		//Remaining cells that don't fill a vector//
+		computeSpan(current, previous, 0, y, x, xEnd);
+	}
+#else
+	for (int y = rowBegin; y != rowEnd; ++y)
+		computeSpan(current, previous, 0, y, xBegin, xEnd);
+#endif
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "cpuSolver.h"
+
+//SSE is part of every x86-64 target - Other architectures fall back to the scalar kernel//
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SOLVER_AVAILABLE	1
+#endif
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//SIMDSolver - CPUSolver with rows computed 4 cells at a time using SSE. Performs the    //
+//same operations in the same order as the scalar kernel, so results match it exactly.  //
+///////////////////////////////////////////////////////////////////////////////////////////
+class SIMDSolver : public CPUSolver {
+protected:
+	void computeRows(const float* current, float* previous, int rowBegin, int rowEnd);
+
+	//Compute next timestep of cells [xBegin, xEnd) of rows [rowBegin, rowEnd) - Interior cells only//
+	void computeRect(const float* current, float* previous, int rowBegin, int rowEnd, int xBegin, int xEnd);
+
+	//Step a domain built elsewhere, as CPUSolver//
+	SIMDSolver(const SolverSettings& aSettings, const Domain& aDomain);
+
+public:
+	SIMDSolver(const SolverSettings& aSettings);
+
+	const char* getName() const;
+};
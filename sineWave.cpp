@@ -17,4 +17,12 @@ bool SineWaveExcitor::isExcitation()
 	if (index > 50)
 		return false;
 	return true;
+}
+int SineWaveExcitor::getIndex()
+{
+	return index;
+}
+void SineWaveExcitor::setIndex(int aIndex)
+{
+	index = aIndex;
 }
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+
+#include "precision.h"
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//Solver - Common interface of every FDTD backend. A backend owns the model state, advances//
+//it one sample at a time and returns the listener point as a stream of audio samples.     //
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+//Static description of the model handed to a backend on creation//
+struct SolverSettings {
+	int domainSize[2] = { 40, 40 };				//Number of simulation points in x and y.
+	int listenerPosition[2] = { 5, 5 };			//Cell coordinates of the audio sampling point.
+	float excitationPosition[2] = { 0.7f, 0.5f };	//Normalised domain coordinates [0-1] of the excitation point.
+	int domainDepth = 1;						//Number of simulation points in z - Above 1 extrudes the drum into a room between a floor and ceiling, see VolumeSolver - Needs isVolumeSupported().
+	int listenerLayer = 0;						//z cell of the audio sampling point in a volume.
+	float excitationLayer = 0.5f;				//Normalised z [0-1] of the excitation point in a volume.
+	int numStrings = 0;							//Above 0 replaces the drum with a bank of 1D strings up to domainSize[0] cells long, see StringBankSolver - Needs isStringBankSupported().
+	float plateStiffness = 0.0f;				//Above 0 makes the drum a stiff plate, see PlateSolver - Squared stiffness per output sample, propagation + 8 * stiffness must be <= 0.5. Needs isPlateSupported().
+	float propagationFactor = 0.5f;				//Combines spatial scale and speed in the medium - Must be <= 0.5.
+	float dampingFactor = 0.0005f;				//The higher the quicker the damping. Typically way below 1.
+	float boundaryGain = 1.0f;					//1 for fully clamped, 0 for free.
+	StoragePrecision storagePrecision = PRECISION_FP32;	//Format pressure is stored in between steps - See isPrecisionSupported().
+	std::string domainShape;					//Shape description of the drum, see domainBuilder.h - Empty for the full rectangle.
+	std::string materialMap;					//Per cell material over the uniform factors above, see domainBuilder.h - Empty for uniform.
+	bool isAbsorbingEdges = false;				//Let waves out through the grid's outer ring with a first order Engquist-Majda condition rather than reflect them.
+	int spongeLayer = 0;						//Cells of graded damping along each edge of the grid, soaking up what the edges still reflect - 0 for none.
+	float silenceFloor = 0.0f;					//Field energy below which the solver parks until the next event, see ParkedSolver - 0 never parks.
+	bool isFoldingSymmetry = true;				//Step only a half or quarter of a mirror symmetric drum struck on its axis, see SymmetricSolver - cpu-simd and cpu-threaded.
+	bool isTrackingActiveTiles = false;			//Only step tiles a disturbance has reached, see ActiveTileSolver - Needs isActiveTilingSupported().
+	bool isUpdatingInPlace = false;			//Overwrite previous pressure with next in a single pair of planes, see InPlaceGLSolver - Needs isInPlaceSupported().
+	int textureTileSize = 0;					//Interior cells per side of gl-tiled's textures - 0 for the largest the GPU holds.
+	int oversampling = 1;						//Solver steps per output sample, see applyStabilityGuard() - Material above is per output sample and scaled to the step rate.
+};
+
+class Solver {
+public:
+	virtual ~Solver() {}
+
+	//Human readable name of the backend - Used in logs and benchmark output//
+	virtual const char* getName() const = 0;
+
+	//Advance the model numSamples time steps. excitation holds the excitation magnitude for each step, output receives the listener sample of each step//
+	virtual void process(const float* excitation, float* output, int numSamples) = 0;
+
+	//Move the excitation point - Normalised domain coordinates [0-1]//
+	virtual void setExcitationPosition(float x, float y) = 0;
+
+	//Slide the excitation and listener over the steps of the next process() call - 2 floats [x, y] per step in fractional cells, whole numbers at cell centres.//
+	//Each step reads and writes the 4 cells around its point through a CellProbe. Both probes rest at their path's last point afterwards and NULL leaves one resting//
+	//where it is - Ignored unless isProbePathFollowed()//
+	virtual void setProbePaths(const float* excitationPath, const float* listenerPath) { (void)excitationPath; (void)listenerPath; }
+
+	//Whether setProbePaths() is followed - False for backends whose probes are fixed whole cells, see isProbePathSupported()//
+	virtual bool isProbePathFollowed() const { return false; }
+
+	//Change the uniform material while running - Glided over the following steps by a MaterialRamp, material maps keeping their shape//
+	virtual void setMaterial(float propagation, float damping, float boundaryGain) = 0;
+
+	//Field energy metric of the latest timestep, see computeFieldEnergy() - Reduced on demand, so call it per block at most//
+	virtual double getEnergy() = 0;
+
+	//Copy the latest timestep in render layout - 4 floats per cell [pressure, previous pressure, transmission, CELL_ type bits], row major from bottom row//
+	virtual void getField(float* field) = 0;
+
+	//Replace the model state with a field in getField() layout - Cell types are taken from the type bits, transmission is ignored//
+	virtual void setField(const float* field) = 0;
+};
@@ -0,0 +1,217 @@
+#include "solverFactory.h"
+
+#include <cstring>
+
+#include "glSolver.h"
+#include "computeSolver.h"
+#include "tiledGLSolver.h"
+#include "inPlaceGLSolver.h"
+#include "cpuSolver.h"
+#include "simdSolver.h"
+#include "activeTileSolver.h"
+#include "threadedSolver.h"
+#include "packedSolver.h"
+#include "sparseSolver.h"
+#include "volumeSolver.h"
+#include "stringBankSolver.h"
+#include "plateSolver.h"
+#include "kSpaceSolver.h"
+#include "symmetricSolver.h"
+#include "oversampledSolver.h"
+#include "parkedSolver.h"
+
+const char* getBackendName(SolverBackend backend)
+{
+	switch (backend)
+	{
+	case BACKEND_GL_FBO:		return "gl-fbo";
+	case BACKEND_GL_COMPUTE:	return "gl-compute";
+	case BACKEND_CPU_SCALAR:	return "cpu-scalar";
+	case BACKEND_CPU_SIMD:		return "cpu-simd";
+	case BACKEND_CPU_THREADED:	return "cpu-threaded";
+	case BACKEND_CPU_SPARSE:	return "cpu-sparse";
+	case BACKEND_GL_TILED:		return "gl-tiled";
+	case BACKEND_CPU_KSPACE:	return "cpu-kspace";
+	default:					return "unknown";
+	}
+}
+
+SolverBackend findBackend(const char* name)
+{
+	for (int i = 0; i != NUM_OF_BACKENDS; ++i)
+	{
+		if (strcmp(name, getBackendName((SolverBackend)i)) == 0)
+			return (SolverBackend)i;
+	}
+	return NUM_OF_BACKENDS;
+}
+
+bool isGLBackend(SolverBackend backend)
+{
+	return backend == BACKEND_GL_FBO || backend == BACKEND_GL_COMPUTE || backend == BACKEND_GL_TILED;
+}
+
+bool isPrecisionSupported(SolverBackend backend, StoragePrecision precision)
+{
+	switch (precision)
+	{
+	case PRECISION_FP32:	return true;
+	case PRECISION_FP16:	return backend == BACKEND_GL_FBO || backend == BACKEND_CPU_SCALAR;
+	case PRECISION_BF16:
+	case PRECISION_Q15:		return backend == BACKEND_CPU_SCALAR;
+	default:				return false;
+	}
+}
+
+bool isActiveTilingSupported(SolverBackend backend)
+{
+	return backend == BACKEND_CPU_SIMD || backend == BACKEND_GL_COMPUTE;
+}
+
+bool isVolumeSupported(SolverBackend backend)
+{
+	return backend == BACKEND_CPU_SIMD || backend == BACKEND_CPU_THREADED;
+}
+
+bool isStringBankSupported(SolverBackend backend)
+{
+	return backend == BACKEND_CPU_SIMD;
+}
+
+bool isPlateSupported(SolverBackend backend)
+{
+	return backend == BACKEND_CPU_SIMD || backend == BACKEND_CPU_THREADED;
+}
+
+bool isProbePathSupported(SolverBackend backend)
+{
+	return backend == BACKEND_CPU_SCALAR || backend == BACKEND_CPU_SIMD || backend == BACKEND_CPU_THREADED;
+}
+
+bool isInPlaceSupported(SolverBackend backend, StoragePrecision precision)
+{
+	if (backend == BACKEND_GL_FBO)
+		return precision == PRECISION_FP32;
+	return backend != BACKEND_GL_TILED;
+}
+
+//Backend stepping at settings' step rate//
+static Solver* createBackend(SolverBackend backend, const SolverSettings& settings)
+{
+	switch (backend)
+	{
+	case BACKEND_GL_FBO:
+	{
+		//Image load/store into an attachmentless framebuffer needs OpenGL 4.3//
+		if (settings.isUpdatingInPlace)
+		{
+			if (!GLAD_GL_VERSION_4_3)
+				return NULL;
+			InPlaceGLSolver* solver = new InPlaceGLSolver(settings);
+			if (solver->isValid())
+				return solver;
+			delete solver;
+			return NULL;
+		}
+		GLSolver* solver = new GLSolver(settings);
+		if (solver->isValid())
+			return solver;
+		delete solver;
+		return NULL;
+	}
+	case BACKEND_GL_COMPUTE:
+	{
+		//Compute shaders arrived in OpenGL 4.3//
+		if (!GLAD_GL_VERSION_4_3)
+			return NULL;
+		ComputeSolver* solver = new ComputeSolver(settings);
+		if (solver->isValid())
+			return solver;
+		delete solver;
+		return NULL;
+	}
+	case BACKEND_CPU_SCALAR:
+		if (settings.storagePrecision != PRECISION_FP32)
+			return new PackedSolver(settings);
+		return new CPUSolver(settings);
+	case BACKEND_CPU_SIMD:
+		if (settings.numStrings > 0)
+			return new StringBankSolver(settings);
+		if (settings.domainDepth > 1)
+			return new VolumeSolver(settings, 1);
+		if (settings.plateStiffness > 0.0f)
+			return new PlateSolver(settings, 1);
+#ifdef SIMD_SOLVER_AVAILABLE
+		if (settings.isTrackingActiveTiles)
+			return new ActiveTileSolver(settings);
+		if (settings.isFoldingSymmetry)
+		{
+			Solver* solver = createSymmetricSolver(settings, 1, [backend](const SolverSettings& unfolded) { return createBackend(backend, unfolded); });
+			if (solver != NULL)
+				return solver;
+		}
+		return new SIMDSolver(settings);
+#else
+		return NULL;
+#endif
+	case BACKEND_CPU_THREADED:
+		if (settings.domainDepth > 1)
+			return new VolumeSolver(settings, 0);
+		if (settings.plateStiffness > 0.0f)
+			return new PlateSolver(settings, 0);
+		if (settings.isFoldingSymmetry)
+		{
+			Solver* solver = createSymmetricSolver(settings, 0, [backend](const SolverSettings& unfolded) { return createBackend(backend, unfolded); });
+			if (solver != NULL)
+				return solver;
+		}
+		return new ThreadedSolver(settings);
+	case BACKEND_CPU_SPARSE:
+		return new SparseSolver(settings);
+	case BACKEND_GL_TILED:
+	{
+		//Halo exchange copies with glCopyImageSubData, also 4.3//
+		if (!GLAD_GL_VERSION_4_3)
+			return NULL;
+		TiledGLSolver* solver = new TiledGLSolver(settings);
+		if (solver->isValid())
+			return solver;
+		delete solver;
+		return NULL;
+	}
+	case BACKEND_CPU_KSPACE:
+		//Sine and cosine modes only diagonalise the Laplacian of the full rectangle, uniform, with walls that clamp or mirror fully//
+		if (!settings.domainShape.empty() || !settings.materialMap.empty() || settings.isAbsorbingEdges || settings.spongeLayer > 0 || (settings.boundaryGain != 0.0f && settings.boundaryGain != 1.0f))
+			return NULL;
+		return new KSpaceSolver(settings);
+	default:
+		return NULL;
+	}
+}
+
+Solver* createSolver(SolverBackend backend, const SolverSettings& settings)
+{
+	if (!isPrecisionSupported(backend, settings.storagePrecision))
+		return NULL;
+	if (settings.isTrackingActiveTiles && !isActiveTilingSupported(backend))
+		return NULL;
+	if (settings.isUpdatingInPlace && !isInPlaceSupported(backend, settings.storagePrecision))
+		return NULL;
+	if (settings.domainDepth > 1 && (!isVolumeSupported(backend) || settings.isTrackingActiveTiles))
+		return NULL;
+	if (settings.numStrings > 0 && (!isStringBankSupported(backend) || settings.isTrackingActiveTiles || settings.domainDepth > 1))
+		return NULL;
+	if (settings.plateStiffness > 0.0f && (!isPlateSupported(backend) || settings.isTrackingActiveTiles || settings.domainDepth > 1 || settings.numStrings > 0))
+		return NULL;
+
+	Solver* solver = createBackend(backend, settings);
+	if (solver == NULL)
+		return NULL;
+	if (settings.oversampling > 1)
+		solver = new OversampledSolver(solver, settings.oversampling);
+
+	//Outermost, so a parked block skips decimation too//
+	if (settings.silenceFloor > 0.0f)
+		solver = new ParkedSolver(solver, settings.silenceFloor);
+	return solver;
+}
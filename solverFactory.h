@@ -0,0 +1,50 @@
+#pragma once
+
+#include "solver.h"
+
+//Every solver backend - GL backends need a current OpenGL context on the creating thread//
+enum SolverBackend {
+	BACKEND_GL_FBO,			//Fragment shader ping-ponging between two texture quads.
+	BACKEND_GL_COMPUTE,		//Compute shader over storage buffers.
+	BACKEND_CPU_SCALAR,		//Reference CPU implementation.
+	BACKEND_CPU_SIMD,		//SSE vectorised CPU implementation.
+	BACKEND_CPU_THREADED,	//SSE vectorised rows split across threads.
+	BACKEND_CPU_SPARSE,		//Scalar update of a Morton ordered list of non wall cells.
+	BACKEND_GL_TILED,		//Fragment shader over several textures with halo exchange - Domains past the largest texture.
+	BACKEND_CPU_KSPACE,		//Pseudo-spectral update of the rectangle's standing wave modes - Uniform material, boundary gain 0 or 1.
+	NUM_OF_BACKENDS
+};
+
+//Short name used on the command line and in benchmark results//
+const char* getBackendName(SolverBackend backend);
+
+//Parse a short name - Returns NUM_OF_BACKENDS if unknown//
+SolverBackend findBackend(const char* name);
+
+bool isGLBackend(SolverBackend backend);
+
+//fp32 is supported everywhere, fp16 also by the fbo texture, and every 16 bit precision by the scalar CPU backend//
+bool isPrecisionSupported(SolverBackend backend, StoragePrecision precision);
+
+//Stepping only the tiles a disturbance has reached is implemented by the SIMD CPU backend and the compute shader//
+bool isActiveTilingSupported(SolverBackend backend);
+
+//Every CPU backend and the compute shader always update a single pair of planes in place - The fbo texture does so with image load/store in fp32//
+bool isInPlaceSupported(SolverBackend backend, StoragePrecision precision);
+
+//Volumes are stepped by the SIMD CPU backend on one thread and by the threaded one on all of them - Without active tiles//
+bool isVolumeSupported(SolverBackend backend);
+
+//Banks of 1D strings are swept by the SIMD CPU backend - Without active tiles or volumes//
+bool isStringBankSupported(SolverBackend backend);
+
+//Stiff plates are stepped by the SIMD CPU backend on one thread and by the threaded one on all of them - Without active tiles, volumes or string banks//
+bool isPlateSupported(SolverBackend backend);
+
+//Probes sliding along per step paths, see Solver::setProbePaths(), are followed by the scalar, SIMD and threaded CPU backends in every precision, with active tiles and plates - Not in volumes or string banks//
+bool isProbePathSupported(SolverBackend backend);
+
+//Create a solver - Returns NULL if the backend is unavailable on this machine, doesn't support the storage precision, active tiles, in place updates, volumes, string banks or plates, or failed to initialise//
+//cpu-kspace also needs the full rectangle of uniform material without absorbing edges or a sponge layer, with a boundary gain of 0 or 1//
+//Settings with oversampling above 1 are wrapped in an OversampledSolver, so output stays at the sample rate//
+Solver* createSolver(SolverBackend backend, const SolverSettings& settings);
@@ -0,0 +1,241 @@
+#include "sparseSolver.h"
+
+#include <algorithm>
+
+#include "domainBuilder.h"
+#include "profiler.h"
+#include "tracer.h"
+
+//Interleave the bits of x and y, x in the even bits - Grids up to 65536 cells a side//
+static uint32_t encodeMorton(uint32_t x, uint32_t y)
+{
+	x = (x | (x << 8)) & 0x00FF00FF;
+	x = (x | (x << 4)) & 0x0F0F0F0F;
+	x = (x | (x << 2)) & 0x33333333;
+	x = (x | (x << 1)) & 0x55555555;
+	y = (y | (y << 8)) & 0x00FF00FF;
+	y = (y | (y << 4)) & 0x0F0F0F0F;
+	y = (y | (y << 2)) & 0x33333333;
+	y = (y | (y << 1)) & 0x55555555;
+	return x | (y << 1);
+}
+
+static uint32_t compactMortonBits(uint32_t bits)
+{
+	bits &= 0x55555555;
+	bits = (bits | (bits >> 1)) & 0x33333333;
+	bits = (bits | (bits >> 2)) & 0x0F0F0F0F;
+	bits = (bits | (bits >> 4)) & 0x00FF00FF;
+	bits = (bits | (bits >> 8)) & 0x0000FFFF;
+	return bits;
+}
+
+SparseSolver::SparseSolver(const SolverSettings& aSettings) : settings(aSettings), materialRamp(aSettings)
+{
+	width = settings.domainSize[0];
+	height = settings.domainSize[1];
+	domain = buildDomain(settings);
+	domain.cellTypes[settings.listenerPosition[1] * width + settings.listenerPosition[0]] |= CELL_LISTENER;
+
+	buildCellList();
+	setExcitationPosition(settings.excitationPosition[0], settings.excitationPosition[1]);
+}
+
+const char* SparseSolver::getName() const
+{
+	return "CPU sparse";
+}
+
+void SparseSolver::buildCellList()
+{
+	//Interior non wall cells are updated, outer ring ones only read//
+	std::vector<uint32_t> ringKeys;
+	cellKeys.clear();
+	for (int y = 0; y != height; ++y)
+	{
+		for (int x = 0; x != width; ++x)
+		{
+			if (domain.cellTypes[y * width + x] & CELL_WALL)
+				continue;
+			bool isInterior = x > 0 && x < width - 1 && y > 0 && y < height - 1;
+			(isInterior ? cellKeys : ringKeys).push_back(encodeMorton(x, y));
+		}
+	}
+	std::sort(cellKeys.begin(), cellKeys.end());
+	std::sort(ringKeys.begin(), ringKeys.end());
+	numUpdatedCells = (int)cellKeys.size();
+	cellKeys.insert(cellKeys.end(), ringKeys.begin(), ringKeys.end());
+
+	//Grid to list lookup, only needed while resolving neighbours//
+	std::vector<int32_t> gridToCell(width * height, -1);
+	for (size_t c = 0; c != cellKeys.size(); ++c)
+		gridToCell[compactMortonBits(cellKeys[c] >> 1) * width + compactMortonBits(cellKeys[c])] = (int32_t)c;
+
+	//Neighbours in the scalar kernel's order [left, up, right, down]//
+	int zeroCell = (int)cellKeys.size();
+	const int offsets[4] = { -1, width, 1, -width };
+	neighbours.resize(numUpdatedCells * 4);
+	for (int c = 0; c != numUpdatedCells; ++c)
+	{
+		int i = compactMortonBits(cellKeys[c] >> 1) * width + compactMortonBits(cellKeys[c]);
+		for (int k = 0; k != 4; ++k)
+			neighbours[c * 4 + k] = (domain.cellTypes[i + offsets[k]] & CELL_WALL) ? zeroCell : gridToCell[i + offsets[k]];
+	}
+	gatherCoefficients();
+
+	pressure[0].assign(zeroCell + 1, 0.0f);
+	pressure[1].assign(zeroCell + 1, 0.0f);
+	listenerCell = findCell(settings.listenerPosition[0], settings.listenerPosition[1]);
+}
+
+void SparseSolver::gatherCoefficients()
+{
+	computeUpdateCoefficients(domain, materialRamp.getOffset(), gridCoefficients);
+	coefficients.centre.resize(numUpdatedCells);
+	coefficients.previous.resize(numUpdatedCells);
+	coefficients.neighbour.resize(numUpdatedCells);
+	for (int c = 0; c != numUpdatedCells; ++c)
+	{
+		int i = compactMortonBits(cellKeys[c] >> 1) * width + compactMortonBits(cellKeys[c]);
+		coefficients.centre[c] = gridCoefficients.centre[i];
+		coefficients.previous[c] = gridCoefficients.previous[i];
+		coefficients.neighbour[c] = gridCoefficients.neighbour[i];
+	}
+}
+
+int SparseSolver::findCell(int x, int y) const
+{
+	uint32_t key = encodeMorton(x, y);
+
+	//Each part of the list is sorted separately//
+	std::vector<uint32_t>::const_iterator parts[3] = { cellKeys.begin(), cellKeys.begin() + numUpdatedCells, cellKeys.end() };
+	for (int part = 0; part != 2; ++part)
+	{
+		std::vector<uint32_t>::const_iterator found = std::lower_bound(parts[part], parts[part + 1], key);
+		if (found != parts[part + 1] && *found == key)
+			return (int)(found - cellKeys.begin());
+	}
+	return -1;
+}
+
+void SparseSolver::process(const float* excitation, float* output, int numSamples)
+{
+	StageTimer simulateStageTimer;
+	TRACE_SCOPE("simulate");
+
+	int n = 0;
+	while (n != numSamples)
+	{
+		bool isChanged;
+		int segmentEnd = n + materialRamp.advance(numSamples - n, isChanged);
+		if (isChanged)
+			gatherCoefficients();
+
+		const float* centre = coefficients.centre.data();
+		const float* previousCoefficient = coefficients.previous.data();
+		const float* neighbourCoefficient = coefficients.neighbour.data();
+
+		for (; n != segmentEnd; ++n)
+		{
+			const float* current = pressure[currentPlane].data();
+			float* next = pressure[1 - currentPlane].data();
+
+			for (int c = 0; c != numUpdatedCells; ++c)
+			{
+				const int32_t* neighbour = &neighbours[c * 4];
+				float p = current[c];
+				float p_prev = next[c];
+
+				//Wall neighbours read the zero cell, as their reflections are in the centre coefficient - Same sum order as computeSpan()//
+				float pLRUD = (current[neighbour[0]] + current[neighbour[2]]) + (current[neighbour[1]] + current[neighbour[3]]);
+
+				//Assemble equation//
+				float p_next = centre[c] * p + previousCoefficient[c] * p_prev;
+				p_next += neighbourCoefficient[c] * pLRUD;
+
+				next[c] = p_next;
+			}
+
+			if (excitationCell >= 0)
+				next[excitationCell] += excitation[n];
+			output[n] = listenerCell >= 0 ? next[listenerCell] : 0.0f;
+
+			currentPlane = 1 - currentPlane;
+		}
+	}
+
+	profiler.recordCPU(STAGE_SIMULATE, simulateStageTimer.elapsed());
+}
+
+void SparseSolver::setExcitationPosition(float x, float y)
+{
+	excitationPosition[0] = std::min(std::max((int)(x * width), 0), width - 1);
+	excitationPosition[1] = std::min(std::max((int)(y * height), 0), height - 1);
+	excitationCell = findCell(excitationPosition[0], excitationPosition[1]);
+}
+
+void SparseSolver::setMaterial(float propagation, float damping, float boundaryGain)
+{
+	materialRamp.setTarget(propagation, damping, boundaryGain);
+}
+
+double SparseSolver::getEnergy()
+{
+	//Same terms as computeFieldEnergy() - Walls read the zero cell and outer ring cells follow the updated ones, so both are skipped by index//
+	const float* current = pressure[currentPlane].data();
+	const float* previous = pressure[1 - currentPlane].data();
+	double energy = 0.0;
+	for (int c = 0; c != numUpdatedCells; ++c)
+	{
+		double velocity = current[c] - previous[c];
+		energy += velocity * velocity;
+
+		//Right and up neighbours//
+		for (int k = 1; k != 3; ++k)
+		{
+			int32_t neighbour = neighbours[c * 4 + k];
+			if (neighbour < numUpdatedCells)
+				energy += (double)(current[neighbour] - current[c]) * (current[neighbour] - current[c]);
+		}
+	}
+	return energy;
+}
+
+void SparseSolver::getField(float* field)
+{
+	for (int i = 0; i != width * height; ++i)
+	{
+		field[i * 4 + 0] = 0;
+		field[i * 4 + 1] = 0;
+		field[i * 4 + 2] = getTransmission(domain.cellTypes[i]);
+		field[i * 4 + 3] = domain.cellTypes[i];
+	}
+
+	for (size_t c = 0; c != cellKeys.size(); ++c)
+	{
+		int i = compactMortonBits(cellKeys[c] >> 1) * width + compactMortonBits(cellKeys[c]);
+		field[i * 4 + 0] = pressure[currentPlane][c];
+		field[i * 4 + 1] = pressure[1 - currentPlane][c];
+	}
+}
+
+void SparseSolver::setField(const float* field)
+{
+	//Cell types may differ from the current list's//
+	for (int i = 0; i != width * height; ++i)
+		domain.cellTypes[i] = (uint8_t)field[i * 4 + 3];
+	buildCellList();
+
+	for (size_t c = 0; c != cellKeys.size(); ++c)
+	{
+		int i = compactMortonBits(cellKeys[c] >> 1) * width + compactMortonBits(cellKeys[c]);
+		pressure[currentPlane][c] = field[i * 4 + 0];
+		pressure[1 - currentPlane][c] = field[i * 4 + 1];
+	}
+	excitationCell = findCell(excitationPosition[0], excitationPosition[1]);
+}
+
+int SparseSolver::getNumCells() const
+{
+	return (int)cellKeys.size();
+}
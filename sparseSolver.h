@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "solver.h"
+#include "domain.h"
+#include "materialRamp.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//SparseSolver - Scalar update over a list of the grid's non wall cells only, so memory and //
+//work per step scale with the drum's area rather than its bounding box. Cells are stored   //
+//in Morton order, keeping 2D neighbours close in memory, with their neighbours' list       //
+//indices and update coefficients precomputed. Bit exact with cpu-scalar.                   //
+//Wall cells hold no pressure - getField() reports them as 0.                               //
+//////////////////////////////////////////////////////////////////////////////////////////////
+class SparseSolver : public Solver {
+private:
+	SolverSettings settings;
+	Domain domain;
+	int width;
+	int height;
+
+	//Cell list - Updated cells first, then non wall outer ring cells, which neighbours read but are never updated//
+	std::vector<uint32_t> cellKeys;		//Morton key of each cell, ascending within each part of the list.
+	std::vector<int32_t> neighbours;	//4 list indices per updated cell [left, up, right, down] - The zero cell for walls.
+	UpdateCoefficients coefficients;	//Per updated cell, in list order.
+	UpdateCoefficients gridCoefficients;	//Per grid cell, gathered into coefficients.
+	MaterialRamp materialRamp;
+	int numUpdatedCells = 0;
+
+	std::vector<float> pressure[2];		//Pressure of each listed cell, then a zero cell walls read - Alternately hold timestep n & n-1.
+	int currentPlane = 0;
+	int excitationPosition[2];			//Grid cell of the excitation, kept to find it again when the list is rebuilt.
+	int excitationCell = -1;			//List indices - -1 on a wall, where excitation is lost and the listener silent.
+	int listenerCell = -1;
+
+	//List index of a grid cell - -1 for walls//
+	int findCell(int x, int y) const;
+
+	//Rebuild the cell list from domain - Pressure starts at rest//
+	void buildCellList();
+
+	//Recompute coefficients for the current material and gather them into list order//
+	void gatherCoefficients();
+
+public:
+	SparseSolver(const SolverSettings& aSettings);
+
+	const char* getName() const;
+	void process(const float* excitation, float* output, int numSamples);
+	void setExcitationPosition(float x, float y);
+	void setMaterial(float propagation, float damping, float boundaryGain);
+	double getEnergy();
+	void getField(float* field);
+	void setField(const float* field);
+
+	//Listed cells against the width * height bounding box//
+	int getNumCells() const;
+};
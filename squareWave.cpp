@@ -18,4 +18,11 @@ bool SquareWaveExcitor::isExcitation()
 		return false;
 	return true;
 }
-
+int SquareWaveExcitor::getIndex()
+{
+	return index;
+}
+void SquareWaveExcitor::setIndex(int aIndex)
+{
+	index = aIndex;
+}
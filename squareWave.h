@@ -9,4 +9,6 @@ public:
 	float getNextSample();
 	void resetExcitation();
 	bool isExcitation();
+	int getIndex();
+	void setIndex(int aIndex);
 };
\ No newline at end of file
@@ -0,0 +1,288 @@
+#include "stringBankSolver.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "simdSolver.h"		//SIMD_SOLVER_AVAILABLE.
+#include "domain.h"
+#include "profiler.h"
+#include "tracer.h"
+
+#ifdef SIMD_SOLVER_AVAILABLE
+#include <emmintrin.h>
+#endif
+
+std::vector<StringSettings> buildStringBank(const SolverSettings& settings)
+{
+	std::vector<StringSettings> strings(std::max(settings.numStrings, 0));
+	int longest = std::max(settings.domainSize[0] - 2, MIN_STRING_LENGTH);
+	for (size_t s = 0; s != strings.size(); ++s)
+	{
+		StringSettings& string = strings[s];
+		string.length = std::max((int)std::lround(longest * std::pow(2.0, -(double)(s % STRING_BANK_SPAN) / 12.0)), MIN_STRING_LENGTH);
+		string.propagation = settings.propagationFactor;
+		string.damping = settings.dampingFactor;
+		string.boundaryGain = settings.boundaryGain;
+		string.excitationPosition = settings.excitationPosition[0];
+		string.listenerPosition = (float)settings.listenerPosition[0] / (float)settings.domainSize[0];
+		string.gain = 1.0f / (float)strings.size();
+	}
+	return strings;
+}
+
+StringBankSolver::StringBankSolver(const SolverSettings& aSettings) : StringBankSolver(aSettings, buildStringBank(aSettings))
+{
+}
+
+StringBankSolver::StringBankSolver(const SolverSettings& aSettings, const std::vector<StringSettings>& aStrings) : settings(aSettings), strings(aStrings), materialRamp(aSettings)
+{
+	numStrings = (int)strings.size();
+
+	//Strings of similar length share a group, so little of a sweep is padding//
+	std::vector<int> order(numStrings);
+	for (int s = 0; s != numStrings; ++s)
+		order[s] = s;
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return strings[a].length > strings[b].length; });
+
+	stringBase.resize(numStrings);
+	groupBegin.push_back(0);
+	for (int first = 0; first < numStrings; first += 4)
+	{
+		for (int lane = 0; lane != 4 && first + lane < numStrings; ++lane)
+			stringBase[order[first + lane]] = groupBegin.back() + lane;
+		int groupCells = strings[order[first]].length + 2;	//Longest of the group, plus both end walls.
+		groupBegin.push_back(groupBegin.back() + groupCells * 4);
+	}
+
+	pressure[0].assign(groupBegin.back(), 0.0f);
+	pressure[1].assign(groupBegin.back(), 0.0f);
+	pendingStrikes.assign(numStrings, 0.0f);
+	computeCoefficients(MaterialOffset());
+
+	//Listener cell of each string - Clamped inside the string, so never the end walls//
+	listenerIndices.resize(numStrings);
+	for (int s = 0; s != numStrings; ++s)
+	{
+		int cell = 1 + std::min(std::max((int)(strings[s].listenerPosition * strings[s].length), 0), strings[s].length - 1);
+		listenerIndices[s] = stringBase[s] + cell * 4;
+	}
+
+	excitationIndices.resize(numStrings);
+	for (int s = 0; s != numStrings; ++s)
+	{
+		int cell = 1 + std::min(std::max((int)(strings[s].excitationPosition * strings[s].length), 0), strings[s].length - 1);
+		excitationIndices[s] = stringBase[s] + cell * 4;
+	}
+}
+
+const char* StringBankSolver::getName() const
+{
+	return "CPU string bank";
+}
+
+void StringBankSolver::computeCoefficients(const MaterialOffset& offset)
+{
+	centre.assign(groupBegin.back(), 0.0f);
+	previousCoefficient.assign(groupBegin.back(), 0.0f);
+	neighbourCoefficient.assign(groupBegin.back(), 0.0f);
+
+	//Material is given per output sample - Scaled to the step rate as buildDomain() scales a membrane's//
+	double propagationScale = 1.0 / (double)(settings.oversampling * settings.oversampling);
+	double dampingScale = 1.0 / (double)settings.oversampling;
+	for (int s = 0; s != numStrings; ++s)
+	{
+		const StringSettings& string = strings[s];
+		double prop = std::min(std::max(string.propagation * propagationScale + offset.propagation, 0.0), (double)CFL_LIMIT_1D);
+		double damp = std::max(string.damping * dampingScale + offset.damping, 0.0);
+		double gain = string.boundaryGain + offset.boundaryGain;
+		for (int j = 1; j <= string.length; ++j)
+		{
+			//Cells next to an end reflect their own pressure back off it, as off a membrane's walls//
+			double reflection = (j == 1 ? gain : 0.0) + (j == string.length ? gain : 0.0);
+			int i = stringBase[s] + j * 4;
+			centre[i] = (float)((2.0 - 2.0 * prop + prop * reflection) / (1.0 + damp));
+			previousCoefficient[i] = (float)((damp - 1.0) / (1.0 + damp));
+			neighbourCoefficient[i] = (float)(prop / (1.0 + damp));
+		}
+	}
+}
+
+void StringBankSolver::computeStep(const float* current, float* previous)
+{
+	//Walls and padding hold zero pressure forever, so neighbours need no transmission mask//
+	for (size_t group = 0; group + 1 < groupBegin.size(); ++group)
+	{
+		//Every cell of the group between its end walls - Neighbours along a string are a vector apart//
+		int begin = groupBegin[group] + 4;
+		int end = groupBegin[group + 1] - 4;
+#ifdef SIMD_SOLVER_AVAILABLE
+		for (int i = begin; i != end; i += 4)
+		{
+			__m128 p = _mm_loadu_ps(current + i);
+			__m128 p_prev = _mm_loadu_ps(previous + i);
+			__m128 pNeighbours = _mm_add_ps(_mm_loadu_ps(current + i - 4), _mm_loadu_ps(current + i + 4));
+
+			__m128 p_next = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&centre[i]), p), _mm_mul_ps(_mm_loadu_ps(&previousCoefficient[i]), p_prev));
+			p_next = _mm_add_ps(p_next, _mm_mul_ps(_mm_loadu_ps(&neighbourCoefficient[i]), pNeighbours));
+
+			_mm_storeu_ps(previous + i, p_next);
+		}
+#else
+		for (int i = begin; i != end; ++i)
+		{
+			float p_next = centre[i] * current[i] + previousCoefficient[i] * previous[i];
+			p_next += neighbourCoefficient[i] * (current[i - 4] + current[i + 4]);
+			previous[i] = p_next;	//Previous timestep is no longer needed - Overwritten with the next.
+		}
+#endif
+	}
+}
+
+int StringBankSolver::rampMaterial(int numSamples)
+{
+	bool isChanged;
+	int segment = materialRamp.advance(numSamples, isChanged);
+	if (isChanged)
+		computeCoefficients(materialRamp.getOffset());
+	return segment;
+}
+
+void StringBankSolver::process(const float* excitation, float* output, int numSamples)
+{
+	StageTimer simulateStageTimer;
+	TRACE_SCOPE("simulate");
+
+	int n = 0;
+	while (n != numSamples)
+	{
+		int segmentEnd = n + rampMaterial(numSamples - n);
+		for (; n != segmentEnd; ++n)
+		{
+			const float* current = &pressure[currentPlane][0];
+			float* next = &pressure[1 - currentPlane][0];
+
+			computeStep(current, next);
+
+			//Excitation stream drives every string, strikes only their own//
+			if (excitation[n] != 0.0f)
+			{
+				for (int s = 0; s != numStrings; ++s)
+					next[excitationIndices[s]] += excitation[n];
+			}
+			if (isStrikePending)
+			{
+				for (int s = 0; s != numStrings; ++s)
+				{
+					next[excitationIndices[s]] += pendingStrikes[s];
+					pendingStrikes[s] = 0.0f;
+				}
+				isStrikePending = false;
+			}
+
+			float mix = 0.0f;
+			for (int s = 0; s != numStrings; ++s)
+				mix += next[listenerIndices[s]] * strings[s].gain;
+			output[n] = mix;
+
+			currentPlane = 1 - currentPlane;
+		}
+	}
+
+	profiler.recordCPU(STAGE_SIMULATE, simulateStageTimer.elapsed());
+}
+
+void StringBankSolver::setExcitationPosition(float x, float y)
+{
+	//Strings have no y - x moves the point along every string at once//
+	(void)y;
+	for (int s = 0; s != numStrings; ++s)
+	{
+		int cell = 1 + std::min(std::max((int)(x * strings[s].length), 0), strings[s].length - 1);
+		excitationIndices[s] = stringBase[s] + cell * 4;
+	}
+}
+
+void StringBankSolver::setMaterial(float propagation, float damping, float boundaryGain)
+{
+	materialRamp.setTarget(propagation, damping, boundaryGain);
+}
+
+double StringBankSolver::getEnergy()
+{
+	//computeFieldEnergy() along each string - Velocity of every cell and the difference to the next cell along//
+	const float* current = &pressure[currentPlane][0];
+	const float* previous = &pressure[1 - currentPlane][0];
+	double energy = 0.0;
+	for (int s = 0; s != numStrings; ++s)
+	{
+		for (int j = 1; j <= strings[s].length; ++j)
+		{
+			int i = stringBase[s] + j * 4;
+			double velocity = current[i] - previous[i];
+			energy += velocity * velocity;
+			if (j < strings[s].length)
+				energy += (double)(current[i + 4] - current[i]) * (current[i + 4] - current[i]);
+		}
+	}
+	return energy;
+}
+
+void StringBankSolver::getField(float* field)
+{
+	//Wall everywhere strings don't reach//
+	int width = settings.domainSize[0];
+	int height = settings.domainSize[1];
+	for (int i = 0; i != width * height; ++i)
+	{
+		field[i * 4 + 0] = 0.0f;
+		field[i * 4 + 1] = 0.0f;
+		field[i * 4 + 2] = 0.0f;
+		field[i * 4 + 3] = CELL_WALL;
+	}
+
+	const float* current = &pressure[currentPlane][0];
+	const float* previous = &pressure[1 - currentPlane][0];
+	for (int s = 0; s < numStrings && s + 1 < height - 1; ++s)
+	{
+		for (int j = 1; j <= strings[s].length && j < width - 1; ++j)
+		{
+			int cell = (s + 1) * width + j;
+			int i = stringBase[s] + j * 4;
+			field[cell * 4 + 0] = current[i];
+			field[cell * 4 + 1] = previous[i];
+			field[cell * 4 + 2] = 1.0f;
+			field[cell * 4 + 3] = i == listenerIndices[s] ? CELL_LISTENER : 0;
+		}
+	}
+}
+
+void StringBankSolver::setField(const float* field)
+{
+	//Only the cells getField() draws - Strings are restored as far as the field shows them//
+	int width = settings.domainSize[0];
+	int height = settings.domainSize[1];
+	float* current = &pressure[currentPlane][0];
+	float* previous = &pressure[1 - currentPlane][0];
+	for (int s = 0; s < numStrings && s + 1 < height - 1; ++s)
+	{
+		for (int j = 1; j <= strings[s].length && j < width - 1; ++j)
+		{
+			int cell = (s + 1) * width + j;
+			current[stringBase[s] + j * 4] = field[cell * 4 + 0];
+			previous[stringBase[s] + j * 4] = field[cell * 4 + 1];
+		}
+	}
+}
+
+void StringBankSolver::strike(int string, float magnitude)
+{
+	if (string < 0 || string >= numStrings)
+		return;
+	pendingStrikes[string] += magnitude;
+	isStrikePending = true;
+}
+
+int StringBankSolver::getNumStrings() const
+{
+	return numStrings;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+
+#include "solver.h"
+#include "materialRamp.h"
+
+///////////
+//DEFINES//
+///////////
+
+#define CFL_LIMIT_1D		1.0f	//Largest stable propagation factor of the 1D scheme per step - (c * dt / dx)^2 <= 1.
+#define STRING_BANK_SPAN	48		//Semitones default banks spread their strings over before repeating.
+#define MIN_STRING_LENGTH	4		//Fewest interior cells of a default bank's string.
+
+//One string or tube of a bank//
+struct StringSettings {
+	int length = 64;				//Interior cells, between a wall at each end.
+	float propagation = 0.5f;		//Per output sample, as SolverSettings - Must be <= CFL_LIMIT_1D.
+	float damping = 0.0005f;
+	float boundaryGain = 1.0f;		//Reflection gain of both ends.
+	float excitationPosition = 0.3f;	//Normalised position [0-1] driven by the excitation stream.
+	float listenerPosition = 0.1f;	//Normalised position [0-1] mixed into the output.
+	float gain = 1.0f;				//Level of the string in the mix.
+};
+
+//Strings for settings - numStrings of settings' uniform material, tuned downwards in semitones from domainSize[0] - 2 cells over STRING_BANK_SPAN//
+//Excitation and listener keep their normalised x position along every string, and each is mixed at 1 / numStrings//
+std::vector<StringSettings> buildStringBank(const SolverSettings& settings);
+
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//StringBankSolver - 1D FDTD over a bank of strings or tubes, stepped together. Strings are   //
+//sorted by length into groups of 4 stored side by side cell by cell, so one SSE vector       //
+//updates the same cell of a group and a step sweeps each group along its longest string.     //
+//Shorter strings of a group are padded with cells whose coefficients are zero, which never   //
+//leave rest. Every string is driven by the excitation                                        //
+//stream at its own excitation point, and the output mixes every listener, so the bank plugs  //
+//into the same pipeline as a membrane. getField() draws string s along row s + 1.           //
+/////////////////////////////////////////////////////////////////////////////////////////////////
+class StringBankSolver : public Solver {
+private:
+	SolverSettings settings;
+	std::vector<StringSettings> strings;
+	MaterialRamp materialRamp;
+	int numStrings;
+	std::vector<int> groupBegin;		//First float of each group of 4 strings - One entry more than groups.
+	std::vector<int> stringBase;		//Float of each string's end wall - Cell j is at stringBase + j * 4.
+
+	std::vector<float> pressure[2];		//Pressure planes - Alternately hold timestep n & n-1.
+	std::vector<float> centre;			//Update coefficients of every cell, as UpdateCoefficients - Zero for walls and padding.
+	std::vector<float> previousCoefficient;
+	std::vector<float> neighbourCoefficient;
+	int currentPlane = 0;
+
+	std::vector<int> excitationIndices;
+	std::vector<int> listenerIndices;
+	std::vector<float> pendingStrikes;	//Added to each string's excitation point on the next step.
+	bool isStrikePending = false;
+
+	//Recompute coefficients with offset over every string's material//
+	void computeCoefficients(const MaterialOffset& offset);
+
+	//Compute next timestep of every cell of every string, writing over previous timestep in place//
+	void computeStep(const float* current, float* previous);
+
+	//Glide material over the next steps of a block of numSamples, recomputing coefficients if it moved - Returns the steps to run before calling again//
+	int rampMaterial(int numSamples);
+
+public:
+	StringBankSolver(const SolverSettings& aSettings);
+	StringBankSolver(const SolverSettings& aSettings, const std::vector<StringSettings>& aStrings);
+
+	const char* getName() const;
+	void process(const float* excitation, float* output, int numSamples);
+
+	//x moves the excitation along every string at once - Strings have no y, so it is ignored//
+	void setExcitationPosition(float x, float y);
+
+	void setMaterial(float propagation, float damping, float boundaryGain);
+	double getEnergy();
+	void getField(float* field);
+	void setField(const float* field);
+
+	//Strike a single string at its excitation point on the next step - Call from the thread running process()//
+	void strike(int string, float magnitude);
+
+	int getNumStrings() const;
+};
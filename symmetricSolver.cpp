@@ -0,0 +1,375 @@
+#include "symmetricSolver.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "domainBuilder.h"
+
+FoldedSolver::FoldedSolver(const SolverSettings& aSettings, const Domain& aDomain, const bool aIsFolded[2], int aNumThreads) : ThreadedSolver(aSettings, aDomain, aNumThreads)
+{
+	isFolded[0] = aIsFolded[0];
+	isFolded[1] = aIsFolded[1];
+	isThreaded = aNumThreads != 1;
+}
+
+const char* FoldedSolver::getName() const
+{
+	return isThreaded ? "CPU threaded folded" : "CPU SIMD folded";
+}
+
+void FoldedSolver::computeRows(const float* current, float* previous, int rowBegin, int rowEnd)
+{
+	SIMDSolver::computeRows(current, previous, rowBegin, rowEnd);
+
+	//Ghosts take the next step of the cells mirrored into them - Rows are the band's own, so no other thread writes them//
+	if (isFolded[0])
+	{
+		for (int y = rowBegin; y != rowEnd; ++y)
+			previous[y * width + width - 1] = previous[y * width + width - 3];
+	}
+	if (isFolded[1] && height - 3 >= rowBegin && height - 3 < rowEnd)
+		std::copy(previous + (height - 3) * width, previous + (height - 2) * width, previous + (height - 1) * width);
+}
+
+//Whether a domain mirrors exactly about its centre column (axis 0) or row (axis 1)//
+static bool isMirrored(const Domain& domain, int axis)
+{
+	for (int y = 0; y != domain.height; ++y)
+	{
+		for (int x = 0; x != domain.width; ++x)
+		{
+			int i = y * domain.width + x;
+			int mirror = axis == 0 ? y * domain.width + domain.width - 1 - x : (domain.height - 1 - y) * domain.width + x;
+			if (domain.cellTypes[i] != domain.cellTypes[mirror] || domain.propagation[i] != domain.propagation[mirror] ||
+				domain.damping[i] != domain.damping[mirror] || domain.boundaryGain[i] != domain.boundaryGain[mirror])
+				return false;
+		}
+	}
+	return true;
+}
+
+Solver* createSymmetricSolver(const SolverSettings& settings, int numThreads, SolverCreator createUnfolded)
+{
+	Domain domain = buildDomain(settings);
+	int size[2] = { domain.width, domain.height };
+	int excitationCell[2];
+	bool isFolded[2];
+	int foldedSize[2];
+	for (int axis = 0; axis != 2; ++axis)
+	{
+		excitationCell[axis] = std::min(std::max((int)(settings.excitationPosition[axis] * size[axis]), 0), size[axis] - 1);
+		isFolded[axis] = size[axis] % 2 == 1 && size[axis] >= 5 && excitationCell[axis] == (size[axis] - 1) / 2 && isMirrored(domain, axis);
+
+		//Cells up to the axis, then a ghost//
+		foldedSize[axis] = isFolded[axis] ? (size[axis] - 1) / 2 + 2 : size[axis];
+	}
+	if (!isFolded[0] && !isFolded[1])
+		return NULL;
+
+	//The fundamental region and its ghosts are the whole drum's first cells, as it mirrors//
+	Domain folded;
+	folded.width = foldedSize[0];
+	folded.height = foldedSize[1];
+	for (int y = 0; y != folded.height; ++y)
+	{
+		int row = y * domain.width;
+		folded.cellTypes.insert(folded.cellTypes.end(), domain.cellTypes.begin() + row, domain.cellTypes.begin() + row + folded.width);
+		folded.propagation.insert(folded.propagation.end(), domain.propagation.begin() + row, domain.propagation.begin() + row + folded.width);
+		folded.damping.insert(folded.damping.end(), domain.damping.begin() + row, domain.damping.begin() + row + folded.width);
+		folded.boundaryGain.insert(folded.boundaryGain.end(), domain.boundaryGain.begin() + row, domain.boundaryGain.begin() + row + folded.width);
+	}
+
+	SolverSettings foldedSettings = settings;
+	for (int axis = 0; axis != 2; ++axis)
+	{
+		int listener = settings.listenerPosition[axis];
+		int axisCell = (size[axis] - 1) / 2;
+		foldedSettings.domainSize[axis] = foldedSize[axis];
+		foldedSettings.listenerPosition[axis] = isFolded[axis] && listener > axisCell ? 2 * axisCell - listener : listener;
+		foldedSettings.excitationPosition[axis] = (excitationCell[axis] + 0.5f) / (float)foldedSize[axis];
+	}
+	FoldedSolver* solver = new FoldedSolver(foldedSettings, folded, isFolded, numThreads);
+
+	domain.cellTypes[settings.listenerPosition[1] * domain.width + settings.listenerPosition[0]] |= CELL_LISTENER;
+	return new SymmetricSolver(solver, settings, domain, isFolded, createUnfolded);
+}
+
+SymmetricSolver::SymmetricSolver(FoldedSolver* aSolver, const SolverSettings& aSettings, const Domain& aDomain, const bool aIsFolded[2], SolverCreator aCreateUnfolded) :
+	solver(aSolver), settings(aSettings), domain(aDomain), createUnfolded(aCreateUnfolded)
+{
+	for (int axis = 0; axis != 2; ++axis)
+	{
+		isFolded[axis] = aIsFolded[axis];
+		foldedSize[axis] = isFolded[axis] ? (settings.domainSize[axis] - 1) / 2 + 2 : settings.domainSize[axis];
+		excitationPosition[axis] = settings.excitationPosition[axis];
+		restPoint[1][axis] = (float)settings.listenerPosition[axis];
+	}
+	material[0] = settings.propagationFactor;
+	material[1] = settings.dampingFactor;
+	material[2] = settings.boundaryGain;
+	foldedField.resize(foldedSize[0] * foldedSize[1] * 4);
+	name = std::string(solver->getName()) + (isFolded[0] && isFolded[1] ? " 4x" : " 2x");
+}
+
+SymmetricSolver::~SymmetricSolver()
+{
+	delete solver;
+}
+
+int SymmetricSolver::foldCell(int cell, int axis) const
+{
+	int axisCell = (settings.domainSize[axis] - 1) / 2;
+	return isFolded[axis] && cell > axisCell ? 2 * axisCell - cell : cell;
+}
+
+float SymmetricSolver::foldPoint(float point, int axis) const
+{
+	float axisCell = (float)((settings.domainSize[axis] - 1) / 2);
+	return isFolded[axis] && point > axisCell ? 2.0f * axisCell - point : point;
+}
+
+bool SymmetricSolver::isOnAxes(float x, float y) const
+{
+	return (!isFolded[0] || x == (float)((settings.domainSize[0] - 1) / 2)) && (!isFolded[1] || y == (float)((settings.domainSize[1] - 1) / 2));
+}
+
+int SymmetricSolver::getListenerCell(int axis) const
+{
+	return isPathMoved[1] ? (int)(restPoint[1][axis] + 0.5f) : settings.listenerPosition[axis];
+}
+
+bool SymmetricSolver::unfold()
+{
+	SolverSettings unfoldedSettings = settings;
+	unfoldedSettings.isFoldingSymmetry = false;
+	unfoldedSettings.excitationPosition[0] = excitationPosition[0];
+	unfoldedSettings.excitationPosition[1] = excitationPosition[1];
+	unfoldedSettings.listenerPosition[0] = getListenerCell(0);
+	unfoldedSettings.listenerPosition[1] = getListenerCell(1);
+	unfoldedSettings.propagationFactor = material[0];
+	unfoldedSettings.dampingFactor = material[1];
+	unfoldedSettings.boundaryGain = material[2];
+	Solver* unfolded = createUnfolded(unfoldedSettings);
+	if (unfolded == NULL)
+	{
+		std::cout << "Failed to unfold the symmetric solver - Keeping it folded." << std::endl;
+		return false;
+	}
+
+	std::vector<float> field(settings.domainSize[0] * settings.domainSize[1] * 4);
+	getField(&field[0]);
+	unfolded->setField(&field[0]);
+
+	delete solver;
+	solver = unfolded;
+	isFolded[0] = false;
+	isFolded[1] = false;
+	name = solver->getName();
+
+	//Probes a path left between cells are moved back there once the next block's length is known//
+	isRestPending[0] = isPathMoved[0];
+	isRestPending[1] = isPathMoved[1];
+	return true;
+}
+
+const char* SymmetricSolver::getName() const
+{
+	return name.c_str();
+}
+
+void SymmetricSolver::process(const float* excitation, float* output, int numSamples)
+{
+	//A strike sliding off the axes breaks the symmetry//
+	if (probePath[0] != NULL && (isFolded[0] || isFolded[1]))
+	{
+		for (int n = 0; n != numSamples; ++n)
+		{
+			if (!isOnAxes(probePath[0][n * 2], probePath[0][n * 2 + 1]))
+			{
+				unfold();
+				break;
+			}
+		}
+	}
+
+	for (int p = 0; p != 2 && numSamples > 0; ++p)
+	{
+		const float* path = probePath[p];
+		if (path != NULL && (isFolded[0] || isFolded[1]))
+		{
+			foldedPath[p].resize(numSamples * 2);
+			for (int n = 0; n != numSamples; ++n)
+			{
+				foldedPath[p][n * 2 + 0] = foldPoint(path[n * 2 + 0], 0);
+				foldedPath[p][n * 2 + 1] = foldPoint(path[n * 2 + 1], 1);
+			}
+			path = &foldedPath[p][0];
+		}
+		else if (path == NULL && isRestPending[p])
+		{
+			foldedPath[p].resize(numSamples * 2);
+			for (int n = 0; n != numSamples; ++n)
+			{
+				foldedPath[p][n * 2 + 0] = restPoint[p][0];
+				foldedPath[p][n * 2 + 1] = restPoint[p][1];
+			}
+			path = &foldedPath[p][0];
+		}
+		if (path == NULL)
+			continue;
+
+		solver->setProbePaths(p == 0 ? path : NULL, p == 1 ? path : NULL);
+		isRestPending[p] = false;
+		if (probePath[p] == NULL)
+			continue;
+
+		//Listener marked on the whole drum for unfolded fields//
+		if (p == 1)
+			domain.cellTypes[getListenerCell(1) * settings.domainSize[0] + getListenerCell(0)] &= ~CELL_LISTENER;
+		restPoint[p][0] = std::min(std::max(probePath[p][numSamples * 2 - 2], 0.0f), (float)(settings.domainSize[0] - 1));
+		restPoint[p][1] = std::min(std::max(probePath[p][numSamples * 2 - 1], 0.0f), (float)(settings.domainSize[1] - 1));
+		isPathMoved[p] = true;
+		if (p == 1)
+			domain.cellTypes[getListenerCell(1) * settings.domainSize[0] + getListenerCell(0)] |= CELL_LISTENER;
+	}
+	probePath[0] = NULL;
+	probePath[1] = NULL;
+
+	solver->process(excitation, output, numSamples);
+}
+
+void SymmetricSolver::setExcitationPosition(float x, float y)
+{
+	excitationPosition[0] = x;
+	excitationPosition[1] = y;
+	isPathMoved[0] = false;
+	isRestPending[0] = false;
+	if (!isFolded[0] && !isFolded[1])
+	{
+		solver->setExcitationPosition(x, y);
+		return;
+	}
+
+	int cellX = std::min(std::max((int)(x * settings.domainSize[0]), 0), settings.domainSize[0] - 1);
+	int cellY = std::min(std::max((int)(y * settings.domainSize[1]), 0), settings.domainSize[1] - 1);
+	if (isOnAxes((float)cellX, (float)cellY))
+		solver->setExcitationPosition((foldCell(cellX, 0) + 0.5f) / (float)foldedSize[0], (foldCell(cellY, 1) + 0.5f) / (float)foldedSize[1]);
+	else
+		unfold();	//Created with the new position.
+}
+
+void SymmetricSolver::setProbePaths(const float* excitationPath, const float* listenerPath)
+{
+	//Held until process(), which knows the block's length and may have to unfold first//
+	if (!solver->isProbePathFollowed())
+		return;
+	if (excitationPath != NULL)
+		probePath[0] = excitationPath;
+	if (listenerPath != NULL)
+		probePath[1] = listenerPath;
+}
+
+bool SymmetricSolver::isProbePathFollowed() const
+{
+	return solver->isProbePathFollowed();
+}
+
+void SymmetricSolver::setMaterial(float propagation, float damping, float boundaryGain)
+{
+	material[0] = propagation;
+	material[1] = damping;
+	material[2] = boundaryGain;
+	solver->setMaterial(propagation, damping, boundaryGain);
+}
+
+double SymmetricSolver::getEnergy()
+{
+	if (!isFolded[0] && !isFolded[1])
+		return solver->getEnergy();
+
+	int numCells = settings.domainSize[0] * settings.domainSize[1];
+	std::vector<float> field(numCells * 4);
+	getField(&field[0]);
+	std::vector<float> current(numCells);
+	std::vector<float> previous(numCells);
+	for (int i = 0; i != numCells; ++i)
+	{
+		current[i] = field[i * 4 + 0];
+		previous[i] = field[i * 4 + 1];
+	}
+	return computeFieldEnergy(domain, &current[0], &previous[0]);
+}
+
+void SymmetricSolver::getField(float* field)
+{
+	if (!isFolded[0] && !isFolded[1])
+	{
+		solver->getField(field);
+		return;
+	}
+
+	solver->getField(&foldedField[0]);
+	for (int y = 0; y != settings.domainSize[1]; ++y)
+	{
+		for (int x = 0; x != settings.domainSize[0]; ++x)
+		{
+			int i = y * settings.domainSize[0] + x;
+			int folded = foldCell(y, 1) * foldedSize[0] + foldCell(x, 0);
+			field[i * 4 + 0] = foldedField[folded * 4 + 0];
+			field[i * 4 + 1] = foldedField[folded * 4 + 1];
+			field[i * 4 + 2] = getTransmission(domain.cellTypes[i]);
+			field[i * 4 + 3] = domain.cellTypes[i];
+		}
+	}
+}
+
+void SymmetricSolver::setField(const float* field)
+{
+	if (!isFolded[0] && !isFolded[1])
+	{
+		solver->setField(field);
+		return;
+	}
+
+	//Pressure and cell types, bar the listener, must mirror to stay folded//
+	bool isSymmetric = true;
+	for (int y = 0; isSymmetric && y != settings.domainSize[1]; ++y)
+	{
+		for (int x = 0; x != settings.domainSize[0]; ++x)
+		{
+			const float* cell = field + (y * settings.domainSize[0] + x) * 4;
+			const float* mirror = field + (foldCell(y, 1) * settings.domainSize[0] + foldCell(x, 0)) * 4;
+			if (cell[0] != mirror[0] || cell[1] != mirror[1] || ((int)cell[3] & ~CELL_LISTENER) != ((int)mirror[3] & ~CELL_LISTENER))
+			{
+				isSymmetric = false;
+				break;
+			}
+		}
+	}
+	if (!isSymmetric)
+	{
+		if (unfold())
+			solver->setField(field);
+		return;
+	}
+
+	//The fundamental region and its ghosts are the field's first cells - Listener marked where the folded solver listens//
+	int listenerX = foldCell(getListenerCell(0), 0);
+	int listenerY = foldCell(getListenerCell(1), 1);
+	for (int y = 0; y != foldedSize[1]; ++y)
+	{
+		for (int x = 0; x != foldedSize[0]; ++x)
+		{
+			const float* cell = field + (y * settings.domainSize[0] + x) * 4;
+			float* folded = &foldedField[(y * foldedSize[0] + x) * 4];
+			int cellType = (int)cell[3] & ~CELL_LISTENER;
+			if (x == listenerX && y == listenerY)
+				cellType |= CELL_LISTENER;
+			folded[0] = cell[0];
+			folded[1] = cell[1];
+			folded[2] = cell[2];
+			folded[3] = (float)cellType;
+		}
+	}
+	solver->setField(&foldedField[0]);
+}
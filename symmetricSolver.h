@@ -0,0 +1,90 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "threadedSolver.h"
+
+//Creates the backend a SymmetricSolver unfolds into - Called with settings that don't fold//
+typedef std::function<Solver*(const SolverSettings&)> SolverCreator;
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//FoldedSolver - ThreadedSolver over the fundamental region of a mirror symmetric drum. The //
+//region ends in a ghost column and/or row past the axis, refreshed from the cells mirrored//
+//into it each time a band is computed, so the axis cells read the same neighbours as in  //
+//the whole drum. Results are bit exact with the whole drum, as the kernels' mirror       //
+//symmetric sums round a cell and its mirror image identically.                           //
+//////////////////////////////////////////////////////////////////////////////////////////////
+class FoldedSolver : public ThreadedSolver {
+private:
+	bool isFolded[2];				//Mirrored about the vertical axis, the horizontal axis.
+	bool isThreaded;
+
+protected:
+	void computeRows(const float* current, float* previous, int rowBegin, int rowEnd);
+
+public:
+	//aDomain is the fundamental region including its ghosts, settings sized to match//
+	FoldedSolver(const SolverSettings& aSettings, const Domain& aDomain, const bool aIsFolded[2], int aNumThreads);
+
+	const char* getName() const;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//SymmetricSolver - Steps a drum mirror symmetric about its centre column and/or row, struck//
+//on the axis, as a FoldedSolver over a half or quarter of it. The listener may be anywhere,//
+//as it hears the same as its mirror image, and may follow a path. Fields are unfolded to   //
+//the whole drum on the way out and folded on the way in. Striking or sliding a strike off  //
+//the axis, or setting a field that isn't symmetric, unfolds for good into the backend      //
+//creator makes - Any material glide in progress completes at once.                        //
+///////////////////////////////////////////////////////////////////////////////////////////////
+class SymmetricSolver : public Solver {
+private:
+	Solver* solver;
+	SolverSettings settings;		//Of the whole drum.
+	Domain domain;					//Of the whole drum, listener marked - For unfolded fields and energy.
+	SolverCreator createUnfolded;
+	bool isFolded[2];				//Both cleared once unfolded.
+	int foldedSize[2];
+	float excitationPosition[2];	//Normalised over the whole drum, as last set.
+	float material[3];				//Material last set, carried into the unfolded backend.
+	std::string name;
+	std::vector<float> foldedField;
+
+	//Probe paths over the whole drum for the next process() call - Excitation, listener//
+	const float* probePath[2] = { NULL, NULL };
+	std::vector<float> foldedPath[2];		//The same folded into the fundamental region, or a resting point repeated after unfolding.
+	float restPoint[2][2];					//Whole drum cells each probe rests at after its last path.
+	bool isPathMoved[2] = { false, false };	//Probe rests where a path left it, rather than where settings or setExcitationPosition() put it.
+	bool isRestPending[2] = { false, false };	//Unfolded backend has yet to be moved to restPoint.
+
+	//Cell or fractional cell of the whole drum to the fundamental region, and whether a strike there keeps the symmetry//
+	int foldCell(int cell, int axis) const;
+	float foldPoint(float point, int axis) const;
+	bool isOnAxes(float x, float y) const;
+
+	//Cell of the whole drum the listener is marked on - Nearest its resting point//
+	int getListenerCell(int axis) const;
+
+	//Replace the folded solver with the whole drum, carrying the field across - Returns false if the backend couldn't be created//
+	bool unfold();
+
+public:
+	SymmetricSolver(FoldedSolver* aSolver, const SolverSettings& aSettings, const Domain& aDomain, const bool aIsFolded[2], SolverCreator aCreateUnfolded);
+	~SymmetricSolver();
+
+	const char* getName() const;
+	void process(const float* excitation, float* output, int numSamples);
+	void setExcitationPosition(float x, float y);
+	void setProbePaths(const float* excitationPath, const float* listenerPath);
+	bool isProbePathFollowed() const;
+	void setMaterial(float propagation, float damping, float boundaryGain);
+	double getEnergy();
+	void getField(float* field);
+	void setField(const float* field);
+};
+
+//SymmetricSolver over numThreads for settings' drum if it is mirror symmetric about its centre column or row, with the excitation on that axis - Returns NULL otherwise.//
+//Axes run through a cell, so need an odd grid size - Cell types and every material plane must mirror exactly//
+Solver* createSymmetricSolver(const SolverSettings& settings, int numThreads, SolverCreator createUnfolded);
@@ -0,0 +1,165 @@
+#include "threadedSolver.h"
+
+#include <algorithm>
+
+#include "domainBuilder.h"
+#include "profiler.h"
+#include "tracer.h"
+
+#define BARRIER_SPINS		1000	//Spins before a waiting thread starts yielding - Keeps oversubscribed machines from live locking.
+
+ThreadedSolver::ThreadedSolver(const SolverSettings& aSettings, int aNumThreads) : ThreadedSolver(aSettings, buildDomain(aSettings), aNumThreads)
+{
+}
+
+ThreadedSolver::ThreadedSolver(const SolverSettings& aSettings, const Domain& aDomain, int aNumThreads) : SIMDSolver(aSettings, aDomain), barrierCount(0), barrierGeneration(0)
+{
+	//At least one interior row per thread//
+	int interiorRows = height - 2;
+	numThreads = aNumThreads > 0 ? aNumThreads : (int)std::thread::hardware_concurrency();
+	numThreads = std::max(1, std::min(numThreads, interiorRows));
+
+	for (int t = 0; t <= numThreads; ++t)
+		bandBegin.push_back(1 + interiorRows * t / numThreads);
+
+	for (int t = 1; t < numThreads; ++t)
+		workers.push_back(std::thread(&ThreadedSolver::workerLoop, this, t));
+}
+
+ThreadedSolver::~ThreadedSolver()
+{
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		isShuttingDown = true;
+	}
+	jobCondition.notify_all();
+	for (size_t i = 0; i != workers.size(); ++i)
+		workers[i].join();
+}
+
+const char* ThreadedSolver::getName() const
+{
+	return "CPU threaded";
+}
+
+void ThreadedSolver::waitBarrier()
+{
+	int generation = barrierGeneration.load(std::memory_order_acquire);
+
+	//Last thread to arrive releases the others//
+	if (barrierCount.fetch_add(1, std::memory_order_acq_rel) == numThreads - 1)
+	{
+		barrierCount.store(0, std::memory_order_relaxed);
+		barrierGeneration.fetch_add(1, std::memory_order_release);
+		return;
+	}
+
+	int spins = 0;
+	while (barrierGeneration.load(std::memory_order_acquire) == generation)
+	{
+		if (++spins > BARRIER_SPINS)
+			std::this_thread::yield();
+	}
+}
+
+void ThreadedSolver::workerLoop(int thread)
+{
+	TRACE_THREAD_NAME("Solver worker");
+
+	int seenGeneration = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(jobMutex);
+			jobCondition.wait(lock, [&]() { return isShuttingDown || jobGeneration != seenGeneration; });
+			if (isShuttingDown)
+				return;
+			seenGeneration = jobGeneration;
+		}
+		runBand(thread);
+	}
+}
+
+void ThreadedSolver::runBand(int thread)
+{
+	TRACE_SCOPE("simulate-band");
+
+	//Copy the job before the first barrier - Once past the last barrier the calling thread may already be posting the next one//
+	const float* excitation = jobExcitation;
+	float* output = jobOutput;
+	int numSamples = jobNumSamples;
+	int firstStep = jobFirstStep;
+	int plane = jobStartPlane;
+	int rowBegin = bandBegin[thread];
+	int rowEnd = bandBegin[thread + 1];
+
+	for (int n = 0; n != numSamples; ++n)
+	{
+		const float* current = &pressure[plane][0];
+		float* next = &pressure[1 - plane][0];
+
+		//Excitation is added by the threads computing the probe's rows, before the barrier publishes the step - The outer ring is wall, so never weighted//
+		computeRows(current, next, rowBegin, rowEnd);
+		CellProbe probe = getExcitationProbe(firstStep + n);
+		for (int k = 0; k != 4; ++k)
+		{
+			int row = probe.index[k] / width;
+			if (probe.weight[k] != 0.0f && row >= rowBegin && row < rowEnd)
+				next[probe.index[k]] += excitation[n] * probe.weight[k];
+		}
+
+		waitBarrier();
+
+		//Step complete - Its plane is not written again until after the next barrier//
+		if (thread == 0)
+		{
+			probe = getListenerProbe(firstStep + n);
+			output[n] = 0.0f;
+			for (int k = 0; k != 4; ++k)
+			{
+				if (probe.weight[k] != 0.0f)
+					output[n] += next[probe.index[k]] * probe.weight[k];
+			}
+		}
+
+		plane = 1 - plane;
+	}
+}
+
+void ThreadedSolver::process(const float* excitation, float* output, int numSamples)
+{
+	//Workers only ever see jobs with steps in them - An empty job could be missed and run twice//
+	if (numSamples == 0)
+	{
+		endPaths(0);
+		return;
+	}
+
+	StageTimer simulateStageTimer;
+	TRACE_SCOPE("simulate");
+
+	//A job per segment of the material glide - Coefficients only change between jobs, while workers wait//
+	int n = 0;
+	while (n != numSamples)
+	{
+		int segment = rampMaterial(numSamples - n);
+		{
+			std::lock_guard<std::mutex> lock(jobMutex);
+			jobExcitation = excitation + n;
+			jobOutput = output + n;
+			jobNumSamples = segment;
+			jobFirstStep = n;
+			jobStartPlane = currentPlane;
+			++jobGeneration;
+		}
+		jobCondition.notify_all();
+
+		//Calling thread works the first band - Returns once the final step's barrier is passed by every thread//
+		runBand(0);
+
+		currentPlane = (currentPlane + segment) % 2;
+		n += segment;
+	}
+	endPaths(numSamples);
+	profiler.recordCPU(STAGE_SIMULATE, simulateStageTimer.elapsed());
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "simdSolver.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//ThreadedSolver - SIMDSolver with the rows of each step split into bands across a pool of  //
+//worker threads. The calling thread works the first band. Threads meet at a spin barrier   //
+//after every step, since a step reads the neighbouring bands' rows of the previous one.    //
+///////////////////////////////////////////////////////////////////////////////////////////////
+class ThreadedSolver : public SIMDSolver {
+private:
+	int numThreads;
+	std::vector<std::thread> workers;
+	std::vector<int> bandBegin;			//First row of each thread's band - numThreads + 1 entries.
+
+	//Job handed to workers each process() call//
+	std::mutex jobMutex;
+	std::condition_variable jobCondition;
+	int jobGeneration = 0;
+	bool isShuttingDown = false;
+	const float* jobExcitation = NULL;
+	float* jobOutput = NULL;
+	int jobNumSamples = 0;
+	int jobFirstStep = 0;				//Step of the process() call the job starts at - Indexes the probe paths.
+	int jobStartPlane = 0;
+
+	//Spin barrier//
+	std::atomic<int> barrierCount;
+	std::atomic<int> barrierGeneration;
+
+	void waitBarrier();
+	void workerLoop(int thread);
+
+	//Compute the thread's band for every step of the current job//
+	void runBand(int thread);
+
+protected:
+	//Step a domain built elsewhere, as CPUSolver//
+	ThreadedSolver(const SolverSettings& aSettings, const Domain& aDomain, int aNumThreads);
+
+public:
+	//0 threads uses every hardware thread//
+	ThreadedSolver(const SolverSettings& aSettings, int aNumThreads = 0);
+	~ThreadedSolver();
+
+	const char* getName() const;
+	void process(const float* excitation, float* output, int numSamples);
+};
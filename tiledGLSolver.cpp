@@ -0,0 +1,416 @@
+#include "tiledGLSolver.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "shaderProgram.h"
+#include "domainBuilder.h"
+#include "tracer.h"
+
+//Nearest filtered texture of one tile - Every read is a texelFetch//
+static GLuint createTileTexture(GLint internalFormat, GLenum format, GLenum type, int textureWidth, int textureHeight, const void* pixels)
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, textureWidth, textureHeight, 0, format, type, pixels);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	return texture;
+}
+
+//Framebuffer rendering into a texture//
+static GLuint createTextureFbo(GLuint texture)
+{
+	GLuint fbo;
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+	return fbo;
+}
+
+TiledGLSolver::TiledGLSolver(const SolverSettings& aSettings) : settings(aSettings), materialRamp(aSettings), simulateTimer(STAGE_SIMULATE), haloTimer(STAGE_HALO)
+{
+	width = settings.domainSize[0];
+	height = settings.domainSize[1];
+
+	//Both programs draw a single triangle over the viewport//
+	if (!loadShaderProgram("Shaders/coefficients_vs.glsl", "Shaders/tiled_fs.glsl", fdtdShaderProgram))
+	{
+		std::cout << "Failed to create tiled fdtd shader." << std::endl;
+		glDeleteProgram(fdtdShaderProgram);
+		fdtdShaderProgram = 0;
+		return;
+	}
+	if (!loadShaderProgram("Shaders/coefficients_vs.glsl", "Shaders/coefficients_fs.glsl", coefficientShaderProgram))
+	{
+		std::cout << "Failed to create coefficient shader." << std::endl;
+		glDeleteProgram(coefficientShaderProgram);
+		glDeleteProgram(fdtdShaderProgram);
+		coefficientShaderProgram = 0;
+		fdtdShaderProgram = 0;
+		return;
+	}
+	glGenVertexArrays(1, &vao);
+
+	glUseProgram(fdtdShaderProgram);
+	glUniform1i(glGetUniformLocation(fdtdShaderProgram, "pressure"), 0);
+	glUniform1i(glGetUniformLocation(fdtdShaderProgram, "cellTypes"), 1);
+	glUniform1i(glGetUniformLocation(fdtdShaderProgram, "coefficients"), 2);
+	excitationTexelLocation = glGetUniformLocation(fdtdShaderProgram, "excitationTexel");
+	excitationMagnitudeLocation = glGetUniformLocation(fdtdShaderProgram, "excitationMagnitude");
+
+	glUseProgram(coefficientShaderProgram);
+	glUniform1i(glGetUniformLocation(coefficientShaderProgram, "material"), 3);
+	materialOffsetLocation = glGetUniformLocation(coefficientShaderProgram, "materialOffset");
+
+	/////////////////
+	//Split Domain//
+	/////////////////
+
+	//Tiles as large as the GPU allows with their halo, unless settings ask for smaller//
+	GLint maxTextureSize;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+	tileSize = settings.textureTileSize > 0 ? settings.textureTileSize : MAX_GL_TILE_SIZE;
+	tileSize = std::min(tileSize, (int)maxTextureSize - 2);
+	numTilesX = (width + tileSize - 1) / tileSize;
+	numTilesY = (height + tileSize - 1) / tileSize;
+
+	tiles.resize(numTilesX * numTilesY);
+	for (int t = 0; t != (int)tiles.size(); ++t)
+	{
+		GLTile& tile = tiles[t];
+		int tileX = t % numTilesX;
+		int tileY = t / numTilesX;
+		tile.origin[0] = tileX * tileSize;
+		tile.origin[1] = tileY * tileSize;
+		tile.size[0] = std::min(tileSize, width - tile.origin[0]);
+		tile.size[1] = std::min(tileSize, height - tile.origin[1]);
+		tile.neighbours[0] = tileX > 0 ? t - 1 : -1;
+		tile.neighbours[1] = tileY + 1 < numTilesY ? t + numTilesX : -1;
+		tile.neighbours[2] = tileX + 1 < numTilesX ? t + 1 : -1;
+		tile.neighbours[3] = tileY > 0 ? t - numTilesX : -1;
+
+		//Pressure starts at rest, halo included//
+		int textureWidth = tile.size[0] + 2;
+		int textureHeight = tile.size[1] + 2;
+		std::vector<float> zeros(textureWidth * textureHeight * 2, 0.0f);
+		for (int plane = 0; plane != 2; ++plane)
+		{
+			tile.pressure[plane] = createTileTexture(GL_RG32F, GL_RG, GL_FLOAT, textureWidth, textureHeight, &zeros[0]);
+			tile.pressureFbo[plane] = createTextureFbo(tile.pressure[plane]);
+		}
+		tile.cellTypes = createTileTexture(GL_R8UI, GL_RED_INTEGER, GL_UNSIGNED_BYTE, textureWidth, textureHeight, NULL);
+		tile.coefficients = createTileTexture(GL_RGBA32F, GL_RGBA, GL_FLOAT, textureWidth, textureHeight, NULL);
+		tile.coefficientFbo = createTextureFbo(tile.coefficients);
+		tile.material = createTileTexture(GL_RGBA32F, GL_RGBA, GL_FLOAT, textureWidth, textureHeight, NULL);
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			std::cout << "Error creating framebuffer of tile " << t << "." << std::endl;
+	}
+
+	domain = buildDomain(settings);
+	domain.cellTypes[settings.listenerPosition[1] * width + settings.listenerPosition[0]] |= CELL_LISTENER;
+	uploadDomain();
+
+	//Listener texel of each step is copied here, a row read back per chunk//
+	std::vector<float> silence(TILED_AUDIO_CAPACITY * 2, 0.0f);
+	audioTexture = createTileTexture(GL_RG32F, GL_RG, GL_FLOAT, TILED_AUDIO_CAPACITY, 1, &silence[0]);
+	audioFbo = createTextureFbo(audioTexture);
+
+	listenerTile = findTile(settings.listenerPosition[0], settings.listenerPosition[1]);
+	setExcitationPosition(settings.excitationPosition[0], settings.excitationPosition[1]);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glUseProgram(0);
+}
+
+TiledGLSolver::~TiledGLSolver()
+{
+	for (size_t t = 0; t != tiles.size(); ++t)
+	{
+		GLTile& tile = tiles[t];
+		glDeleteFramebuffers(2, tile.pressureFbo);
+		glDeleteFramebuffers(1, &tile.coefficientFbo);
+		glDeleteTextures(2, tile.pressure);
+		glDeleteTextures(1, &tile.cellTypes);
+		glDeleteTextures(1, &tile.coefficients);
+		glDeleteTextures(1, &tile.material);
+	}
+	glDeleteFramebuffers(1, &audioFbo);
+	glDeleteTextures(1, &audioTexture);
+	glDeleteVertexArrays(1, &vao);
+	glDeleteProgram(coefficientShaderProgram);
+	glDeleteProgram(fdtdShaderProgram);
+}
+
+bool TiledGLSolver::isValid() const
+{
+	return fdtdShaderProgram != 0 && coefficientShaderProgram != 0 && audioFbo != 0;
+}
+
+const char* TiledGLSolver::getName() const
+{
+	return "GL tiled";
+}
+
+int TiledGLSolver::findTile(int x, int y) const
+{
+	return (y / tileSize) * numTilesX + x / tileSize;
+}
+
+void TiledGLSolver::uploadDomain()
+{
+	//Halo texels take their neighbours' cells - Outside the domain they are walls never updated//
+	std::vector<float> texels = computeMaterialTexels(domain);
+	for (size_t t = 0; t != tiles.size(); ++t)
+	{
+		const GLTile& tile = tiles[t];
+		int textureWidth = tile.size[0] + 2;
+		int textureHeight = tile.size[1] + 2;
+		std::vector<uint8_t> cellTypes(textureWidth * textureHeight, CELL_WALL);
+		std::vector<float> material(textureWidth * textureHeight * 4, 0.0f);
+		for (int texelY = 0; texelY != textureHeight; ++texelY)
+		{
+			for (int texelX = 0; texelX != textureWidth; ++texelX)
+			{
+				int texel = texelY * textureWidth + texelX;
+				int x = tile.origin[0] + texelX - 1;
+				int y = tile.origin[1] + texelY - 1;
+				if (x < 0 || y < 0 || x >= width || y >= height)
+				{
+					material[texel * 4 + 3] = -1.0f;
+					continue;
+				}
+				cellTypes[texel] = domain.cellTypes[y * width + x];
+				std::copy(&texels[(y * width + x) * 4], &texels[(y * width + x) * 4] + 4, &material[texel * 4]);
+			}
+		}
+
+		//Rows of bytes aren't 4 byte aligned unless the width happens to be//
+		glBindTexture(GL_TEXTURE_2D, tile.cellTypes);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, textureWidth, textureHeight, GL_RED_INTEGER, GL_UNSIGNED_BYTE, &cellTypes[0]);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glBindTexture(GL_TEXTURE_2D, tile.material);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, textureWidth, textureHeight, GL_RGBA, GL_FLOAT, &material[0]);
+	}
+	updateCoefficients();
+}
+
+void TiledGLSolver::updateCoefficients()
+{
+	MaterialOffset offset = materialRamp.getOffset();
+	glUseProgram(coefficientShaderProgram);
+	glUniform3f(materialOffsetLocation, offset.propagation, offset.damping, offset.boundaryGain);
+	glBindVertexArray(vao);
+	glActiveTexture(GL_TEXTURE3);
+	for (size_t t = 0; t != tiles.size(); ++t)
+	{
+		const GLTile& tile = tiles[t];
+		glBindFramebuffer(GL_FRAMEBUFFER, tile.coefficientFbo);
+		glBindTexture(GL_TEXTURE_2D, tile.material);
+		glViewport(0, 0, tile.size[0] + 2, tile.size[1] + 2);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+	}
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void TiledGLSolver::exchangeHalos(int plane)
+{
+	TRACE_SCOPE("halo exchange");
+
+	//Neighbours in a row of tiles share heights, in a column widths - Corners aren't read by the stencil//
+	for (size_t t = 0; t != tiles.size(); ++t)
+	{
+		const GLTile& tile = tiles[t];
+		GLuint destination = tile.pressure[plane];
+		const int* neighbours = tile.neighbours;
+
+		//Left halo from the left neighbour's last column, right halo from the right neighbour's first//
+		if (neighbours[0] >= 0)
+			glCopyImageSubData(tiles[neighbours[0]].pressure[plane], GL_TEXTURE_2D, 0, tiles[neighbours[0]].size[0], 1, 0, destination, GL_TEXTURE_2D, 0, 0, 1, 0, 1, tile.size[1], 1);
+		if (neighbours[2] >= 0)
+			glCopyImageSubData(tiles[neighbours[2]].pressure[plane], GL_TEXTURE_2D, 0, 1, 1, 0, destination, GL_TEXTURE_2D, 0, tile.size[0] + 1, 1, 0, 1, tile.size[1], 1);
+
+		//Up halo from the up neighbour's first row, down halo from the down neighbour's last//
+		if (neighbours[1] >= 0)
+			glCopyImageSubData(tiles[neighbours[1]].pressure[plane], GL_TEXTURE_2D, 0, 1, 1, 0, destination, GL_TEXTURE_2D, 0, 1, tile.size[1] + 1, 0, tile.size[0], 1, 1);
+		if (neighbours[3] >= 0)
+			glCopyImageSubData(tiles[neighbours[3]].pressure[plane], GL_TEXTURE_2D, 0, 1, tiles[neighbours[3]].size[1], 0, destination, GL_TEXTURE_2D, 0, 1, 0, 0, tile.size[0], 1, 1);
+	}
+}
+
+int TiledGLSolver::rampMaterial(int numSamples)
+{
+	bool isChanged;
+	int segment = materialRamp.advance(numSamples, isChanged);
+	if (isChanged)
+		updateCoefficients();
+	return segment;
+}
+
+void TiledGLSolver::process(const float* excitation, float* output, int numSamples)
+{
+	bool isTimingGPU = (processCount++ % GPU_TIMING_INTERVAL) == 0;
+	if (isTimingGPU)
+	{
+		simulateTimer.collect();
+		haloTimer.collect();
+	}
+
+	//Excitation point as a texel of the tile holding it - Every other tile is handed a texel it never draws//
+	int excitationTile = findTile(excitationCell[0], excitationCell[1]);
+	const GLTile& listener = tiles[listenerTile];
+	int listenerTexel[2] = { settings.listenerPosition[0] - listener.origin[0] + 1, settings.listenerPosition[1] - listener.origin[1] + 1 };
+	float listenerTransmission = getTransmission(domain.cellTypes[settings.listenerPosition[1] * width + settings.listenerPosition[0]]);
+
+	//The audio texture holds TILED_AUDIO_CAPACITY samples, so larger requests are read back in several chunks//
+	int samplesDone = 0;
+	int segmentEnd = 0;
+	while (samplesDone != numSamples)
+	{
+		int chunkSize = std::min(numSamples - samplesDone, TILED_AUDIO_CAPACITY);
+
+		StageTimer simulateStageTimer;
+		TRACE_SPAN_BEGIN(simulateSpan, "simulate");
+		for (int n = 0; n != chunkSize; ++n)
+		{
+			if (samplesDone + n == segmentEnd)
+				segmentEnd += rampMaterial(numSamples - segmentEnd);
+
+			//Draw every tile's next timestep from its current one//
+			int nextPlane = 1 - currentPlane;
+			glUseProgram(fdtdShaderProgram);
+			glBindVertexArray(vao);
+			glUniform1f(excitationMagnitudeLocation, excitation[samplesDone + n]);
+			if (isTimingGPU)
+				simulateTimer.begin();
+			for (int t = 0; t != (int)tiles.size(); ++t)
+			{
+				const GLTile& tile = tiles[t];
+				glBindFramebuffer(GL_FRAMEBUFFER, tile.pressureFbo[nextPlane]);
+				glActiveTexture(GL_TEXTURE1);
+				glBindTexture(GL_TEXTURE_2D, tile.cellTypes);
+				glActiveTexture(GL_TEXTURE2);
+				glBindTexture(GL_TEXTURE_2D, tile.coefficients);
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_2D, tile.pressure[currentPlane]);
+				if (t == excitationTile)
+					glUniform2i(excitationTexelLocation, excitationCell[0] - tile.origin[0] + 1, excitationCell[1] - tile.origin[1] + 1);
+				else
+					glUniform2i(excitationTexelLocation, -1, -1);
+				glViewport(1, 1, tile.size[0], tile.size[1]);	//Interior only - Halo is left to the exchange.
+				glDrawArrays(GL_TRIANGLES, 0, 3);
+			}
+			if (isTimingGPU)
+				simulateTimer.end();
+
+			if (isTimingGPU)
+				haloTimer.begin();
+			exchangeHalos(nextPlane);
+			if (isTimingGPU)
+				haloTimer.end();
+
+			//Listener texel into this step's slot of the audio row//
+			glCopyImageSubData(listener.pressure[nextPlane], GL_TEXTURE_2D, 0, listenerTexel[0], listenerTexel[1], 0, audioTexture, GL_TEXTURE_2D, 0, n, 0, 0, 1, 1, 1);
+
+			currentPlane = nextPlane;
+		}
+		TRACE_SPAN_END(simulateSpan);
+		profiler.recordCPU(STAGE_SIMULATE, simulateStageTimer.elapsed());
+
+		//Retrieve the chunk's audio in one read - Silence boundaries, as the fbo shader does//
+		StageTimer readbackStageTimer;
+		TRACE_SPAN_BEGIN(readbackSpan, "readback");
+		glBindFramebuffer(GL_FRAMEBUFFER, audioFbo);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		glReadPixels(0, 0, chunkSize, 1, GL_RED, GL_FLOAT, output + samplesDone);
+		for (int n = 0; n != chunkSize; ++n)
+			output[samplesDone + n] *= listenerTransmission;
+		TRACE_SPAN_END(readbackSpan);
+		profiler.recordCPU(STAGE_READBACK, readbackStageTimer.elapsed());
+
+		samplesDone += chunkSize;
+	}
+}
+
+void TiledGLSolver::setExcitationPosition(float x, float y)
+{
+	excitationCell[0] = std::min(std::max((int)(x * width), 0), width - 1);
+	excitationCell[1] = std::min(std::max((int)(y * height), 0), height - 1);
+}
+
+void TiledGLSolver::setMaterial(float propagation, float damping, float boundaryGain)
+{
+	materialRamp.setTarget(propagation, damping, boundaryGain);
+}
+
+double TiledGLSolver::getEnergy()
+{
+	//Reduced on the CPU from a snapshot - ParkedSolver only asks once the listener has gone quiet//
+	std::vector<float> field(domain.cellTypes.size() * 4);
+	getField(&field[0]);
+	std::vector<float> current(domain.cellTypes.size());
+	std::vector<float> previous(domain.cellTypes.size());
+	for (size_t i = 0; i != domain.cellTypes.size(); ++i)
+	{
+		current[i] = field[i * 4 + 0];
+		previous[i] = field[i * 4 + 1];
+	}
+	return computeFieldEnergy(domain, &current[0], &previous[0]);
+}
+
+void TiledGLSolver::getField(float* field)
+{
+	TRACE_SCOPE("snapshot");
+
+	//Each tile's interior straight into its place in the field - Reading RGBA from the RG texture leaves room for the cell channels//
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glPixelStorei(GL_PACK_ROW_LENGTH, width);
+	for (size_t t = 0; t != tiles.size(); ++t)
+	{
+		const GLTile& tile = tiles[t];
+		glBindFramebuffer(GL_FRAMEBUFFER, tile.pressureFbo[currentPlane]);
+		glReadPixels(1, 1, tile.size[0], tile.size[1], GL_RGBA, GL_FLOAT, field + (tile.origin[1] * width + tile.origin[0]) * 4);
+	}
+	glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+
+	for (size_t i = 0; i != domain.cellTypes.size(); ++i)
+	{
+		field[i * 4 + 2] = getTransmission(domain.cellTypes[i]);
+		field[i * 4 + 3] = domain.cellTypes[i];
+	}
+}
+
+void TiledGLSolver::setField(const float* field)
+{
+	//Uploaded with halos filled from the field, so no exchange is needed before the next step//
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glActiveTexture(GL_TEXTURE0);
+	for (size_t t = 0; t != tiles.size(); ++t)
+	{
+		const GLTile& tile = tiles[t];
+		int textureWidth = tile.size[0] + 2;
+		int textureHeight = tile.size[1] + 2;
+		std::vector<float> texels(textureWidth * textureHeight * 2, 0.0f);
+		for (int texelY = 0; texelY != textureHeight; ++texelY)
+		{
+			for (int texelX = 0; texelX != textureWidth; ++texelX)
+			{
+				int x = tile.origin[0] + texelX - 1;
+				int y = tile.origin[1] + texelY - 1;
+				if (x < 0 || y < 0 || x >= width || y >= height)
+					continue;
+				texels[(texelY * textureWidth + texelX) * 2 + 0] = field[(y * width + x) * 4 + 0];
+				texels[(texelY * textureWidth + texelX) * 2 + 1] = field[(y * width + x) * 4 + 1];
+			}
+		}
+		glBindTexture(GL_TEXTURE_2D, tile.pressure[currentPlane]);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, textureWidth, textureHeight, GL_RG, GL_FLOAT, &texels[0]);
+	}
+
+	for (size_t i = 0; i != domain.cellTypes.size(); ++i)
+		domain.cellTypes[i] = (uint8_t)field[i * 4 + 3];
+	uploadDomain();
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <glad\glad.h>
+#include <vector>
+
+#include "solver.h"
+#include "domain.h"
+#include "materialRamp.h"
+#include "gpuTimer.h"
+
+///////////
+//DEFINES//
+///////////
+
+#define MAX_GL_TILE_SIZE		4094	//Interior cells per side of a tile when settings leave it to the solver - 4096 texels with the halo.
+#define TILED_AUDIO_CAPACITY	4096	//Listener samples the audio texture holds before it must be read back.
+
+//One texture sized piece of the domain, with a one cell halo around it//
+struct GLTile {
+	int origin[2];					//Domain cell of the first interior texel.
+	int size[2];					//Interior cells - Textures are 2 larger each way.
+	int neighbours[4];				//Tile index [left, up, right, down] - -1 at the domain's edge.
+	GLuint pressure[2];				//RG pressure and previous pressure - Alternately hold timestep n & n-1.
+	GLuint pressureFbo[2];
+	GLuint cellTypes;				//R8UI cell type bits - Halo outside the domain is wall.
+	GLuint coefficients;			//RGBA32F update coefficients, rendered from material.
+	GLuint coefficientFbo;
+	GLuint material;				//RGBA32F computeMaterialTexels() - Halo is never updated.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+//TiledGLSolver - FDTD model split across several textures, so domains can grow past the     //
+//largest single texture. Each tile is drawn by tiled_fs.glsl every step, after which a halo //
+//exchange copies every tile's edge cells into its neighbours' halos with glCopyImageSubData.//
+//The listener texel is copied into an audio texture each step and read back once per chunk.//
+//Needs an OpenGL 4.3 context.                                                               //
+////////////////////////////////////////////////////////////////////////////////////////////////
+class TiledGLSolver : public Solver {
+private:
+	SolverSettings settings;
+	Domain domain;					//Cell types and material as uploaded to the tiles.
+	MaterialRamp materialRamp;
+	int width;
+	int height;
+	int tileSize;					//Interior cells per side of every tile but the last of a row or column.
+	int numTilesX;
+	int numTilesY;
+	std::vector<GLTile> tiles;
+
+	GLuint fdtdShaderProgram = 0;
+	GLuint coefficientShaderProgram = 0;	//Folds material and its runtime offset into each tile's coefficients.
+	GLuint vao = 0;					//Vertices come from the vertex index - Bound only because a draw needs one.
+	GLuint audioTexture = 0;		//RG listener texel of each step.
+	GLuint audioFbo = 0;
+
+	//Uniform Locations//
+	GLint excitationTexelLocation;
+	GLint excitationMagnitudeLocation;
+	GLint materialOffsetLocation;
+
+	int currentPlane = 0;			//Pressure texture of each tile holding timestep n.
+	int excitationCell[2];
+	int listenerTile;
+
+	GPUTimer simulateTimer;
+	GPUTimer haloTimer;
+	int processCount = 0;
+
+	//Tile holding a domain cell//
+	int findTile(int x, int y) const;
+
+	//Upload cell types and material of every tile, then recompute coefficients//
+	void uploadDomain();
+
+	//Draw the current material into every tile's coefficients//
+	void updateCoefficients();
+
+	//Copy every tile's edges of a pressure plane into its neighbours' halos//
+	void exchangeHalos(int plane);
+
+	//Glide material over the next steps of a block of numSamples, recomputing coefficients if it moved - Returns the steps to run before calling again//
+	int rampMaterial(int numSamples);
+
+public:
+	TiledGLSolver(const SolverSettings& aSettings);
+	~TiledGLSolver();
+
+	bool isValid() const;
+
+	const char* getName() const;
+	void process(const float* excitation, float* output, int numSamples);
+	void setExcitationPosition(float x, float y);
+	void setMaterial(float propagation, float damping, float boundaryGain);
+	double getEnergy();
+	void getField(float* field);
+	void setField(const float* field);
+};
@@ -0,0 +1,195 @@
+#include "tracer.h"
+
+#ifdef FDTD_TRACING
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+Tracer tracer;
+
+//Each thread's buffer, found without locking after the first event//
+static thread_local TraceBuffer* threadBuffer = NULL;
+
+///////////////
+//TraceBuffer//
+///////////////
+
+TraceBuffer::TraceBuffer(const std::string& aThreadName, int aThreadId) : writeIndex(0), readIndex(0), droppedCount(0), threadName(aThreadName), threadId(aThreadId)
+{
+}
+
+void TraceBuffer::push(const char* name, uint64_t begin, uint64_t end)
+{
+	uint32_t write = writeIndex.load(std::memory_order_relaxed);
+	if (write - readIndex.load(std::memory_order_acquire) == TRACE_BUFFER_SIZE)
+	{
+		droppedCount.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	TraceEvent& event = events[write & (TRACE_BUFFER_SIZE - 1)];
+	event.name = name;
+	event.begin = begin;
+	event.end = end;
+	writeIndex.store(write + 1, std::memory_order_release);
+}
+
+void TraceBuffer::drain(std::vector<TraceEvent>& drained)
+{
+	uint32_t read = readIndex.load(std::memory_order_relaxed);
+	uint32_t write = writeIndex.load(std::memory_order_acquire);
+	for (; read != write; ++read)
+		drained.push_back(events[read & (TRACE_BUFFER_SIZE - 1)]);
+	readIndex.store(read, std::memory_order_release);
+}
+
+uint32_t TraceBuffer::getDroppedCount() const
+{
+	return droppedCount.load(std::memory_order_relaxed);
+}
+
+//////////
+//Tracer//
+//////////
+
+Tracer::Tracer() : isTracing(false), startTime(0)
+{
+}
+
+Tracer::~Tracer()
+{
+	stop();
+	for (size_t i = 0; i != buffers.size(); ++i)
+		delete buffers[i];
+}
+
+bool Tracer::start(const char* path)
+{
+	if (isTracing)
+		return true;
+
+	file.open(path);
+	if (!file.is_open())
+		return false;
+
+	file << std::fixed << std::setprecision(3);
+	file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	isFirstEvent = true;
+	startTime.store(std::chrono::duration_cast<std::chrono::nanoseconds>(ProfileClock::now().time_since_epoch()).count(), std::memory_order_release);
+	isTracing = true;
+
+	//Flush periodically off the hot path//
+	flushThread = std::thread([this]() {
+		while (isTracing)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(TRACE_FLUSH_INTERVAL));
+			flush();
+		}
+	});
+	return true;
+}
+
+void Tracer::stop()
+{
+	if (!isTracing)
+		return;
+
+	isTracing = false;
+	flushThread.join();
+	flush();
+
+	//Thread names as metadata events, then report any events lost to full buffers//
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	for (size_t i = 0; i != buffers.size(); ++i)
+	{
+		file << (isFirstEvent ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffers[i]->threadId
+			<< ",\"args\":{\"name\":\"" << buffers[i]->threadName << "\"}}";
+		isFirstEvent = false;
+		if (buffers[i]->getDroppedCount() != 0)
+			std::cout << "Tracer dropped " << buffers[i]->getDroppedCount() << " events on " << buffers[i]->threadName << std::endl;
+	}
+	file << "\n]}\n";
+	file.close();
+}
+
+void Tracer::flush()
+{
+	std::vector<TraceEvent> drained;
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	for (size_t i = 0; i != buffers.size(); ++i)
+	{
+		drained.clear();
+		buffers[i]->drain(drained);
+		for (size_t j = 0; j != drained.size(); ++j)
+			writeEvent(*buffers[i], drained[j]);
+	}
+	file.flush();
+}
+
+void Tracer::writeEvent(const TraceBuffer& buffer, const TraceEvent& event)
+{
+	//Complete event - Timestamps in microseconds as the format requires//
+	file << (isFirstEvent ? "" : ",") << "\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer.threadId
+		<< ",\"ts\":" << event.begin / 1000.0 << ",\"dur\":" << (event.end - event.begin) / 1000.0 << "}";
+	isFirstEvent = false;
+}
+
+uint64_t Tracer::toTraceTime(ProfileClock::time_point timePoint) const
+{
+	int64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(timePoint.time_since_epoch()).count() - startTime.load(std::memory_order_acquire);
+	if (nanoseconds < 0)
+		return 0;
+	return (uint64_t)nanoseconds;
+}
+
+TraceBuffer* Tracer::getThreadBuffer(const char* threadName)
+{
+	if (threadBuffer == NULL)
+		threadBuffer = createTrack(threadName);
+	return threadBuffer;
+}
+
+TraceBuffer* Tracer::createTrack(const char* trackName)
+{
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	TraceBuffer* buffer = new TraceBuffer(trackName, nextThreadId++);
+	buffers.push_back(buffer);
+	return buffer;
+}
+
+void Tracer::setThreadName(const char* threadName)
+{
+	//Cheap to call repeatedly, e.g. from callbacks run on a thread we don't own//
+	if (threadBuffer != NULL && threadBuffer->threadName == threadName)
+		return;
+
+	TraceBuffer* buffer = getThreadBuffer(threadName);
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	buffer->threadName = threadName;
+}
+
+//////////////
+//TraceScope//
+//////////////
+
+TraceScope::TraceScope(const char* aName) : name(aName), begin(0)
+{
+	if (tracer.isEnabled())
+		begin = tracer.now();
+}
+
+TraceScope::~TraceScope()
+{
+	end();
+}
+
+void TraceScope::end()
+{
+	//Scopes that began before tracing started are skipped rather than stretched back to time zero//
+	if (begin != 0 && tracer.isEnabled())
+		tracer.getThreadBuffer("Thread")->push(name, begin, tracer.now());
+	begin = 0;
+}
+
+#endif
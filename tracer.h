@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "profiler.h"
+
+///////////
+//DEFINES//
+///////////
+
+//Build with FDTD_TRACING defined to compile the tracer in - Otherwise every TRACE_ macro expands to nothing and no tracer exists//
+#define TRACE_BUFFER_SIZE		16384	//Events held per thread before the flusher must drain them - Power of 2.
+#define TRACE_FLUSH_INTERVAL	100		//Milliseconds between flushes to file.
+
+#ifdef FDTD_TRACING
+
+//A single complete event - Begin and end of a scope on one thread//
+struct TraceEvent {
+	const char* name;		//Must be a string literal - Only the pointer is stored on the hot path.
+	uint64_t begin;			//Nanoseconds since tracer started.
+	uint64_t end;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//TraceBuffer - Ring of events written only by its owning thread and drained only by the  //
+//flusher thread. When the flusher falls behind new events are dropped, never blocked on. //
+//////////////////////////////////////////////////////////////////////////////////////////////
+class TraceBuffer {
+private:
+	TraceEvent events[TRACE_BUFFER_SIZE];
+	std::atomic<uint32_t> writeIndex;
+	std::atomic<uint32_t> readIndex;
+	std::atomic<uint32_t> droppedCount;
+
+public:
+	std::string threadName;
+	int threadId;
+
+	TraceBuffer(const std::string& aThreadName, int aThreadId);
+
+	void push(const char* name, uint64_t begin, uint64_t end);
+
+	//Flusher side - Copies out every event written so far//
+	void drain(std::vector<TraceEvent>& drained);
+	uint32_t getDroppedCount() const;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//Tracer - Collects events from every thread into Chrome Trace Event JSON, viewable in     //
+//chrome://tracing or Perfetto. The file is written by a background thread, so the hot path//
+//only ever reads the clock and stores into its own thread's buffer.                       //
+//////////////////////////////////////////////////////////////////////////////////////////////
+class Tracer {
+private:
+	std::atomic<bool> isTracing;
+	std::atomic<int64_t> startTime;			//Profiler clock nanoseconds at start() - Atomic, as other threads read it while it is set.
+
+	std::mutex buffersMutex;				//Guards registration only - Never taken on the hot path.
+	std::vector<TraceBuffer*> buffers;
+	int nextThreadId = 1;
+
+	std::ofstream file;
+	bool isFirstEvent = true;
+	std::thread flushThread;
+
+	void flush();
+	void writeEvent(const TraceBuffer& buffer, const TraceEvent& event);
+
+public:
+	Tracer();
+	~Tracer();
+
+	//Begin writing events to a JSON file - Returns false if it can't be opened//
+	bool start(const char* path);
+
+	//Drain remaining events and close the file//
+	void stop();
+
+	bool isEnabled() const
+	{
+		return isTracing.load(std::memory_order_relaxed);
+	}
+
+	//Nanoseconds since start() on the profiler clock//
+	uint64_t now() const
+	{
+		return toTraceTime(ProfileClock::now());
+	}
+
+	//Convert a profiler clock time point to trace time//
+	uint64_t toTraceTime(ProfileClock::time_point timePoint) const;
+
+	//Buffer for the calling thread - Registered on first use under the given name//
+	TraceBuffer* getThreadBuffer(const char* threadName);
+
+	//Buffer for a track not tied to an OS thread, e.g. GPU execution. Must only be written from one thread//
+	TraceBuffer* createTrack(const char* trackName);
+
+	//Name the calling thread's track//
+	void setThreadName(const char* threadName);
+};
+
+//////////////////////////////////////////////////////////////////
+//TraceScope - Records a complete event over its own lifetime//
+//////////////////////////////////////////////////////////////////
+class TraceScope {
+private:
+	const char* name;
+	uint64_t begin;
+
+public:
+	TraceScope(const char* aName);
+	~TraceScope();
+
+	//Record the event now rather than at end of scope//
+	void end();
+};
+
+//Process wide tracer//
+extern Tracer tracer;
+
+#define TRACE_CONCAT_INNER(a, b)	a##b
+#define TRACE_CONCAT(a, b)			TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name)			TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_SPAN_BEGIN(span, name)	TraceScope span(name)
+#define TRACE_SPAN_END(span)		span.end()
+#define TRACE_THREAD_NAME(name)		tracer.setThreadName(name)
+#else
+#define TRACE_SCOPE(name)
+#define TRACE_SPAN_BEGIN(span, name)
+#define TRACE_SPAN_END(span)
+#define TRACE_THREAD_NAME(name)
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//TripleBuffer - Hands the latest value from one writer thread to one reader thread.   //
+//The writer fills the back slot and publishes it, the reader takes whatever was last  //
+//published. Neither side blocks, stale values are simply overwritten.                 //
+/////////////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+class TripleBuffer {
+private:
+	static const int DIRTY_BIT = 4;	//Set in the shared index when it holds a slot the reader has not seen yet.
+
+	T slots[3];
+	std::atomic<int> sharedIndex;	//Slot in the middle, exchanged between the two sides.
+	int backIndex = 1;				//Slot owned by the writer.
+	int frontIndex = 2;				//Slot owned by the reader.
+
+public:
+	TripleBuffer() : sharedIndex(0) {}
+
+	//Writer side - Slot to fill before calling publish()//
+	T& getBack()
+	{
+		return slots[backIndex];
+	}
+
+	//Writer side - Make the back slot the latest value and take the old shared slot as new back slot//
+	void publish()
+	{
+		backIndex = sharedIndex.exchange(backIndex | DIRTY_BIT, std::memory_order_acq_rel) & ~DIRTY_BIT;
+	}
+
+	//Reader side - Take the latest published slot if there is one. Returns false if nothing new arrived//
+	bool acquire()
+	{
+		if (!(sharedIndex.load(std::memory_order_relaxed) & DIRTY_BIT))
+			return false;
+		frontIndex = sharedIndex.exchange(frontIndex, std::memory_order_acq_rel) & ~DIRTY_BIT;
+		return true;
+	}
+
+	//Reader side - The slot taken by the last successful acquire()//
+	const T& getFront() const
+	{
+		return slots[frontIndex];
+	}
+
+	//Initialise every slot - Only safe before the threads start//
+	void fill(const T& value)
+	{
+		for (int i = 0; i != 3; ++i)
+			slots[i] = value;
+	}
+};
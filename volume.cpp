@@ -0,0 +1,113 @@
+#include "volume.h"
+
+#include <algorithm>
+
+#include "domainBuilder.h"
+
+Volume buildVolume(const SolverSettings& settings)
+{
+	Domain shape = buildDomain(settings);
+
+	Volume volume;
+	volume.width = shape.width;
+	volume.height = shape.height;
+	volume.depth = settings.domainDepth;
+	int layerSize = volume.width * volume.height;
+	int numVoxels = layerSize * volume.depth;
+
+	//Floor and ceiling are walls of the uniform gain//
+	volume.cellTypes.assign(numVoxels, CELL_WALL);
+	volume.propagation.assign(numVoxels, 0.0f);
+	volume.damping.assign(numVoxels, 0.0f);
+	volume.boundaryGain.assign(numVoxels, settings.boundaryGain);
+
+	for (int z = 1; z < volume.depth - 1; ++z)
+	{
+		for (int i = 0; i != layerSize; ++i)
+		{
+			int voxel = z * layerSize + i;
+			volume.cellTypes[voxel] = shape.cellTypes[i] & (CELL_WALL | CELL_FREE_EDGE);
+			volume.propagation[voxel] = shape.propagation[i];
+			volume.damping[voxel] = shape.damping[i];
+			volume.boundaryGain[voxel] = shape.boundaryGain[i];
+		}
+	}
+	return volume;
+}
+
+void computeVolumeCoefficients(const Volume& volume, const MaterialOffset& offset, UpdateCoefficients& coefficients)
+{
+	int width = volume.width;
+	int layerSize = volume.width * volume.height;
+	int numVoxels = layerSize * volume.depth;
+	coefficients.centre.assign(numVoxels, 0.0f);
+	coefficients.previous.assign(numVoxels, 0.0f);
+	coefficients.neighbour.assign(numVoxels, 0.0f);
+
+	//Neighbours [left, up, right, down, below, above]//
+	const int offsets[6] = { -1, width, 1, -width, -layerSize, layerSize };
+	for (int z = 1; z < volume.depth - 1; ++z)
+	{
+		for (int y = 1; y < volume.height - 1; ++y)
+		{
+			for (int x = 1; x < width - 1; ++x)
+			{
+				int i = (z * volume.height + y) * width + x;
+				if (volume.cellTypes[i] & CELL_WALL)
+					continue;
+
+				//Each wall neighbour reflects this voxel's pressure back by its gain//
+				double reflection = 0.0;
+				int numAdjustable = 0;
+				for (int k = 0; k != 6; ++k)
+				{
+					uint8_t neighbourType = volume.cellTypes[i + offsets[k]];
+					if (!(neighbourType & CELL_WALL))
+						continue;
+					reflection += getReflectionGain(neighbourType, volume.boundaryGain[i + offsets[k]]);
+					if (!(neighbourType & CELL_FREE_EDGE))
+						++numAdjustable;
+				}
+				reflection += numAdjustable * (double)offset.boundaryGain;
+
+				//Worked in double so only the final coefficients round//
+				double prop = std::min(std::max((double)volume.propagation[i] + offset.propagation, 0.0), (double)CFL_LIMIT_3D);
+				double damp = std::max((double)volume.damping[i] + offset.damping, 0.0);
+				coefficients.centre[i] = (float)((2.0 - 6.0 * prop + prop * reflection) / (1.0 + damp));
+				coefficients.previous[i] = (float)((damp - 1.0) / (1.0 + damp));
+				coefficients.neighbour[i] = (float)(prop / (1.0 + damp));
+			}
+		}
+	}
+}
+
+double computeVolumeEnergy(const Volume& volume, const float* current, const float* previous)
+{
+	int width = volume.width;
+	int layerSize = volume.width * volume.height;
+	double energy = 0.0;
+	for (int z = 1; z < volume.depth - 1; ++z)
+	{
+		for (int y = 1; y < volume.height - 1; ++y)
+		{
+			for (int x = 1; x < width - 1; ++x)
+			{
+				int i = (z * volume.height + y) * width + x;
+				if (volume.cellTypes[i] & CELL_WALL)
+					continue;
+
+				double velocity = current[i] - previous[i];
+				energy += velocity * velocity;
+
+				//Each pair of regular neighbours counted once//
+				if (x + 1 < width - 1 && !(volume.cellTypes[i + 1] & CELL_WALL))
+					energy += (double)(current[i + 1] - current[i]) * (current[i + 1] - current[i]);
+				if (y + 1 < volume.height - 1 && !(volume.cellTypes[i + width] & CELL_WALL))
+					energy += (double)(current[i + width] - current[i]) * (current[i + width] - current[i]);
+				if (z + 1 < volume.depth - 1 && !(volume.cellTypes[i + layerSize] & CELL_WALL))
+					energy += (double)(current[i + layerSize] - current[i]) * (current[i + layerSize] - current[i]);
+			}
+		}
+	}
+	return energy;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "solver.h"
+#include "domain.h"
+
+///////////
+//DEFINES//
+///////////
+
+#define CFL_LIMIT_3D		(1.0f / 3.0f)	//Largest stable propagation factor of the 3D scheme per step - (c * dt / dx)^2 <= 1/3.
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//Volume - Voxel types and material of a 3D grid. Layer major from the bottom layer, so     //
+//voxel (x, y, z) is at index (z * height + y) * width + x - Each layer is laid out like a  //
+//Domain. Uses the same CELL_ bits, with walls reflecting along all 6 axis directions.      //
+//////////////////////////////////////////////////////////////////////////////////////////////
+struct Volume {
+	int width = 0;
+	int height = 0;
+	int depth = 0;
+	std::vector<uint8_t> cellTypes;		//CELL_ bits of every voxel.
+	std::vector<float> propagation;		//Propagation factor of every voxel - Must be <= CFL_LIMIT_3D.
+	std::vector<float> damping;
+	std::vector<float> boundaryGain;	//Reflection gain of every wall voxel.
+};
+
+//Volume of settings' shape and material extruded through domainDepth layers, closed by a wall floor and ceiling of settings' boundaryGain//
+//Only the wall and free edge bits of the shape are extruded - Excitation and listener are single voxels placed by the solver//
+Volume buildVolume(const SolverSettings& settings);
+
+//Coefficients of every voxel with offset over the volume's material - As computeUpdateCoefficients() with 6 neighbours, walls all zero//
+void computeVolumeCoefficients(const Volume& volume, const MaterialOffset& offset, UpdateCoefficients& coefficients);
+
+//Field energy metric of a timestep - computeFieldEnergy() with the differences to the regular neighbour above added//
+double computeVolumeEnergy(const Volume& volume, const float* current, const float* previous);
@@ -0,0 +1,325 @@
+#include "volumeSolver.h"
+
+#include <algorithm>
+
+#include "simdSolver.h"
+#include "profiler.h"
+#include "tracer.h"
+
+#ifdef SIMD_SOLVER_AVAILABLE
+#include <emmintrin.h>
+#include <cstring>
+#endif
+
+#define BARRIER_SPINS		1000	//Spins before a waiting thread starts yielding - Keeps oversubscribed machines from live locking.
+
+VolumeSolver::VolumeSolver(const SolverSettings& aSettings, int aNumThreads) : settings(aSettings), materialRamp(aSettings), barrierCount(0), barrierGeneration(0)
+{
+	volume = buildVolume(settings);
+	width = volume.width;
+	height = volume.height;
+	depth = volume.depth;
+	layerSize = width * height;
+
+	listenerLayer = std::min(std::max(settings.listenerLayer, 0), depth - 1);
+	listenerIndex = (listenerLayer * height + settings.listenerPosition[1]) * width + settings.listenerPosition[0];
+	volume.cellTypes[listenerIndex] |= CELL_LISTENER;
+	computeVolumeCoefficients(volume, MaterialOffset(), coefficients);
+
+	pressure[0].assign(layerSize * depth, 0.0f);
+	pressure[1].assign(layerSize * depth, 0.0f);
+
+	setExcitationPosition(settings.excitationPosition[0], settings.excitationPosition[1]);
+
+	//At least one interior row per thread//
+	int interiorRows = height - 2;
+	numThreads = aNumThreads > 0 ? aNumThreads : (int)std::thread::hardware_concurrency();
+	numThreads = std::max(1, std::min(numThreads, interiorRows));
+
+	for (int t = 0; t <= numThreads; ++t)
+		bandBegin.push_back(1 + interiorRows * t / numThreads);
+
+	for (int t = 1; t < numThreads; ++t)
+		workers.push_back(std::thread(&VolumeSolver::workerLoop, this, t));
+}
+
+VolumeSolver::~VolumeSolver()
+{
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		isShuttingDown = true;
+	}
+	jobCondition.notify_all();
+	for (size_t i = 0; i != workers.size(); ++i)
+		workers[i].join();
+}
+
+const char* VolumeSolver::getName() const
+{
+	return numThreads > 1 ? "CPU volume threaded" : "CPU volume";
+}
+
+void VolumeSolver::computeBand(const float* current, float* previous, int rowBegin, int rowEnd)
+{
+	//Each slab climbs every layer before the next starts - Layer z - 1 of the slab was fetched for the previous layer, z + 1 is reused by the next//
+	for (int slabBegin = rowBegin; slabBegin < rowEnd; slabBegin += VOLUME_SLAB_ROWS)
+	{
+		int slabEnd = std::min(slabBegin + VOLUME_SLAB_ROWS, rowEnd);
+		for (int z = 1; z < depth - 1; ++z)
+		{
+			for (int y = slabBegin; y != slabEnd; ++y)
+			{
+#ifdef SIMD_SOLVER_AVAILABLE
+				const uint8_t* cellTypes = &volume.cellTypes[0];
+				const __m128i wallBit = _mm_set1_epi32(CELL_WALL);
+				const __m128 one = _mm_set1_ps(1.0f);
+
+				int x = 1;
+				for (; x + 4 <= width - 1; x += 4)
+				{
+					int i = (z * height + y) * width + x;
+					__m128 p = _mm_loadu_ps(current + i);
+					__m128 p_prev = _mm_loadu_ps(previous + i);
+
+					//Neighbours [left, up, right, down, below, above] - Summed in mirror image pairs, as the scalar kernel does//
+					const int offsets[6] = { -1, width, 1, -width, -layerSize, layerSize };
+					__m128 pNeighbour[6];
+					for (int k = 0; k != 6; ++k)
+					{
+						__m128 neighbour = _mm_loadu_ps(current + i + offsets[k]);
+
+						//Widen 4 voxel type bytes to 32 bit lanes, then select transmission per lane//
+						int32_t packedTypes;
+						memcpy(&packedTypes, cellTypes + i + offsets[k], sizeof(packedTypes));
+						__m128i types = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packedTypes), _mm_setzero_si128()), _mm_setzero_si128());
+						__m128 isWall = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(types, wallBit), wallBit));
+						__m128 isTransmissive = _mm_andnot_ps(isWall, one);
+
+						pNeighbour[k] = _mm_mul_ps(neighbour, isTransmissive);
+					}
+					__m128 pNeighbours = _mm_add_ps(_mm_add_ps(_mm_add_ps(pNeighbour[0], pNeighbour[2]), _mm_add_ps(pNeighbour[1], pNeighbour[3])), _mm_add_ps(pNeighbour[4], pNeighbour[5]));
+
+					//Assemble equation//
+					__m128 p_next = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&coefficients.centre[i]), p), _mm_mul_ps(_mm_loadu_ps(&coefficients.previous[i]), p_prev));
+					p_next = _mm_add_ps(p_next, _mm_mul_ps(_mm_loadu_ps(&coefficients.neighbour[i]), pNeighbours));
+
+					_mm_storeu_ps(previous + i, p_next);
+				}
+
+				//Remaining voxels that don't fill a vector//
+				computeSpan(current, previous, z, y, x, width - 1);
+#else
+				computeSpan(current, previous, z, y, 1, width - 1);
+#endif
+			}
+		}
+	}
+}
+
+void VolumeSolver::computeSpan(const float* current, float* previous, int z, int y, int xBegin, int xEnd)
+{
+	const int offsets[6] = { -1, width, 1, -width, -layerSize, layerSize };
+	for (int x = xBegin; x < xEnd; ++x)
+	{
+		int i = (z * height + y) * width + x;
+		float p = current[i];
+		float p_prev = previous[i];
+
+		//Only regular neighbours pass on pressure, reflections off walls are folded into the centre coefficient - Mirror images summed in pairs//
+		float pNeighbour[6];
+		for (int k = 0; k != 6; ++k)
+			pNeighbour[k] = current[i + offsets[k]] * getTransmission(volume.cellTypes[i + offsets[k]]);
+		float pNeighbours = ((pNeighbour[0] + pNeighbour[2]) + (pNeighbour[1] + pNeighbour[3])) + (pNeighbour[4] + pNeighbour[5]);
+
+		float p_next = coefficients.centre[i] * p + coefficients.previous[i] * p_prev;
+		p_next += coefficients.neighbour[i] * pNeighbours;
+
+		previous[i] = p_next;	//Previous timestep is no longer needed - Overwritten with the next.
+	}
+}
+
+int VolumeSolver::rampMaterial(int numSamples)
+{
+	bool isChanged;
+	int segment = materialRamp.advance(numSamples, isChanged);
+	if (isChanged)
+		computeVolumeCoefficients(volume, materialRamp.getOffset(), coefficients);
+	return segment;
+}
+
+void VolumeSolver::waitBarrier()
+{
+	int generation = barrierGeneration.load(std::memory_order_acquire);
+
+	//Last thread to arrive releases the others//
+	if (barrierCount.fetch_add(1, std::memory_order_acq_rel) == numThreads - 1)
+	{
+		barrierCount.store(0, std::memory_order_relaxed);
+		barrierGeneration.fetch_add(1, std::memory_order_release);
+		return;
+	}
+
+	int spins = 0;
+	while (barrierGeneration.load(std::memory_order_acquire) == generation)
+	{
+		if (++spins > BARRIER_SPINS)
+			std::this_thread::yield();
+	}
+}
+
+void VolumeSolver::workerLoop(int thread)
+{
+	TRACE_THREAD_NAME("Volume worker");
+
+	int seenGeneration = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(jobMutex);
+			jobCondition.wait(lock, [&]() { return isShuttingDown || jobGeneration != seenGeneration; });
+			if (isShuttingDown)
+				return;
+			seenGeneration = jobGeneration;
+		}
+		runBand(thread);
+	}
+}
+
+void VolumeSolver::runBand(int thread)
+{
+	TRACE_SCOPE("simulate-band");
+
+	//Copy the job before the first barrier - Once past the last barrier the calling thread may already be posting the next one//
+	const float* excitation = jobExcitation;
+	float* output = jobOutput;
+	int numSamples = jobNumSamples;
+	int plane = jobStartPlane;
+	int sampleOffset = jobSampleOffset;
+
+	//Excitation is added by the thread computing its row, before the barrier publishes the step//
+	int excitationRow = (excitationIndex / width) % height;
+	bool isExcitationOwner = (excitationRow >= bandBegin[thread] && excitationRow < bandBegin[thread + 1]) ||
+		(thread == 0 && (excitationRow < bandBegin[0] || excitationRow >= bandBegin[numThreads]));
+
+	for (int n = 0; n != numSamples; ++n)
+	{
+		const float* current = &pressure[plane][0];
+		float* next = &pressure[1 - plane][0];
+
+		computeBand(current, next, bandBegin[thread], bandBegin[thread + 1]);
+		if (isExcitationOwner)
+			next[excitationIndex] += excitation[n];
+
+		waitBarrier();
+
+		//Step complete - Silence boundaries, as the fbo shader does//
+		if (thread == 0)
+		{
+			output[n] = next[listenerIndex] * getTransmission(volume.cellTypes[listenerIndex]);
+			for (size_t p = 0; p != probeIndices.size(); ++p)
+				probeSamples[p][sampleOffset + n] = next[probeIndices[p]] * getTransmission(volume.cellTypes[probeIndices[p]]);
+		}
+
+		plane = 1 - plane;
+	}
+}
+
+void VolumeSolver::process(const float* excitation, float* output, int numSamples)
+{
+	for (size_t p = 0; p != probeSamples.size(); ++p)
+		probeSamples[p].resize(numSamples);
+
+	//Workers only ever see jobs with steps in them - An empty job could be missed and run twice//
+	if (numSamples == 0)
+		return;
+
+	StageTimer simulateStageTimer;
+	TRACE_SCOPE("simulate");
+
+	//A job per segment of the material glide - Coefficients only change between jobs, while workers wait//
+	int n = 0;
+	while (n != numSamples)
+	{
+		int segment = rampMaterial(numSamples - n);
+		{
+			std::lock_guard<std::mutex> lock(jobMutex);
+			jobExcitation = excitation + n;
+			jobOutput = output + n;
+			jobNumSamples = segment;
+			jobStartPlane = currentPlane;
+			jobSampleOffset = n;
+			++jobGeneration;
+		}
+		jobCondition.notify_all();
+
+		//Calling thread works the first band - Returns once the final step's barrier is passed by every thread//
+		runBand(0);
+
+		currentPlane = (currentPlane + segment) % 2;
+		n += segment;
+	}
+	profiler.recordCPU(STAGE_SIMULATE, simulateStageTimer.elapsed());
+}
+
+void VolumeSolver::setExcitationPosition(float x, float y)
+{
+	int cellX = std::min(std::max((int)(x * width), 0), width - 1);
+	int cellY = std::min(std::max((int)(y * height), 0), height - 1);
+	int cellZ = std::min(std::max((int)(settings.excitationLayer * depth), 0), depth - 1);
+	excitationIndex = (cellZ * height + cellY) * width + cellX;
+}
+
+void VolumeSolver::setMaterial(float propagation, float damping, float boundaryGain)
+{
+	materialRamp.setTarget(propagation, damping, boundaryGain);
+}
+
+double VolumeSolver::getEnergy()
+{
+	return computeVolumeEnergy(volume, &pressure[currentPlane][0], &pressure[1 - currentPlane][0]);
+}
+
+void VolumeSolver::getField(float* field)
+{
+	const float* current = &pressure[currentPlane][listenerLayer * layerSize];
+	const float* previous = &pressure[1 - currentPlane][listenerLayer * layerSize];
+	const uint8_t* cellTypes = &volume.cellTypes[listenerLayer * layerSize];
+	for (int i = 0; i != layerSize; ++i)
+	{
+		field[i * 4 + 0] = current[i];
+		field[i * 4 + 1] = previous[i];
+		field[i * 4 + 2] = getTransmission(cellTypes[i]);
+		field[i * 4 + 3] = cellTypes[i];
+	}
+}
+
+void VolumeSolver::setField(const float* field)
+{
+	//Floor and ceiling stay walls whatever the field says//
+	float* current = &pressure[currentPlane][listenerLayer * layerSize];
+	float* previous = &pressure[1 - currentPlane][listenerLayer * layerSize];
+	uint8_t* cellTypes = &volume.cellTypes[listenerLayer * layerSize];
+	bool isInterior = listenerLayer > 0 && listenerLayer < depth - 1;
+	for (int i = 0; i != layerSize; ++i)
+	{
+		current[i] = field[i * 4 + 0];
+		previous[i] = field[i * 4 + 1];
+		if (isInterior)
+			cellTypes[i] = (uint8_t)field[i * 4 + 3];
+	}
+	computeVolumeCoefficients(volume, materialRamp.getOffset(), coefficients);
+}
+
+int VolumeSolver::addProbe(int x, int y, int z)
+{
+	if (x < 0 || y < 0 || z < 0 || x >= width || y >= height || z >= depth)
+		return -1;
+	probeIndices.push_back((z * height + y) * width + x);
+	probeSamples.push_back(std::vector<float>());
+	return (int)probeIndices.size() - 1;
+}
+
+const std::vector<float>& VolumeSolver::getProbeSamples(int probe) const
+{
+	return probeSamples[probe];
+}
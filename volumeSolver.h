@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "solver.h"
+#include "volume.h"
+#include "materialRamp.h"
+
+///////////
+//DEFINES//
+///////////
+
+#define VOLUME_SLAB_ROWS	8		//Rows of a slab streamed through every layer before moving on - Three layers of a slab stay in cache as it advances.
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+//VolumeSolver - 7 point FDTD over a Volume, for rooms and resonant bodies. Pressure is a pair//
+//of planes updated in place like CPUSolver's, computed 4 voxels at a time with SSE. Rather  //
+//than sweeping whole layers, a step streams slabs of VOLUME_SLAB_ROWS rows up through the   //
+//layers, so each voxel is fetched from memory once and reused by the layers either side     //
+//while cached. Rows are split into bands across a pool of worker threads that meet at a     //
+//spin barrier after every step, as ThreadedSolver's do. Probes record extra listener voxels.//
+//getField() and setField() see the listener's layer, as a Domain sized field.               //
+////////////////////////////////////////////////////////////////////////////////////////////////
+class VolumeSolver : public Solver {
+private:
+	SolverSettings settings;
+	Volume volume;
+	UpdateCoefficients coefficients;	//Per voxel update of volume - Recomputed whenever material changes.
+	MaterialRamp materialRamp;
+	int width;
+	int height;
+	int depth;
+	int layerSize;						//Voxels per layer - Offset to the voxel above.
+
+	std::vector<float> pressure[2];		//Pressure volumes - Alternately hold timestep n & n-1.
+	int currentPlane = 0;
+	int excitationIndex;
+	int listenerIndex;
+	int listenerLayer;
+
+	std::vector<int> probeIndices;
+	std::vector<std::vector<float> > probeSamples;	//Each probe's samples of the last process() call.
+
+	//Worker pool//
+	int numThreads;
+	std::vector<std::thread> workers;
+	std::vector<int> bandBegin;			//First row of each thread's band - numThreads + 1 entries.
+
+	std::mutex jobMutex;
+	std::condition_variable jobCondition;
+	int jobGeneration = 0;
+	bool isShuttingDown = false;
+	const float* jobExcitation = NULL;
+	float* jobOutput = NULL;
+	int jobNumSamples = 0;
+	int jobStartPlane = 0;
+	int jobSampleOffset = 0;			//Sample of the process() call the job starts at, for probes.
+
+	std::atomic<int> barrierCount;
+	std::atomic<int> barrierGeneration;
+
+	//Compute next timestep of rows [rowBegin, rowEnd) of every interior layer, writing over previous timestep in place//
+	void computeBand(const float* current, float* previous, int rowBegin, int rowEnd);
+
+	//Scalar update of voxels [xBegin, xEnd) of row y of layer z - Also used for the tails the SSE kernel can't cover//
+	void computeSpan(const float* current, float* previous, int z, int y, int xBegin, int xEnd);
+
+	//Glide material over the next steps of a block of numSamples, recomputing coefficients if it moved - Returns the steps to run before calling again//
+	int rampMaterial(int numSamples);
+
+	void waitBarrier();
+	void workerLoop(int thread);
+
+	//Compute the thread's band for every step of the current job//
+	void runBand(int thread);
+
+public:
+	//0 threads uses every hardware thread//
+	VolumeSolver(const SolverSettings& aSettings, int aNumThreads = 1);
+	~VolumeSolver();
+
+	const char* getName() const;
+	void process(const float* excitation, float* output, int numSamples);
+	void setExcitationPosition(float x, float y);
+	void setMaterial(float propagation, float damping, float boundaryGain);
+	double getEnergy();
+	void getField(float* field);
+	void setField(const float* field);
+
+	//Record voxel (x, y, z) alongside the listener from the next process() call - Returns the probe's index, -1 outside the volume//
+	int addProbe(int x, int y, int z);
+
+	//Samples of a probe over the last process() call//
+	const std::vector<float>& getProbeSamples(int probe) const;
+};